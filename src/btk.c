@@ -13,6 +13,7 @@
 #include "ctrl_mods/btk_privkey.h"
 #include "ctrl_mods/btk_pubkey.h"
 #include "ctrl_mods/btk_vanity.h"
+#include "ctrl_mods/btk_address.h"
 #include "ctrl_mods/btk_node.h"
 #include "ctrl_mods/btk_utxodb.h"
 #include "ctrl_mods/btk_addressdb.h"
@@ -89,6 +90,10 @@ int main(int argc, char *argv[])
 		{
 			r = btk_vanity_main();
 		}
+		else if (strcmp(command, "address") == 0)
+		{
+			r = btk_address_main();
+		}
 		else if (strcmp(command, "node") == 0)
 		{
 			r = btk_node_main();
@@ -121,7 +126,7 @@ int main(int argc, char *argv[])
 			return EXIT_FAILURE;
 		}
 	}
-	while (input_available());
+	while (input_available() > 0);
 
 	// Run cleanup function
 	r = btk_cleanup(command);
@@ -158,6 +163,10 @@ int btk_init(int argc, char *argv[])
 	{
 		r = btk_vanity_init(argc, argv);
 	}
+	else if (strcmp(command, "address") == 0)
+	{
+		r = btk_address_init(argc, argv);
+	}
 	else if (strcmp(command, "node") == 0)
 	{
 		r = btk_node_init(argc, argv);
@@ -210,6 +219,10 @@ int btk_cleanup(char *command)
 	{
 		r = btk_vanity_cleanup();
 	}
+	else if (strcmp(command, "address") == 0)
+	{
+		r = btk_address_cleanup();
+	}
 	else if (strcmp(command, "node") == 0)
 	{
 		r = btk_node_cleanup();
@@ -0,0 +1,465 @@
+/*
+ * Copyright (c) 2017 Brian Barto
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GPL License. See LICENSE for more details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+#include "mods/network.h"
+#include "mods/pubkey.h"
+#include "mods/base58check.h"
+#include "mods/bech32.h"
+#include "mods/hex.h"
+#include "mods/input.h"
+#include "mods/error.h"
+
+#define TYPE_INVALID            0
+#define TYPE_P2PKH              1
+#define TYPE_P2SH               2
+#define TYPE_P2WPKH             3
+#define TYPE_P2WSH              4
+#define TYPE_WITNESS            5
+#define TYPE_HASH160            6
+#define TYPE_BASE58             7
+#define OUTPUT_SAME             1
+#define OUTPUT_ADDRESS          2
+#define OUTPUT_BECH32_ADDRESS   3
+#define OUTPUT_HEX              4
+#define OUTPUT_MAINNET          1
+#define OUTPUT_TESTNET          2
+#define TRUE                    1
+#define FALSE                   0
+#define OUTPUT_BUFFER           150
+#define ADDRESS_BATCH           256
+#define ADDRESS_LINE_MAX        128
+#define ADDRESS_PAYLOAD_LENGTH  21
+#define VERSION_P2PKH_MAINNET   0x00
+#define VERSION_P2PKH_TESTNET   0x6F
+#define VERSION_P2SH_MAINNET    0x05
+#define VERSION_P2SH_TESTNET    0xC4
+#define BECH32_START_MAINNET    "bc1"
+#define BECH32_START_TESTNET    "tb1"
+
+#define OUTPUT_SET(x)           if (output_format == FALSE) { output_format = x; } else { error_log("Cannot use multiple output format flags."); return -1; }
+
+struct BtkAddress
+{
+	char str[ADDRESS_LINE_MAX];
+	int type;
+	int testnet;
+	int version;
+	size_t len;
+	unsigned char program[BECH32_PROGRAM_MAX];
+};
+
+static int output_format        = FALSE;
+static int output_network       = FALSE;
+
+static void btk_address_parse(struct BtkAddress *);
+static int btk_address_print(struct BtkAddress *);
+static int btk_address_to_base58(char *, struct BtkAddress *);
+static int btk_address_to_bech32(char *, struct BtkAddress *);
+
+int btk_address_init(int argc, char *argv[])
+{
+	int o;
+	char *command = NULL;
+
+	command = argv[1];
+
+	while ((o = getopt(argc, argv, "ABHTM")) != -1)
+	{
+		switch (o)
+		{
+			// Output format
+			case 'A':
+				OUTPUT_SET(OUTPUT_ADDRESS);
+				break;
+			case 'B':
+				OUTPUT_SET(OUTPUT_BECH32_ADDRESS);
+				break;
+			case 'H':
+				OUTPUT_SET(OUTPUT_HEX);
+				break;
+
+			// Network Option
+			case 'T':
+				output_network = OUTPUT_TESTNET;
+				break;
+			case 'M':
+				output_network = OUTPUT_MAINNET;
+				break;
+
+			// Unknown option
+			case '?':
+				error_log("See 'btk help %s' to read about available argument options.", command);
+				if (isprint(optopt))
+				{
+					error_log("Invalid command option or argument required: '-%c'.", optopt);
+				}
+				else
+				{
+					error_log("Invalid command option character '\\x%x'.", optopt);
+				}
+				return -1;
+		}
+	}
+
+	if (output_format == FALSE)
+	{
+		output_format = OUTPUT_SAME;
+	}
+
+	return 1;
+}
+
+int btk_address_main(void)
+{
+	int r;
+	size_t i, j, n, m;
+	char *input;
+	char *base58[ADDRESS_BATCH];
+	int valid[ADDRESS_BATCH];
+	unsigned char payloads[ADDRESS_BATCH * ADDRESS_PAYLOAD_LENGTH];
+	struct BtkAddress *addresses;
+
+	addresses = malloc(sizeof(struct BtkAddress) * ADDRESS_BATCH);
+	if (addresses == NULL)
+	{
+		error_log("Memory allocation error.");
+		return -1;
+	}
+
+	// Piped input can hold millions of addresses. Read as many as are
+	// waiting (up to ADDRESS_BATCH) so that the checksums of the base58
+	// ones are verified together. Empty lines are kept, so that every
+	// output line matches its input line.
+	n = 0;
+	if (isatty(STDIN_FILENO))
+	{
+		r = input_get_str(&input, NULL);
+		if (r < 0)
+		{
+			error_log("Could not get input.");
+			free(addresses);
+			return -1;
+		}
+
+		strncpy(addresses[n].str, input, ADDRESS_LINE_MAX - 1);
+		addresses[n].str[ADDRESS_LINE_MAX - 1] = '\0';
+		++n;
+
+		free(input);
+	}
+	else
+	{
+		while (n < ADDRESS_BATCH && (n == 0 || input_available() > 0))
+		{
+			r = input_get_line(addresses[n].str, ADDRESS_LINE_MAX);
+			if (r < 0)
+			{
+				error_log("Could not get input.");
+				free(addresses);
+				return -1;
+			}
+			if (r == 0)
+			{
+				break;
+			}
+
+			++n;
+		}
+	}
+
+	// Bech32 and hex input is checked right away. Everything else has to
+	// be base58 and is collected for a single batch decode.
+	for (i = 0, m = 0; i < n; ++i)
+	{
+		btk_address_parse(&addresses[i]);
+		if (addresses[i].type == TYPE_BASE58)
+		{
+			base58[m++] = addresses[i].str;
+		}
+	}
+
+	if (m > 0)
+	{
+		r = base58check_decode_batch(payloads, valid, base58, m, ADDRESS_PAYLOAD_LENGTH);
+		if (r < 0)
+		{
+			error_log("Could not decode base58 addresses.");
+			free(addresses);
+			return -1;
+		}
+
+		for (i = 0, j = 0; i < n; ++i)
+		{
+			if (addresses[i].type != TYPE_BASE58)
+			{
+				continue;
+			}
+
+			addresses[i].type = TYPE_INVALID;
+			if (valid[j])
+			{
+				switch (payloads[j * ADDRESS_PAYLOAD_LENGTH])
+				{
+					case VERSION_P2PKH_MAINNET:
+					case VERSION_P2PKH_TESTNET:
+						addresses[i].type = TYPE_P2PKH;
+						break;
+					case VERSION_P2SH_MAINNET:
+					case VERSION_P2SH_TESTNET:
+						addresses[i].type = TYPE_P2SH;
+						break;
+				}
+				addresses[i].testnet = (payloads[j * ADDRESS_PAYLOAD_LENGTH] == VERSION_P2PKH_TESTNET || payloads[j * ADDRESS_PAYLOAD_LENGTH] == VERSION_P2SH_TESTNET);
+				addresses[i].len = ADDRESS_PAYLOAD_LENGTH - 1;
+				memcpy(addresses[i].program, payloads + (j * ADDRESS_PAYLOAD_LENGTH) + 1, ADDRESS_PAYLOAD_LENGTH - 1);
+			}
+
+			++j;
+		}
+	}
+
+	for (i = 0; i < n; ++i)
+	{
+		r = btk_address_print(&addresses[i]);
+		if (r < 0)
+		{
+			error_log("Could not print address.");
+			free(addresses);
+			return -1;
+		}
+	}
+
+	free(addresses);
+
+	return 1;
+}
+
+int btk_address_cleanup(void)
+{
+	return 1;
+}
+
+static void btk_address_parse(struct BtkAddress *address)
+{
+	int r;
+	size_t i, len;
+
+	address->type = TYPE_INVALID;
+	address->testnet = FALSE;
+	address->version = 0;
+	address->len = 0;
+
+	len = strlen(address->str);
+	if (len == 0)
+	{
+		return;
+	}
+
+	// A hash160 in hex
+	if (len == 40)
+	{
+		for (i = 0; i < len && hex_ischar(address->str[i]); ++i)
+			;
+		if (i == len)
+		{
+			r = hex_str_to_raw(address->program, address->str);
+			if (r < 0)
+			{
+				error_clear();
+				return;
+			}
+			address->type = TYPE_HASH160;
+			address->len = 20;
+			return;
+		}
+	}
+
+	// A bech32 address. The decoder sets the network from its prefix.
+	// Anything else has to be base58.
+	if (strncasecmp(address->str, BECH32_START_MAINNET, strlen(BECH32_START_MAINNET)) == 0 || strncasecmp(address->str, BECH32_START_TESTNET, strlen(BECH32_START_TESTNET)) == 0)
+	{
+		r = bech32_get_program(address->program, &address->version, address->str);
+		if (r < 0)
+		{
+			// A bad address is reported in the output, not as an error.
+			error_clear();
+			return;
+		}
+
+		address->len = (size_t)r;
+		address->testnet = network_is_test();
+		if (address->version == 0 && address->len == 20)
+		{
+			address->type = TYPE_P2WPKH;
+		}
+		else if (address->version == 0 && address->len == 32)
+		{
+			address->type = TYPE_P2WSH;
+		}
+		else
+		{
+			address->type = TYPE_WITNESS;
+		}
+	}
+	else
+	{
+		address->type = TYPE_BASE58;
+	}
+}
+
+static int btk_address_print(struct BtkAddress *address)
+{
+	int r, format;
+	char output[OUTPUT_BUFFER];
+
+	if (address->type == TYPE_INVALID)
+	{
+		printf("invalid\n");
+		return 1;
+	}
+
+	switch (output_network)
+	{
+		case FALSE:
+			if (address->testnet)
+			{
+				network_set_test();
+			}
+			else
+			{
+				network_set_main();
+			}
+			break;
+		case OUTPUT_MAINNET:
+			network_set_main();
+			break;
+		case OUTPUT_TESTNET:
+			network_set_test();
+			break;
+	}
+
+	// Without an output option each address keeps its own format.
+	format = output_format;
+	if (format == OUTPUT_SAME)
+	{
+		switch (address->type)
+		{
+			case TYPE_P2PKH:
+			case TYPE_P2SH:
+				format = OUTPUT_ADDRESS;
+				break;
+			case TYPE_HASH160:
+				format = OUTPUT_HEX;
+				break;
+			default:
+				format = OUTPUT_BECH32_ADDRESS;
+				break;
+		}
+	}
+
+	memset(output, 0, OUTPUT_BUFFER);
+
+	switch (format)
+	{
+		case OUTPUT_ADDRESS:
+			r = btk_address_to_base58(output, address);
+			if (r < 0)
+			{
+				error_log("Could not calculate address.");
+				return -1;
+			}
+			break;
+		case OUTPUT_BECH32_ADDRESS:
+			r = btk_address_to_bech32(output, address);
+			if (r < 0)
+			{
+				error_log("Could not calculate bech32 address.");
+				return -1;
+			}
+			break;
+		case OUTPUT_HEX:
+			r = hex_encode(output, address->program, address->len);
+			break;
+		default:
+			r = 0;
+			break;
+	}
+
+	// Valid, but with no equivalent in the requested format.
+	if (r == 0)
+	{
+		printf("unsupported\n");
+		return 1;
+	}
+
+	printf("%s\n", output);
+
+	return 1;
+}
+
+// Returns 0 when the address has no base58 form.
+static int btk_address_to_base58(char *output, struct BtkAddress *address)
+{
+	int r;
+	unsigned char payload[ADDRESS_PAYLOAD_LENGTH];
+
+	switch (address->type)
+	{
+		case TYPE_P2PKH:
+		case TYPE_P2WPKH:
+		case TYPE_HASH160:
+			r = pubkey_hash160_to_address(output, address->program);
+			if (r < 0)
+			{
+				error_log("Could not generate address from hash160.");
+				return -1;
+			}
+			return 1;
+		case TYPE_P2SH:
+			payload[0] = network_is_test() ? VERSION_P2SH_TESTNET : VERSION_P2SH_MAINNET;
+			memcpy(payload + 1, address->program, ADDRESS_PAYLOAD_LENGTH - 1);
+			r = base58check_encode(output, payload, ADDRESS_PAYLOAD_LENGTH);
+			if (r < 0)
+			{
+				error_log("Could not generate address from script hash.");
+				return -1;
+			}
+			return 1;
+	}
+
+	return 0;
+}
+
+// Returns 0 when the address has no bech32 form.
+static int btk_address_to_bech32(char *output, struct BtkAddress *address)
+{
+	int r;
+
+	switch (address->type)
+	{
+		case TYPE_P2PKH:
+		case TYPE_P2WPKH:
+		case TYPE_HASH160:
+		case TYPE_P2WSH:
+		case TYPE_WITNESS:
+			r = bech32_get_witness_address(output, address->version, address->program, address->len);
+			if (r < 0)
+			{
+				error_log("Could not generate bech32 address from witness program.");
+				return -1;
+			}
+			return 1;
+	}
+
+	return 0;
+}
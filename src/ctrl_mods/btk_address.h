@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2017 Brian Barto
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GPL License. See LICENSE for more details.
+ */
+
+#ifndef BTK_ADDRESS_H
+#define BTK_ADDRESS_H 1
+
+int btk_address_init(int argc, char *argv[]);
+int btk_address_main(void);
+int btk_address_cleanup(void);
+
+#endif
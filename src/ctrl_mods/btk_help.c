@@ -49,6 +49,10 @@ int btk_help_main(void)
 	{
 		btk_help_vanity();
 	}
+	else if (strcmp(command, "address") == 0)
+	{
+		btk_help_address();
+	}
 	else if (strcmp(command, "version") == 0)
 	{
 		btk_help_version();
@@ -77,6 +81,7 @@ void btk_help_commands(void)
 	printf("   privkey      create, modify, and format private keys.\n");
 	printf("   pubkey       calculate and format public keys from private keys.\n");
 	printf("   vanity       generate a vanity address.\n");
+	printf("   address      validate and convert bitcoin addresses.\n");
 	printf("   node         interface with a bitcoin node.\n");
 	printf("   version      print btk version info.\n");
 	printf("\n");
@@ -348,19 +353,180 @@ void btk_help_vanity(void)
 	printf("   -B\n");
 	printf("      Match a (B)ech32 address.\n");
 	printf("\n");
+	printf("   -P\n");
+	printf("      Match a (P)ay-to-taproot address, encoded as bech32m. The private key\n");
+	printf("      found is the internal key of a BIP86 key path only output, and is\n");
+	printf("      printed with its tr() descriptor. Only a single match string is\n");
+	printf("      supported.\n");
+	printf("\n");
+	printf("   --untweaked\n");
+	printf("      With -P, put the public key itself in the address instead of its\n");
+	printf("      taproot tweaked key. This skips all hashing, so it is faster, but the\n");
+	printf("      address can only be spent with a rawtr() descriptor.\n");
+	printf("\n");
 	printf("   -C\n");
 	printf("      Match a (C)ompressed address. (default)\n");
 	printf("\n");
 	printf("   -U\n");
 	printf("      Match an (U)ncompressed address. Note that this option is not allowed for\n");
-	printf("      bech32 addresses.\n");
+	printf("      bech32 or taproot addresses.\n");
 	printf("\n");
 	printf("   -T\n");
 	printf("      Generate a TESTNET address.\n");
 	printf("\n");
 	printf("   -i\n");
 	printf("      Perform a case (i)nsensitive match. Note that this option is not useful\n");
-	printf("      for bech32 addresses as all characters are lowercase.\n");
+	printf("      for bech32 addresses as all characters are lowercase. Prefixes can have\n");
+	printf("      at most 12 letters that exist in both cases. Suffixes and positions\n");
+	printf("      are not limited.\n");
+	printf("\n");
+	printf("   -S\n");
+	printf("      Exploit the (S)ymmetries of each public key. Besides the key itself,\n");
+	printf("      its negation and both secp256k1 endomorphism images are checked, in\n");
+	printf("      both compressed and uncompressed form unless -C or -U is given. This\n");
+	printf("      checks up to 12 addresses for each point calculated. The transform\n");
+	printf("      that produced a match is printed along with its private key.\n");
+	printf("\n");
+	printf("   -E\n");
+	printf("      Match the input string at the (E)nd of a base58 address instead of at\n");
+	printf("      its start.\n");
+	printf("\n");
+	printf("   -p <position>\n");
+	printf("      Match the input string starting at this (p)osition of the address.\n");
+	printf("      Positions count address characters from 1, including the static ones\n");
+	printf("      at the start. Bech32 patterns must end before the checksum, the last\n");
+	printf("      6 characters.\n");
+	printf("\n");
+	printf("   -f <file>\n");
+	printf("      Search for every pattern listed in (f)ile instead of reading a single\n");
+	printf("      match string from standard input. Each line holds the start of an\n");
+	printf("      address, including its leading static characters (like '1Brand' or\n");
+	printf("      'bc1qbrand'). A line starting with '*' holds the end of a base58\n");
+	printf("      address instead. Empty lines and lines starting with '#' are ignored.\n");
+	printf("      Every key found is printed along with the pattern it matched, and the\n");
+	printf("      search ends once each pattern has been found. Without --seed, each key\n");
+	printf("      found comes from a fresh random key, so the keys are unrelated.\n");
+	printf("\n");
+	printf("   -j <threads>\n");
+	printf("      Run the search in this many worker threads. Each thread searches its\n");
+	printf("      own range of keys. Defaults to the number of online processors.\n");
+	printf("\n");
+	printf("   --seed <hex>\n");
+	printf("      Count up from this 64 character hexadecimal private key instead of a\n");
+	printf("      random one. The keyspace after the seed is searched in fixed size\n");
+	printf("      chunks. All keys found from one seed are close to it, so anyone who\n");
+	printf("      holds one of them can work out the others. Never hand keys found from\n");
+	printf("      the same seed to different people. The same goes for --checkpoint and\n");
+	printf("      for a coordinator and its workers, which also count up from one seed.\n");
+	printf("\n");
+	printf("   --part <i/n>\n");
+	printf("      Only search part i of n of the keyspace, by taking every n-th chunk.\n");
+	printf("      Machines given the same seed and different parts never search the\n");
+	printf("      same keys.\n");
+	printf("\n");
+	printf("   --checkpoint <file>\n");
+	printf("      Save the seed, part and search position to file every minute and when\n");
+	printf("      the search ends. The file must not exist yet. It holds the seed key,\n");
+	printf("      so keep it private.\n");
+	printf("\n");
+	printf("   --resume <file>\n");
+	printf("      Continue a search saved with --checkpoint, and keep saving to the same\n");
+	printf("      file. The patterns and other options must be given again.\n");
+	printf("\n");
+	printf("   --stats-fd <fd>\n");
+	printf("      Write search progress to the open file descriptor fd once a second, as\n");
+	printf("      one line of JSON each. Fields are elapsed seconds, candidates and keys\n");
+	printf("      checked, rate in candidates per second, patterns found and total,\n");
+	printf("      probability that one candidate matches a remaining pattern, eta in\n");
+	printf("      expected seconds to the next match, and success, the chance that a\n");
+	printf("      match would have turned up by now.\n");
+	printf("\n");
+	printf("   --split <pubkey>\n");
+	printf("      Search for a vanity address on behalf of someone else, without ever\n");
+	printf("      knowing its private key. pubkey is their public key in hex. The search\n");
+	printf("      finds a tweak t such that pubkey + t * G has a matching address, and\n");
+	printf("      prints t in hex. The private key of the address is their private key\n");
+	printf("      plus t, modulo the curve order. This option can not be used with -S.\n");
+	printf("\n");
+	printf("   --coordinator <port>\n");
+	printf("      Coordinate a search spread over several machines. The coordinator\n");
+	printf("      listens on port for workers, hands out units of the keyspace as they\n");
+	printf("      ask, and shows their combined progress. Give it the same match string\n");
+	printf("      and options as the workers, so it can check every key they report.\n");
+	printf("      Once every pattern has been found it prints the keys and stops all\n");
+	printf("      workers. Units of a worker that goes away are handed out again. It\n");
+	printf("      only listens on localhost unless --bind-any is given. Requires --secret.\n");
+	printf("\n");
+	printf("   --worker <host:port>\n");
+	printf("      Search for the coordinator at host:port, with all threads of this\n");
+	printf("      machine. Give the match string and options as usual. Workers searching\n");
+	printf("      for anything else are turned away. Workers don't need a terminal.\n");
+	printf("      Requires --secret.\n");
+	printf("\n");
+	printf("   --secret <file>\n");
+	printf("      Read the secret shared by a coordinator and its workers from the first\n");
+	printf("      line of file. Only workers that know it may join. The secret also\n");
+	printf("      masks the seed on the wire, and found keys are reported as positions\n");
+	printf("      in the keyspace, so no private key is ever sent. Anyone who knows the\n");
+	printf("      secret and can watch the traffic can still work out every key found,\n");
+	printf("      so use a long random secret and keep the file private.\n");
+	printf("\n");
+	printf("   --bind-any\n");
+	printf("      Let the coordinator listen on all addresses, for workers on other\n");
+	printf("      machines. The connection is not encrypted. Only use this on a network\n");
+	printf("      you trust, or tunnel the port over ssh instead.\n");
+	printf("\n");
+	printf("See https://github.com/bartobri/bitcoin-toolkit for examples.\n");
+	printf("See 'btk help' to read about other commands.\n");
+	printf("\n");
+}
+
+void btk_help_address(void)
+{
+	printf("COMMAND\n");
+	printf("\n");
+	printf("   address - validate and convert bitcoin addresses.\n");
+	printf("\n");
+	printf("SYNOPSIS\n");
+	printf("\n");
+	printf("   btk address [OUTPUT_OPTIONS]\n");
+	printf("\n");
+	printf("DESCRIPTION\n");
+	printf("\n");
+	printf("   The address command reads addresses from standard input, one per line,\n");
+	printf("   and prints one line for each of them in the same order. Input can be a\n");
+	printf("   traditional P2PKH or P2SH address, a bech32 address, or a 40 character\n");
+	printf("   hexadecimal hash160. An empty line is printed as \"invalid\".\n");
+	printf("\n");
+	printf("   Each valid address is printed in the format specified by the output\n");
+	printf("   option. If no output option is specified, it keeps its own format, with\n");
+	printf("   bech32 addresses in lowercase. An address that fails validation is printed\n");
+	printf("   as \"invalid\". A valid address that has no equivalent in the requested\n");
+	printf("   format, like a P2SH address in bech32, is printed as \"unsupported\".\n");
+	printf("\n");
+	printf("   See OUTPUT OPTIONS for more info.\n");
+	printf("\n");
+	printf("OUTPUT OPTIONS\n");
+	printf("\n");
+	printf("   -A\n");
+	printf("      Print a traditional bitcoin (A)ddress. A hash160, or the program of a\n");
+	printf("      P2WPKH address, becomes a P2PKH address. P2SH addresses stay P2SH.\n");
+	printf("\n");
+	printf("   -B\n");
+	printf("      Print a (B)ech32 address. A hash160, or the hash of a P2PKH address,\n");
+	printf("      becomes a P2WPKH address.\n");
+	printf("\n");
+	printf("   -H\n");
+	printf("      Print the hash160, script hash or witness program in (H)exadecimal\n");
+	printf("      format.\n");
+	printf("\n");
+	printf("   -T\n");
+	printf("      Print addresses for the (T)ESTNET network. Without -T or -M, each\n");
+	printf("      address keeps the network of its input. A hash160 has no network and\n");
+	printf("      is treated as MAINNET.\n");
+	printf("\n");
+	printf("   -M\n");
+	printf("      Print addresses for the (M)AINNET network.\n");
 	printf("\n");
 	printf("See https://github.com/bartobri/bitcoin-toolkit for examples.\n");
 	printf("See 'btk help' to read about other commands.\n");
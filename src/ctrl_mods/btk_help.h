@@ -15,6 +15,7 @@ void btk_help_commands(void);
 void btk_help_privkey(void);
 void btk_help_pubkey(void);
 void btk_help_vanity(void);
+void btk_help_address(void);
 void btk_help_node(void);
 void btk_help_version(void);
 
@@ -35,8 +35,11 @@
 #define TRUE                    1
 #define FALSE                   0
 #define OUTPUT_BUFFER           150
+#define PUBKEY_BATCH            256
 
 #define INPUT_SET(x)            if (input_format == FALSE) { input_format = x; } else { error_log("Cannot use multiple input format flags."); return -1; }
+#define BTK_PUBKEY_INPUT_IS_LINE(x) (x == INPUT_WIF || x == INPUT_HEX || x == INPUT_STR || x == INPUT_DEC || x == INPUT_SBD)
+
 #define OUTPUT_SET(x)           if (output_format == FALSE) { output_format = x; } else { error_log("Cannot use multiple output format flags."); return -1; }
 #define COMPRESSION_SET(x)      if (output_compression == FALSE) { output_compression = x; } else { error_log("Only specify one compression flag."); return -1; }
 
@@ -47,6 +50,10 @@ static int output_privkey       = FALSE;
 static int output_newline       = TRUE;
 static int output_network       = FALSE;
 
+static int btk_pubkey_get_privkey(PrivKey);
+static int btk_pubkey_print(PubKey, PrivKey, unsigned char *);
+static void btk_pubkey_free_batch(PrivKey *, PubKey *, size_t);
+
 int btk_pubkey_init(int argc, char *argv[])
 {
 	int o;
@@ -150,23 +157,129 @@ int btk_pubkey_init(int argc, char *argv[])
 
 int btk_pubkey_main(void)
 {
-	int r;
-	PubKey key = NULL;
-	PrivKey priv = NULL;
-	size_t i;
-	unsigned char *input_uc;
-	char *input_sc;
-	size_t output_len;
-	char output[OUTPUT_BUFFER];
-	unsigned char uc_output[OUTPUT_BUFFER];
+	int r, e;
+	size_t i, n, m;
+	int testnet[PUBKEY_BATCH];
+	PubKey keys[PUBKEY_BATCH];
+	PrivKey privs[PUBKEY_BATCH];
+	unsigned char hashes[PUBKEY_BATCH * 20];
+
+	// Line oriented input can hold many private keys. Read as many as are
+	// waiting (up to PUBKEY_BATCH) so that their public keys are derived
+	// together and share a single field inversion.
+	e = 0;
+	n = 0;
+	do
+	{
+		privs[n] = malloc(privkey_sizeof());
+		keys[n] = malloc(pubkey_sizeof());
+		if (privs[n] == NULL || keys[n] == NULL)
+		{
+			free(privs[n]);
+			free(keys[n]);
+			btk_pubkey_free_batch(privs, keys, n);
+			error_log("Memory allocation error.");
+			return -1;
+		}
+
+		r = btk_pubkey_get_privkey(privs[n]);
+		if (r < 0)
+		{
+			// Keys read before the bad input still get printed.
+			free(privs[n]);
+			free(keys[n]);
+			e = 1;
+			break;
+		}
+
+		// WIF input sets the network, so remember it for each key.
+		testnet[n] = network_is_test();
+
+		++n;
+	}
+	while (n < PUBKEY_BATCH && BTK_PUBKEY_INPUT_IS_LINE(input_format) && input_available() > 0);
+
+	// Keys before one with no public key still get printed.
+	r = pubkey_get_batch(keys, privs, n);
+	if (r < 0)
+	{
+		btk_pubkey_free_batch(privs, keys, n);
+		error_log("Could not calculate public key.");
+		return -1;
+	}
+	m = (size_t)r;
+
+	// Addresses hash the keys, which is done for the whole batch at once.
+	if (output_format == OUTPUT_ADDRESS || output_format == OUTPUT_BECH32_ADDRESS)
+	{
+		r = pubkey_get_hash160_batch(hashes, keys, m);
+		if (r < 0)
+		{
+			btk_pubkey_free_batch(privs, keys, n);
+			error_log("Could not generate hash160 from public key data.");
+			return -1;
+		}
+	}
+
+	for (i = 0; i < m; ++i)
+	{
+		switch (output_network)
+		{
+			case FALSE:
+				if (testnet[i])
+				{
+					network_set_test();
+				}
+				else
+				{
+					network_set_main();
+				}
+				break;
+			case OUTPUT_MAINNET:
+				network_set_main();
+				break;
+			case OUTPUT_TESTNET:
+				network_set_test();
+				break;
+		}
+
+		r = btk_pubkey_print(keys[i], privs[i], hashes + (i * 20));
+		if (r < 0)
+		{
+			btk_pubkey_free_batch(privs, keys, n);
+			error_log("Could not print public key.");
+			return -1;
+		}
+	}
+
+	btk_pubkey_free_batch(privs, keys, n);
+
+	if (m < n)
+	{
+		error_log("Could not calculate public key.");
+		return -1;
+	}
 
-	priv = malloc(privkey_sizeof());
-	if (priv == NULL)
+	if (e)
 	{
-		error_log("Memory allocation error.");
+		error_log("Could not calculate private key from input.");
 		return -1;
 	}
-	
+
+	return 1;
+}
+
+int btk_pubkey_cleanup(void)
+{
+	return 1;
+}
+
+static int btk_pubkey_get_privkey(PrivKey key)
+{
+	int r;
+	unsigned char *input_uc;
+	char *input_sc;
+
 	switch (input_format)
 	{
 		case INPUT_WIF:
@@ -177,7 +290,7 @@ int btk_pubkey_main(void)
 				return -1;
 			}
 
-			r = privkey_from_wif(priv, input_sc);
+			r = privkey_from_wif(key, input_sc);
 			if (r < 0)
 			{
 				error_log("Could not calculate private key from input.");
@@ -194,7 +307,7 @@ int btk_pubkey_main(void)
 				return -1;
 			}
 
-			r = privkey_from_hex(priv, input_sc);
+			r = privkey_from_hex(key, input_sc);
 			if (r < 0)
 			{
 				error_log("Could not calculate private key from input.");
@@ -211,7 +324,7 @@ int btk_pubkey_main(void)
 				return -1;
 			}
 
-			r = privkey_from_raw(priv, input_uc, r);
+			r = privkey_from_raw(key, input_uc, r);
 			if (r < 0)
 			{
 				error_log("Could not calculate private key from input.");
@@ -228,7 +341,7 @@ int btk_pubkey_main(void)
 				return -1;
 			}
 
-			r = privkey_from_str(priv, input_sc);
+			r = privkey_from_str(key, input_sc);
 			if (r < 0)
 			{
 				error_log("Could not calculate private key from input.");
@@ -245,7 +358,7 @@ int btk_pubkey_main(void)
 				return -1;
 			}
 
-			r = privkey_from_dec(priv, input_sc);
+			r = privkey_from_dec(key, input_sc);
 			if (r < 0)
 			{
 				error_log("Could not calculate private key from input.");
@@ -262,7 +375,7 @@ int btk_pubkey_main(void)
 				return -1;
 			}
 
-			r = privkey_from_blob(priv, input_uc, r);
+			r = privkey_from_blob(key, input_uc, r);
 			if (r < 0)
 			{
 				error_log("Could not calculate private key from input.");
@@ -279,7 +392,7 @@ int btk_pubkey_main(void)
 				return -1;
 			}
 
-			r = privkey_from_sbd(priv, input_sc);
+			r = privkey_from_sbd(key, input_sc);
 			if (r < 0)
 			{
 				error_log("Could not calculate private key from input.");
@@ -296,7 +409,7 @@ int btk_pubkey_main(void)
 				return -1;
 			}
 
-			r = privkey_from_guess(priv, input_uc, r);
+			r = privkey_from_guess(key, input_uc, r);
 			if (r < 0)
 			{
 				error_log("Could not calculate private key from input.");
@@ -307,13 +420,7 @@ int btk_pubkey_main(void)
 			break;
 	}
 
-	if (!priv)
-	{
-		error_log("Could not calculate private key from input.");
-		return -1;
-	}
-	
-	if (privkey_is_zero(priv))
+	if (privkey_is_zero(key))
 	{
 		error_log("Key value cannot be zero.");
 		return -1;
@@ -324,38 +431,23 @@ int btk_pubkey_main(void)
 		case FALSE:
 			break;
 		case OUTPUT_COMPRESS:
-			privkey_compress(priv);
+			privkey_compress(key);
 			break;
 		case OUTPUT_UNCOMPRESS:
-			privkey_uncompress(priv);
+			privkey_uncompress(key);
 			break;
 	}
 
-	key = malloc(pubkey_sizeof());
-	if (key == NULL)
-	{
-		error_log("Memory allocation error");
-		return -1;
-	}
-
-	r = pubkey_get(key, priv);
-	if (r < 0)
-	{
-		error_log("Could not calculate public key.");
-		return -1;
-	}
+	return 1;
+}
 
-	switch (output_network)
-	{
-		case FALSE:
-			break;
-		case OUTPUT_MAINNET:
-			network_set_main();
-			break;
-		case OUTPUT_TESTNET:
-			network_set_test();
-			break;
-	}
+static int btk_pubkey_print(PubKey key, PrivKey priv, unsigned char *hash)
+{
+	int r;
+	size_t i;
+	size_t output_len;
+	char output[OUTPUT_BUFFER];
+	unsigned char uc_output[OUTPUT_BUFFER];
 
 	memset(output, 0, OUTPUT_BUFFER);
 	memset(uc_output, 0, OUTPUT_BUFFER);
@@ -404,7 +496,7 @@ int btk_pubkey_main(void)
 	switch (output_format)
 	{
 		case OUTPUT_ADDRESS:
-			r = pubkey_to_address(output, key);
+			r = pubkey_hash160_to_address(output, hash);
 			if (r < 0)
 			{
 				error_log("Could not calculate public key address.");
@@ -413,7 +505,12 @@ int btk_pubkey_main(void)
 			printf("%s", output);
 			break;
 		case OUTPUT_BECH32_ADDRESS:
-			r = pubkey_to_bech32address(output, key);
+			if (!pubkey_is_compressed(key))
+			{
+				error_log("Public key is uncompressed. Bech32 addresses require a compressed public key.");
+				return -1;
+			}
+			r = pubkey_hash160_to_bech32address(output, hash);
 			if (r < 0)
 			{
 				error_log("Could not calculate bech32 public key address.");
@@ -451,13 +548,16 @@ int btk_pubkey_main(void)
 			break;
 	}
 
-	free(priv);
-	free(key);
-
 	return 1;
 }
 
-int btk_pubkey_cleanup(void)
+static void btk_pubkey_free_batch(PrivKey *privs, PubKey *keys, size_t n)
 {
-	return 1;
+	size_t i;
+
+	for (i = 0; i < n; ++i)
+	{
+		free(privs[i]);
+		free(keys[i]);
+	}
 }
@@ -8,25 +8,68 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
+#include <getopt.h>
+#include <fcntl.h>
 #include <ctype.h>
 #include <time.h>
+#include <math.h>
+#include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include "mods/privkey.h"
 #include "mods/pubkey.h"
 #include "mods/network.h"
 #include "mods/base58.h"
 #include "mods/base32.h"
+#include "mods/hex.h"
 #include "mods/btktermio.h"
+#include "mods/vanity.h"
+#include "mods/vanitycoord.h"
+#include "mods/crypto.h"
 #include "mods/input.h"
 #include "mods/error.h"
 
 #define OUTPUT_ADDRESS          1
 #define OUTPUT_BECH32_ADDRESS   2
+#define OUTPUT_TAPROOT_ADDRESS  3
 #define OUTPUT_COMPRESS         1
 #define OUTPUT_UNCOMPRESS       2
 #define TRUE                    1
 #define FALSE                   0
 #define OUTPUT_BUFFER           150
+#define VANITY_THREADS_MAX      1024
+#define VANITY_RUNNING          0
+#define VANITY_FOUND            1
+#define VANITY_ERROR            -1
+#define VANITY_PATTERN_MAX      100
+#define VANITY_INPUT_MAX        32
+#define VANITY_ANCHOR_START     0
+#define VANITY_ANCHOR_AT        1
+#define VANITY_ANCHOR_END       2
+#define VANITY_MATCH_MAX        16
+#define VANITY_CHUNK_BATCHES    4096
+#define VANITY_CHUNK_KEYS       ((uint64_t)VANITY_CHUNK_BATCHES * PUBKEY_ITER_BATCH)
+#define VANITY_CHECKPOINT_SECS  60
+#define VANITY_STATE_LINE_MAX   200
+#define VANITY_STATS_SECS       1
+#define OPTION_SEED             256
+#define OPTION_PART             257
+#define OPTION_CHECKPOINT       258
+#define OPTION_RESUME           259
+#define OPTION_STATS_FD         260
+#define OPTION_UNTWEAKED        261
+#define OPTION_SPLIT            262
+#define OPTION_COORDINATOR      263
+#define OPTION_WORKER           264
+#define OPTION_SECRET           265
+#define OPTION_BIND_ANY         266
+#define VANITY_FINGERPRINT_LEN  8
+#define BECH32_START_MAINNET    "bc1q"
+#define BECH32_START_TESTNET    "tb1q"
+#define BECH32M_START_MAINNET   "bc1p"
+#define BECH32M_START_TESTNET   "tb1p"
 
 #define OUTPUT_SET(x)           if (output_format == FALSE) { output_format = x; } else { error_log("Only specify one output flag."); return -1; }
 #define COMPRESSION_SET(x)      if (output_compression == FALSE) { output_compression = x; } else { error_log("Only specify one compression flag."); return -1; }
@@ -35,15 +78,178 @@ static int input_insensitive    = FALSE;
 static int output_format        = FALSE;
 static int output_compression   = FALSE;
 static int output_testnet       = FALSE;
+static int input_symmetry       = FALSE;
+static int input_suffix         = FALSE;
+static int input_position       = 0;
+static int input_untweaked      = FALSE;
+static int worker_count         = 0;
+static char *pattern_file       = NULL;
+static char *seed_hex           = NULL;
+static char *part_str           = NULL;
+static char *state_file         = NULL;
+static int state_resume         = FALSE;
+static int stats_fd             = -1;
+static char *split_hex          = NULL;
+static int coordinator_port     = 0;
+static int coordinator_any      = FALSE;
+static char *worker_str         = NULL;
+static char *secret_file        = NULL;
+
+// Search state shared between the worker threads. chunk is the keyspace
+// chunk the worker is currently searching.
+typedef struct VanityWorker *VanityWorker;
+struct VanityWorker
+{
+	pthread_t thread;
+	atomic_ulong count;
+	atomic_ulong chunk;
+};
+
+// A pattern to search for. Prefixes and patterns anchored at a position
+// start offset characters into the address, suffix patterns end offset
+// characters before its end. Prefixes are matched through the range table
+// or the bech32 mask, base58 patterns elsewhere through their place.
+// probability is the chance that a single candidate matches.
+typedef struct VanityPattern *VanityPattern;
+struct VanityPattern
+{
+	char *str;
+	int format;
+	int offset;
+	int anchor;
+	int found;
+	VanityPlace place;
+	double probability;
+};
+
+// Search progress as sampled by the main thread. rate is in candidates
+// per second. probability is the chance that a single candidate matches
+// any pattern not found yet, and success the chance that one would have
+// been found among the candidates checked since the last hit.
+typedef struct VanityStats *VanityStats;
+struct VanityStats
+{
+	double elapsed;
+	unsigned long total;
+	unsigned long since;
+	double rate;
+	double probability;
+	double eta;
+	double success;
+	int found;
+	int patterns;
+};
+
+// A found key, waiting to be printed by the main thread. offset is how far
+// the iterator key is from the seed.
+typedef struct VanityHit *VanityHit;
+struct VanityHit
+{
+	int id;
+	int variant;
+	unsigned long offset;
+	char pubkey_str[OUTPUT_BUFFER];
+	char privkey_str[OUTPUT_BUFFER];
+};
+
+static VanityPattern patterns = NULL;
+static int pattern_count = 0;
+static VanityTable match_table = NULL;
+static VanityMask match_mask = NULL;
+static int *place_ids = NULL;
+static int place_count = 0;
+static int place_suffixes = TRUE;
+static atomic_int vanity_state;
+static pthread_mutex_t sample_lock = PTHREAD_MUTEX_INITIALIZER;
+static char sample_str[OUTPUT_BUFFER];
+static pthread_mutex_t hits_lock = PTHREAD_MUTEX_INITIALIZER;
+static VanityHit hits = NULL;
+static int hits_len = 0;
+
+// The keyspace is split into chunks of VANITY_CHUNK_KEYS consecutive keys
+// counted from a seed key. Part part_index of part_count only searches
+// every part_count-th chunk, so machines sharing a seed never overlap.
+static unsigned char seed_raw[PRIVKEY_LENGTH];
+static unsigned long part_index = 0;
+static unsigned long part_count = 1;
+static atomic_ulong next_chunk;
+
+// Keys counted up from one seed are all a small distance apart, so anyone
+// holding one of them can find the others. Without a seed to keep, every
+// chunk starts from a fresh random key instead, and ends at its first hit.
+static int fresh_seeds = FALSE;
+
+// The pubkey iterator variants checked for every point, and the length of
+// each candidate: a hash160, or an x-only key for taproot.
+static int variants[PUBKEY_VARIANTS];
+static int variants_len = 0;
+static int candidate_len = 20;
+
+// In a split key search, every point is the customer's public key plus
+// t * G, and only the tweak t is ever known here.
+static PubKey split_key = NULL;
+static char *key_label = "Private Key: ";
+
+// A worker of a coordinator searches the units of chunks it is handed,
+// instead of counting up through the keyspace itself. Both sides read the
+// same shared secret.
+static VanityLink worker_link = NULL;
+static char shared_secret[VANITYCOORD_SECRET_MAX + 1];
+
+// How the key of each variant relates to the iterator key k, indexed by
+// variant / PUBKEY_VARIANT_NEGATED.
+static char *transforms[] = {"k", "-k", "lambda * k", "-lambda * k", "lambda^2 * k", "-lambda^2 * k"};
+
+static int btk_vanity_read_input(char **);
+static int btk_vanity_read_file(char *);
+static int btk_vanity_add_pattern(char *, int, int, int);
+static void btk_vanity_print_hit(VanityHit, int);
+static void btk_vanity_get_stats(VanityStats, unsigned long, double, double);
+static void btk_vanity_print_stats(VanityStats, char *, int);
+static int btk_vanity_write_stats(int, VanityStats);
+static double btk_vanity_elapsed(struct timespec *);
+static void *btk_vanity_worker(void *);
+static int btk_vanity_search(VanityWorker);
+static int btk_vanity_check(PubKeyIter, unsigned char *, int, unsigned long);
+static int btk_vanity_confirm(int, int, unsigned char *, PubKeyIter, size_t, unsigned long);
+static int btk_vanity_report(int, int, char *, PubKeyIter, size_t, unsigned long);
+static void btk_vanity_set_variants(void);
+static int btk_vanity_set_seed(char *);
+static int btk_vanity_set_part(char *);
+static int btk_vanity_set_split(char *);
+static int btk_vanity_next_chunk(unsigned long *);
+static int btk_vanity_join(char *);
+static int btk_vanity_fingerprint(char *);
+static int btk_vanity_read_secret(char *);
+static int btk_vanity_coordinate(void);
+static int btk_vanity_accept(int, unsigned long, int);
+static int btk_vanity_read_state(char *, unsigned long *);
+static int btk_vanity_write_state(char *, VanityWorker);
+static int btk_vanity_get_address(char *, unsigned char *, int);
+static int btk_vanity_match(char *, VanityPattern);
 
 int btk_vanity_init(int argc, char *argv[])
 {
 	int o;
 	char *command = NULL;
+	static struct option long_options[] = {
+		{"seed", required_argument, NULL, OPTION_SEED},
+		{"part", required_argument, NULL, OPTION_PART},
+		{"checkpoint", required_argument, NULL, OPTION_CHECKPOINT},
+		{"resume", required_argument, NULL, OPTION_RESUME},
+		{"stats-fd", required_argument, NULL, OPTION_STATS_FD},
+		{"untweaked", no_argument, NULL, OPTION_UNTWEAKED},
+		{"split", required_argument, NULL, OPTION_SPLIT},
+		{"coordinator", required_argument, NULL, OPTION_COORDINATOR},
+		{"worker", required_argument, NULL, OPTION_WORKER},
+		{"secret", required_argument, NULL, OPTION_SECRET},
+		{"bind-any", no_argument, NULL, OPTION_BIND_ANY},
+		{NULL, 0, NULL, 0}
+	};
 
 	command = argv[1];
 
-	while ((o = getopt(argc, argv, "iABCUT")) != -1)
+	while ((o = getopt_long(argc, argv, "iABPCUTSEp:j:f:", long_options, NULL)) != -1)
 	{
 		switch (o)
 		{
@@ -60,6 +266,12 @@ int btk_vanity_init(int argc, char *argv[])
 			case 'B':
 				OUTPUT_SET(OUTPUT_BECH32_ADDRESS);
 				break;
+			case 'P':
+				OUTPUT_SET(OUTPUT_TAPROOT_ADDRESS);
+				break;
+			case OPTION_UNTWEAKED:
+				input_untweaked = TRUE;
+				break;
 
 				// Output Compression
 			case 'C':
@@ -74,6 +286,89 @@ int btk_vanity_init(int argc, char *argv[])
 				output_testnet = TRUE;
 				break;
 
+			// Symmetry Option
+			case 'S':
+				input_symmetry = TRUE;
+				break;
+
+			// Pattern Placement
+			case 'E':
+				input_suffix = TRUE;
+				break;
+			case 'p':
+				input_position = atoi(optarg);
+				if (input_position < 1)
+				{
+					error_log("Position must be 1 or greater.");
+					return -1;
+				}
+				break;
+
+			// Worker Threads
+			case 'j':
+				worker_count = atoi(optarg);
+				if (worker_count < 1 || worker_count > VANITY_THREADS_MAX)
+				{
+					error_log("Thread count must be between 1 and %i.", VANITY_THREADS_MAX);
+					return -1;
+				}
+				break;
+
+			// Pattern File
+			case 'f':
+				pattern_file = optarg;
+				break;
+
+			// Keyspace and checkpoints
+			case OPTION_SEED:
+				seed_hex = optarg;
+				break;
+			case OPTION_PART:
+				part_str = optarg;
+				break;
+			case OPTION_CHECKPOINT:
+				state_file = optarg;
+				state_resume = FALSE;
+				break;
+			case OPTION_RESUME:
+				state_file = optarg;
+				state_resume = TRUE;
+				break;
+
+			// Split key search
+			case OPTION_SPLIT:
+				split_hex = optarg;
+				break;
+
+			// Distributed search
+			case OPTION_COORDINATOR:
+				coordinator_port = atoi(optarg);
+				if (coordinator_port < 1 || coordinator_port > 65535)
+				{
+					error_log("Port must be between 1 and 65535.");
+					return -1;
+				}
+				break;
+			case OPTION_BIND_ANY:
+				coordinator_any = TRUE;
+				break;
+			case OPTION_WORKER:
+				worker_str = optarg;
+				break;
+			case OPTION_SECRET:
+				secret_file = optarg;
+				break;
+
+			// Machine readable progress
+			case OPTION_STATS_FD:
+				stats_fd = atoi(optarg);
+				if (stats_fd < 0 || fcntl(stats_fd, F_GETFD) < 0)
+				{
+					error_log("Stats file descriptor %s is not open.", optarg);
+					return -1;
+				}
+				break;
+
 			// Unknown option
 			case '?':
 				error_log("See 'btk help %s' to read about available argument options.", command);
@@ -94,295 +389,2038 @@ int btk_vanity_init(int argc, char *argv[])
 		output_format = OUTPUT_ADDRESS;
 	}
 
-	return 1;
-}
+	if (output_format == OUTPUT_BECH32_ADDRESS && output_compression == OUTPUT_UNCOMPRESS)
+	{
+		error_log("Bech32 addresses cannot be uncompressed.");
+		return -1;
+	}
 
-int btk_vanity_main(void)
-{
-	int i, k, r, row;
-	time_t current, start;
-	long int estimate;
-	PubKey key = NULL;
-	PrivKey priv = NULL;
-	char *input;
-	int input_len;
-	char pubkey_str[OUTPUT_BUFFER];
-	char privkey_str[OUTPUT_BUFFER];
+	if (output_format == OUTPUT_TAPROOT_ADDRESS && output_compression == OUTPUT_UNCOMPRESS)
+	{
+		error_log("Taproot addresses cannot be uncompressed.");
+		return -1;
+	}
 
-	r = input_get_str(&input, NULL);
-	if (r < 0)
+	if (input_untweaked && output_format != OUTPUT_TAPROOT_ADDRESS)
 	{
-		error_log("Could not get input.");
+		error_log("The --untweaked option only applies to taproot addresses.");
 		return -1;
 	}
 
-	input_len = r;
-	if (input_len > 10)
+	if (output_format == OUTPUT_TAPROOT_ADDRESS && pattern_file != NULL)
 	{
-		error_log("Match string is too long. This program only supports 10 characters or less.");
+		error_log("Taproot addresses are only supported for a single match string.");
 		return -1;
 	}
 
-	switch (output_format)
+	// The tweak found is added to the customer's key as it is, so the
+	// search can't transform the points.
+	if (split_hex != NULL && input_symmetry)
 	{
-		case OUTPUT_ADDRESS:
-			for (i = 0; i < input_len; ++i)
-			{
-				if ((input_insensitive && !base58_ischar(toupper(input[i])) && !base58_ischar(tolower(input[i]))) || (!input_insensitive && !base58_ischar(input[i])))
-				{
-					error_log("Invalid characters in match string. Must only contain base58 characters");
-					return -1;
-				}
-			}
-			break;
-		case OUTPUT_BECH32_ADDRESS:
-			// If we are executing a case insensitive search for a bech32 address,
-			// Just convert all uppercase letters to lowercase and performs a regular
-			// case sensitive search, since bech32 has no uppercase letters.
-			if (input_insensitive)
-			{
-				for (i = 0; i < input_len; ++i)
-				{
-					if (input[i] >= 'A' && input[i] <= 'Z')
-					{
-						input[i] = tolower(input[i]);
-					}
-				}
-			}
-			for (i = 0; i < input_len; ++i)
-			{
-				if (base32_get_raw(input[i]) < 0)
-				{
-					error_log("Could not calculate bech32 address.");
-					return -1;
-				}
-			}
-			break;
+		error_log("The -S option can not be used with --split.");
+		return -1;
 	}
 
-	// Estimate time
-	switch (output_format)
+	if (input_suffix && input_position)
 	{
-		case OUTPUT_ADDRESS:
-			if (!input_insensitive)
-			{
-				estimate = 58;
-				for (i = 1; i < input_len; ++i)
-				{
-					estimate *= 58;
-				}
-			}
-			else
-			{
-				if (isalpha(input[0]))
-				{
-					estimate = 34;
-				}
-				else
-				{
-					estimate = 58;
-				}
-				for (i = 1; i < input_len; ++i)
-				{
-					if (isalpha(input[i]))
-					{
-						estimate *= 34;
-					}
-					else
-					{
-						estimate *= 58;
-					}
-				}
-			}
-			break;
-		case OUTPUT_BECH32_ADDRESS:
-			estimate = 32;
-			for (i = 1; i < input_len; ++i)
-			{
-				estimate *= 32;
-			}
-			break;
+		error_log("Only specify one of -E and -p.");
+		return -1;
 	}
 
-	if (output_testnet)
+	if (pattern_file != NULL && (input_suffix || input_position))
 	{
-		network_set_test();
+		error_log("Pattern files mark suffixes with a leading '*' instead of -E or -p.");
+		return -1;
+	}
+
+	if (coordinator_port && worker_str != NULL)
+	{
+		error_log("Only specify one of --coordinator and --worker.");
+		return -1;
+	}
+
+	// Nobody else may join the search or learn its keys, so both sides
+	// need the secret. Listening on more than the loopback address has to
+	// be asked for.
+	if ((coordinator_port || worker_str != NULL) && secret_file == NULL)
+	{
+		error_log("The --coordinator and --worker options need a shared secret file given with --secret.");
+		return -1;
+	}
+	if (secret_file != NULL && !coordinator_port && worker_str == NULL)
+	{
+		error_log("The --secret option only applies to --coordinator and --worker.");
+		return -1;
+	}
+	if (coordinator_any && !coordinator_port)
+	{
+		error_log("The --bind-any option only applies to --coordinator.");
+		return -1;
 	}
 
-	// Getting cursor row
-	if (!isatty(STDIN_FILENO) && !freopen ("/dev/tty", "r", stdin))
+	// The coordinator owns the keyspace. It has no checkpoints, since its
+	// workers search out of order anyway.
+	if (coordinator_port && (part_str != NULL || state_file != NULL))
 	{
-		error_log("Terminal error. Cannot associate STDIN with terminal.");
+		error_log("The --part, --checkpoint and --resume options can not be used with --coordinator.");
+		return -1;
+	}
+	if (worker_str != NULL && (seed_hex != NULL || part_str != NULL || state_file != NULL))
+	{
+		error_log("Workers get their keyspace from the coordinator, so --seed, --part, --checkpoint and --resume can not be used with --worker.");
 		return -1;
 	}
-	btktermio_init_terminal();
-	row = btktermio_get_cursor_row();
-	btktermio_restore_terminal();
 
-	i = 0;
-	start = time(NULL);
+	if (state_resume && (seed_hex != NULL || part_str != NULL))
+	{
+		error_log("The seed and part are read from the state file when resuming.");
+		return -1;
+	}
 
-	// Start searching
-	while (1)
+	if (worker_count == 0)
 	{
-		if (row >= 0)
+		worker_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+		if (worker_count < 1)
 		{
-			btktermio_move_cursor(row, 0);
-			if (i == 0)
-			{
-				printf("Searching...");
-				fflush(stdout);
-				btktermio_move_cursor(row, 0);
-			}
+			worker_count = 1;
 		}
-		else
+		if (worker_count > VANITY_THREADS_MAX)
 		{
-			printf("\n");
+			worker_count = VANITY_THREADS_MAX;
 		}
+	}
 
-		priv = malloc(privkey_sizeof());
-		if (priv == NULL)
-		{
-			error_log("Memory allocation error");
-			return -1;
-		}
+	return 1;
+}
 
-		r = privkey_new(priv);
+int btk_vanity_main(void)
+{
+	int i, r, row, printed, expected;
+	unsigned long chunk, total;
+	double elapsed, saved, reported;
+	struct timespec start;
+	struct VanityStats stats;
+	VanityWorker workers = NULL;
+	char *input = NULL;
+	char pubkey_str[OUTPUT_BUFFER];
+	struct timespec interval = {0, 250000000};
+
+	if (output_testnet)
+	{
+		network_set_test();
+	}
+
+	// Workers get their seed from the coordinator.
+	chunk = 0;
+	if (state_resume)
+	{
+		r = btk_vanity_read_state(state_file, &chunk);
 		if (r < 0)
 		{
-			error_log("Could not generate a new private key.");
+			error_log("Could not resume from state file %s.", state_file);
 			return -1;
 		}
-	
-		switch (output_compression)
-		{
-			case FALSE:
-				break;
-			case OUTPUT_COMPRESS:
-				privkey_compress(priv);
-				break;
-			case OUTPUT_UNCOMPRESS:
-				privkey_uncompress(priv);
-				break;
-		}
-
-		key = malloc(pubkey_sizeof());
-		if (key == NULL)
+	}
+	else if (worker_str == NULL)
+	{
+		if (state_file != NULL && access(state_file, F_OK) == 0)
 		{
-			error_log("Memory allocation error");
+			error_log("State file %s already exists. Use --resume to continue from it.", state_file);
 			return -1;
 		}
-
-		r = pubkey_get(key, priv);
+		r = btk_vanity_set_seed(seed_hex);
 		if (r < 0)
 		{
-			error_log("Could not calculate new public key.");
+			error_log("Could not set seed key.");
 			return -1;
 		}
-
-		if (output_format == OUTPUT_ADDRESS)
+		fresh_seeds = (seed_hex == NULL && state_file == NULL && !coordinator_port);
+		if (part_str != NULL)
 		{
-			r = pubkey_to_address(pubkey_str, key);
+			r = btk_vanity_set_part(part_str);
 			if (r < 0)
 			{
-				error_log("Could not calculate public key address.");
+				error_log("Could not set keyspace part.");
 				return -1;
 			}
 		}
-		else if (output_format == OUTPUT_BECH32_ADDRESS)
+	}
+	atomic_store(&next_chunk, chunk);
+
+	if (split_hex != NULL)
+	{
+		r = btk_vanity_set_split(split_hex);
+		if (r < 0)
 		{
-			if(!pubkey_is_compressed(key))
-			{
-				error_log("Bech32 addresses cannot be uncompressed.");
-				return -1;
-			}
-			r = pubkey_to_bech32address(pubkey_str, key);
-			if (r < 0)
-			{
-				error_log("Could not calculate bech32 public key address.");
-				return -1;
-			}
+			error_log("Could not set public key for split key search.");
+			return -1;
 		}
+		key_label = "Tweak:       ";
+	}
+
+	btk_vanity_set_variants();
+	candidate_len = (output_format == OUTPUT_TAPROOT_ADDRESS) ? PUBKEY_COMPRESSED_LENGTH : 20;
+
+	match_table = malloc(vanity_table_sizeof());
+	if (match_table == NULL)
+	{
+		error_log("Memory allocation error");
+		return -1;
+	}
+	vanity_table_init(match_table);
 
-		// Track time and print status
-		current = time(NULL);
-		++i;
-		if (current - start != 0) {
-			printf("%-45s Estimated Seconds: %ld of %ld", pubkey_str, current - start, (estimate / (i / (current - start))));
-			fflush(stdout);
+	// Patterns are compiled into the hash160 ranges that produce them, so
+	// that candidates don't need to be encoded to be checked. The string
+	// read is kept as the pattern.
+	if (pattern_file == NULL)
+	{
+		r = btk_vanity_read_input(&input);
+		if (r < 0)
+		{
+			error_log("Could not get match string.");
+			return -1;
 		}
-	
-		// Process output
-		switch (output_format)
+	}
+	else
+	{
+		r = btk_vanity_read_file(pattern_file);
+		if (r < 0)
 		{
-			case OUTPUT_ADDRESS:
-				if (input_insensitive)
-				{
-					for (k = 0; k < input_len; ++k)
-					{
-						if (pubkey_str[k+1] != toupper(input[k]) && pubkey_str[k+1] != tolower(input[k]))
-						{
-							break;
-						}
-					}
-					if (k == input_len)
-					{
-						r = privkey_to_wif(privkey_str, priv);
-						if (r < 0)
-						{
-							error_log("Could not convert private key to WIF format.");
-							return -1;
-						}
-						printf("\nVanity Address Found!\nPrivate Key: %s\nAddress:     %s\n", privkey_str, pubkey_str);
-						return 1;
-					}
-				}
-				else
-				{
-					r = privkey_to_wif(privkey_str, priv);
-					if (r < 0)
-					{
-						error_log("Could not convert private key to WIF format.");
-						return -1;
-					}
-					if (strncmp(input, pubkey_str + 1, input_len) == 0)
-					{
-						printf("\nVanity Address Found!\nPrivate Key: %s\nAddress:     %s\n", privkey_str, pubkey_str);
-						return 1;
-					}
-				}
-				break;
-			case OUTPUT_BECH32_ADDRESS:
-				if(!pubkey_is_compressed(key))
-				{
-					error_log("Bech32 addresses cannot be uncompressed.");
-					return -1;
-				}
-
-				if (strncmp(input, pubkey_str + 4, input_len) == 0)
-				{
-					r = privkey_to_wif(privkey_str, priv);
-					if (r < 0)
-					{
-						error_log("Could not convert private key to WIF format.");
-						return -1;
-					}
-					printf("\nVanity address found!\nPrivate Key: %s\nAddress:     %s\n", privkey_str, pubkey_str);
-					return 1;
-				}
-				break;
+			error_log("Could not read pattern file %s.", pattern_file);
+			return -1;
 		}
-
-		free(priv);
-		free(key);
 	}
 
-	free(input);
-
-	return 1;
-}
+	// A single bech32 pattern fixes some bits of the hash160 or x-only key,
+	// so it only needs a masked compare of the first few bytes.
+	if (pattern_file == NULL && (output_format == OUTPUT_BECH32_ADDRESS || output_format == OUTPUT_TAPROOT_ADDRESS))
+	{
+		vanity_table_free(match_table);
+		free(match_table);
+		match_table = NULL;
 
-int btk_vanity_cleanup(void)
-{
-	return 1;
-}
\ No newline at end of file
+		match_mask = malloc(vanity_mask_sizeof());
+		if (match_mask == NULL)
+		{
+			error_log("Memory allocation error");
+			return -1;
+		}
+		r = vanity_mask_set_bech32(match_mask, patterns[0].str, patterns[0].offset - strlen(BECH32_START_MAINNET), candidate_len);
+		if (r < 0)
+		{
+			error_log("Could not compile bech32 pattern.");
+			return -1;
+		}
+	}
+	else if (place_count == pattern_count)
+	{
+		// Nothing for the range table to do.
+		vanity_table_free(match_table);
+		free(match_table);
+		match_table = NULL;
+	}
+	else
+	{
+		r = vanity_table_build(match_table);
+		if (r < 0)
+		{
+			error_log("Could not build pattern table.");
+			return -1;
+		}
+	}
+
+	for (i = 0; i < pattern_count; ++i)
+	{
+		if (patterns[i].place != NULL)
+		{
+			patterns[i].probability = vanity_place_probability(patterns[i].place);
+		}
+		else if (match_mask != NULL)
+		{
+			patterns[i].probability = vanity_mask_probability(match_mask);
+		}
+		else
+		{
+			patterns[i].probability = vanity_table_probability(match_table, i);
+		}
+	}
+
+	hits = malloc(sizeof(*hits) * pattern_count);
+	if (hits == NULL)
+	{
+		error_log("Memory allocation error");
+		return -1;
+	}
+	hits_len = 0;
+
+	// The coordinator checks every hit against its own copy of the search,
+	// so it reads the patterns just like its workers.
+	if (coordinator_port)
+	{
+		return btk_vanity_coordinate();
+	}
+
+	// Workers often run without a terminal. They only print what they find.
+	if (worker_str != NULL)
+	{
+		r = btk_vanity_join(worker_str);
+		if (r < 0)
+		{
+			error_log("Could not join coordinator %s.", worker_str);
+			return -1;
+		}
+		row = -1;
+	}
+	else
+	{
+		// Getting cursor row
+		if (!isatty(STDIN_FILENO) && !freopen ("/dev/tty", "r", stdin))
+		{
+			error_log("Terminal error. Cannot associate STDIN with terminal.");
+			return -1;
+		}
+		btktermio_init_terminal();
+		row = btktermio_get_cursor_row();
+		btktermio_restore_terminal();
+	}
+
+	workers = malloc(sizeof(*workers) * worker_count);
+	if (workers == NULL)
+	{
+		error_log("Memory allocation error");
+		return -1;
+	}
+
+	sample_str[0] = '\0';
+	atomic_store(&vanity_state, VANITY_RUNNING);
+
+	for (i = 0; i < worker_count; ++i)
+	{
+		atomic_store(&workers[i].count, 0);
+		atomic_store(&workers[i].chunk, chunk);
+		r = pthread_create(&workers[i].thread, NULL, btk_vanity_worker, &workers[i]);
+		if (r != 0)
+		{
+			error_log("Could not create worker thread.");
+
+			// Stop the workers already running before their array goes.
+			atomic_store(&vanity_state, VANITY_ERROR);
+			if (worker_link != NULL)
+			{
+				vanitycoord_release(worker_link);
+			}
+			while (i-- > 0)
+			{
+				pthread_join(workers[i].thread, NULL);
+			}
+			free(workers);
+			return -1;
+		}
+	}
+
+	if (row >= 0)
+	{
+		btktermio_move_cursor(row, 0);
+		printf("Searching...");
+		fflush(stdout);
+	}
+
+	// A reader going away shouldn't end the search.
+	if (stats_fd >= 0)
+	{
+		signal(SIGPIPE, SIG_IGN);
+	}
+
+	// The workers do the searching. This thread only samples their counters
+	// to report progress, and prints found keys, until every pattern is
+	// found or a worker fails.
+	printed = 0;
+	saved = 0;
+	reported = 0;
+	memset(&stats, 0, sizeof(stats));
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while (atomic_load(&vanity_state) == VANITY_RUNNING)
+	{
+		nanosleep(&interval, NULL);
+
+		total = 0;
+		for (i = 0; i < worker_count; ++i)
+		{
+			total += atomic_load_explicit(&workers[i].count, memory_order_relaxed);
+		}
+		elapsed = btk_vanity_elapsed(&start);
+
+		pthread_mutex_lock(&hits_lock);
+		if (printed < hits_len)
+		{
+			stats.since = total;
+		}
+		while (printed < hits_len)
+		{
+			btk_vanity_print_hit(&hits[printed], row);
+			if (worker_link != NULL && vanitycoord_send_hit(worker_link, hits[printed].id, hits[printed].offset, hits[printed].variant) < 0)
+			{
+				// Losing the coordinator shows up below.
+				error_clear();
+			}
+			printed++;
+		}
+		btk_vanity_get_stats(&stats, total, elapsed, (elapsed > 0) ? total / elapsed : 0);
+		pthread_mutex_unlock(&hits_lock);
+
+		if (worker_link != NULL)
+		{
+			r = vanitycoord_update(worker_link, total, stats.rate, elapsed - reported >= VANITY_STATS_SECS);
+			if (r < 0)
+			{
+				error_log("Lost contact with coordinator.");
+				atomic_store(&vanity_state, VANITY_ERROR);
+				break;
+			}
+			if (r == 0)
+			{
+				expected = VANITY_RUNNING;
+				atomic_compare_exchange_strong(&vanity_state, &expected, VANITY_FOUND);
+				break;
+			}
+		}
+
+		if (state_file != NULL && elapsed - saved >= VANITY_CHECKPOINT_SECS)
+		{
+			r = btk_vanity_write_state(state_file, workers);
+			if (r < 0)
+			{
+				error_log("Could not write state file %s.", state_file);
+				atomic_store(&vanity_state, VANITY_ERROR);
+				break;
+			}
+			saved = elapsed;
+		}
+
+		if (stats_fd >= 0 && elapsed - reported >= VANITY_STATS_SECS)
+		{
+			r = btk_vanity_write_stats(stats_fd, &stats);
+			if (r < 0)
+			{
+				stats_fd = -1;
+			}
+		}
+		if (elapsed - reported >= VANITY_STATS_SECS)
+		{
+			reported = elapsed;
+		}
+
+		pthread_mutex_lock(&sample_lock);
+		strcpy(pubkey_str, sample_str);
+		pthread_mutex_unlock(&sample_lock);
+
+		// The status line would be drawn over the last key found.
+		if (pubkey_str[0] == '\0' || elapsed < 1 || worker_link != NULL || atomic_load(&vanity_state) != VANITY_RUNNING)
+		{
+			continue;
+		}
+
+		btk_vanity_print_stats(&stats, pubkey_str, row);
+	}
+
+	// Wake up any worker still waiting for a unit.
+	if (worker_link != NULL)
+	{
+		vanitycoord_release(worker_link);
+	}
+
+	for (i = 0; i < worker_count; ++i)
+	{
+		pthread_join(workers[i].thread, NULL);
+	}
+
+	if (state_file != NULL)
+	{
+		r = btk_vanity_write_state(state_file, workers);
+		if (r < 0)
+		{
+			error_log("Could not write state file %s.", state_file);
+			return -1;
+		}
+	}
+
+	if (stats_fd >= 0)
+	{
+		total = 0;
+		for (i = 0; i < worker_count; ++i)
+		{
+			total += atomic_load(&workers[i].count);
+		}
+		pthread_mutex_lock(&hits_lock);
+		elapsed = btk_vanity_elapsed(&start);
+		btk_vanity_get_stats(&stats, total, elapsed, (elapsed > 0) ? total / elapsed : 0);
+		pthread_mutex_unlock(&hits_lock);
+		btk_vanity_write_stats(stats_fd, &stats);
+	}
+
+	free(workers);
+
+	if (atomic_load(&vanity_state) == VANITY_ERROR)
+	{
+		error_log("Vanity search failed.");
+		return -1;
+	}
+
+	// A coordinator that has found everything may already have hung up.
+	while (printed < hits_len)
+	{
+		btk_vanity_print_hit(&hits[printed], row);
+		if (worker_link != NULL && vanitycoord_send_hit(worker_link, hits[printed].id, hits[printed].offset, hits[printed].variant) < 0)
+		{
+			error_clear();
+		}
+		printed++;
+	}
+
+	return 1;
+}
+
+int btk_vanity_cleanup(void)
+{
+	int i;
+
+	if (worker_link != NULL)
+	{
+		vanitycoord_leave(worker_link);
+		free(worker_link);
+		worker_link = NULL;
+	}
+	memset(shared_secret, 0, sizeof(shared_secret));
+
+	if (match_table != NULL)
+	{
+		vanity_table_free(match_table);
+		free(match_table);
+		match_table = NULL;
+	}
+	free(match_mask);
+	free(split_key);
+	free(hits);
+
+	for (i = 0; i < pattern_count; ++i)
+	{
+		free(patterns[i].str);
+		free(patterns[i].place);
+	}
+	free(patterns);
+	free(place_ids);
+
+	return 1;
+}
+
+// Reads a single match string from standard input. It is matched after the
+// static characters at the start of the address.
+static int btk_vanity_read_input(char **output)
+{
+	int i, r;
+	char *input;
+	int input_len;
+
+	r = input_get_str(&input, NULL);
+	if (r < 0)
+	{
+		error_log("Could not get input.");
+		return -1;
+	}
+	*output = input;
+
+	input_len = r;
+	if (input_len > VANITY_INPUT_MAX)
+	{
+		error_log("Match string is too long. This program only supports %i characters or less.", VANITY_INPUT_MAX);
+		return -1;
+	}
+
+	switch (output_format)
+	{
+		case OUTPUT_ADDRESS:
+			for (i = 0; i < input_len; ++i)
+			{
+				if ((input_insensitive && !base58_ischar(toupper(input[i])) && !base58_ischar(tolower(input[i]))) || (!input_insensitive && !base58_ischar(input[i])))
+				{
+					error_log("Invalid characters in match string. Must only contain base58 characters");
+					return -1;
+				}
+			}
+			break;
+		case OUTPUT_BECH32_ADDRESS:
+		case OUTPUT_TAPROOT_ADDRESS:
+			// If we are executing a case insensitive search for a bech32 address,
+			// Just convert all uppercase letters to lowercase and performs a regular
+			// case sensitive search, since bech32 has no uppercase letters.
+			if (input_insensitive)
+			{
+				for (i = 0; i < input_len; ++i)
+				{
+					if (input[i] >= 'A' && input[i] <= 'Z')
+					{
+						input[i] = tolower(input[i]);
+					}
+				}
+			}
+			for (i = 0; i < input_len; ++i)
+			{
+				if (base32_get_raw(input[i]) < 0)
+				{
+					error_log("Could not calculate bech32 address.");
+					return -1;
+				}
+			}
+			break;
+	}
+
+	if (output_format != OUTPUT_ADDRESS && input_suffix)
+	{
+		error_log("Bech32 addresses end in a checksum, so suffixes are only supported for base58 addresses.");
+		return -1;
+	}
+	if (output_format == OUTPUT_BECH32_ADDRESS && input_position && input_position <= (int)strlen(BECH32_START_MAINNET))
+	{
+		error_log("Bech32 positions must be after the static '%s'.", network_is_test() ? BECH32_START_TESTNET : BECH32_START_MAINNET);
+		return -1;
+	}
+	if (output_format == OUTPUT_TAPROOT_ADDRESS && input_position && input_position <= (int)strlen(BECH32M_START_MAINNET))
+	{
+		error_log("Taproot positions must be after the static '%s'.", network_is_test() ? BECH32M_START_TESTNET : BECH32M_START_MAINNET);
+		return -1;
+	}
+
+	// Positions count address characters from 1, static ones included.
+	if (input_suffix)
+	{
+		r = btk_vanity_add_pattern(input, output_format, 0, VANITY_ANCHOR_END);
+	}
+	else if (input_position)
+	{
+		r = btk_vanity_add_pattern(input, output_format, input_position - 1, VANITY_ANCHOR_AT);
+	}
+	else if (output_format != OUTPUT_ADDRESS)
+	{
+		r = btk_vanity_add_pattern(input, output_format, strlen(BECH32_START_MAINNET), VANITY_ANCHOR_START);
+	}
+	else
+	{
+		r = btk_vanity_add_pattern(input, OUTPUT_ADDRESS, 1, VANITY_ANCHOR_START);
+	}
+	if (r < 0)
+	{
+		error_log("Could not add match string.");
+		return -1;
+	}
+
+	return 1;
+}
+
+// Reads one full address prefix per line. Lines starting with the bech32
+// address start are bech32 patterns, everything else is base58. Empty lines
+// and lines starting with '#' are skipped.
+static int btk_vanity_read_file(char *path)
+{
+	int r, len;
+	char *bech32_start;
+	char line[VANITY_PATTERN_MAX];
+	char *str;
+	FILE *file;
+
+	bech32_start = network_is_test() ? BECH32_START_TESTNET : BECH32_START_MAINNET;
+
+	file = fopen(path, "r");
+	if (file == NULL)
+	{
+		error_log("Unable to open file.");
+		return -1;
+	}
+
+	while (fgets(line, VANITY_PATTERN_MAX, file) != NULL)
+	{
+		// A line that did not fit would otherwise be read as two patterns.
+		len = strlen(line);
+		if (len > 0 && line[len - 1] != '\n' && !feof(file))
+		{
+			fclose(file);
+			error_log("Pattern file line can not exceed %i characters.", VANITY_PATTERN_MAX - 2);
+			return -1;
+		}
+
+		for (; len > 0 && isspace(line[len - 1]); --len)
+			;
+		line[len] = '\0';
+
+		if (len == 0 || line[0] == '#')
+		{
+			continue;
+		}
+
+		str = malloc(len + 1);
+		if (str == NULL)
+		{
+			error_log("Memory allocation error");
+			return -1;
+		}
+
+		// A leading '*' marks a base58 suffix.
+		if (line[0] == '*')
+		{
+			strcpy(str, line + 1);
+			r = btk_vanity_add_pattern(str, OUTPUT_ADDRESS, 0, VANITY_ANCHOR_END);
+			if (r < 0)
+			{
+				error_log("Could not add pattern '%s'.", line);
+				return -1;
+			}
+			continue;
+		}
+		strcpy(str, line);
+
+		if (strncasecmp(str, bech32_start, strlen(bech32_start)) == 0)
+		{
+			if (output_compression == OUTPUT_UNCOMPRESS)
+			{
+				error_log("Bech32 addresses cannot be uncompressed.");
+				return -1;
+			}
+			for (r = 0; r < len; ++r)
+			{
+				str[r] = tolower(str[r]);
+			}
+			r = btk_vanity_add_pattern(str, OUTPUT_BECH32_ADDRESS, 0, VANITY_ANCHOR_START);
+		}
+		else
+		{
+			r = btk_vanity_add_pattern(str, OUTPUT_ADDRESS, 0, VANITY_ANCHOR_START);
+		}
+		if (r < 0)
+		{
+			error_log("Could not add pattern '%s'.", line);
+			return -1;
+		}
+	}
+
+	fclose(file);
+
+	if (pattern_count == 0)
+	{
+		error_log("No patterns found in file.");
+		return -1;
+	}
+
+	return 1;
+}
+
+// Adds a pattern to the list. Prefixes are compiled into the pattern
+// table. For base58 prefixes given without their first character, every
+// first character the network allows is tried. Base58 patterns anchored
+// anywhere else get a place of their own, and bech32 ones are left for the
+// mask, as are all taproot patterns.
+static int btk_vanity_add_pattern(char *str, int format, int offset, int anchor)
+{
+	int r, t, id;
+	VanityPattern p;
+	int *ids;
+	char prefix[VANITY_PATTERN_MAX + 1];
+
+	p = realloc(patterns, sizeof(*patterns) * (pattern_count + 1));
+	if (p == NULL)
+	{
+		error_log("Memory allocation error");
+		return -1;
+	}
+	patterns = p;
+
+	id = pattern_count++;
+	patterns[id].str = str;
+	patterns[id].format = format;
+	patterns[id].offset = offset;
+	patterns[id].anchor = anchor;
+	patterns[id].found = FALSE;
+	patterns[id].place = NULL;
+	patterns[id].probability = 0;
+
+	if ((anchor != VANITY_ANCHOR_START && format == OUTPUT_BECH32_ADDRESS) || format == OUTPUT_TAPROOT_ADDRESS)
+	{
+		return 1;
+	}
+
+	if (anchor != VANITY_ANCHOR_START)
+	{
+		patterns[id].place = malloc(vanity_place_sizeof());
+		ids = realloc(place_ids, sizeof(*place_ids) * (place_count + 1));
+		if (patterns[id].place == NULL || ids == NULL)
+		{
+			error_log("Memory allocation error");
+			return -1;
+		}
+		place_ids = ids;
+		place_ids[place_count++] = id;
+
+		r = vanity_place_set_base58(patterns[id].place, str, offset, anchor == VANITY_ANCHOR_END, input_insensitive);
+		if (r < 0)
+		{
+			error_log("Could not compile pattern.");
+			return -1;
+		}
+		if (!vanity_place_is_suffix(patterns[id].place))
+		{
+			place_suffixes = FALSE;
+		}
+
+		return 1;
+	}
+
+	// Each case insensitive spelling of a base58 prefix is a range set of
+	// its own, so only so many letters can be matched that way.
+	if (format == OUTPUT_ADDRESS && vanity_base58_spellings(str, input_insensitive) > VANITY_SPELLINGS_MAX)
+	{
+		error_log("With -i, a prefix can have at most %i upper and lower case spellings (12 letters). '%s' has more.", VANITY_SPELLINGS_MAX, str);
+		return -1;
+	}
+
+	if (format == OUTPUT_BECH32_ADDRESS)
+	{
+		if (offset == 0)
+		{
+			str += strlen(BECH32_START_MAINNET);
+		}
+		r = vanity_table_add_bech32(match_table, str, id);
+	}
+	else if (offset == 0)
+	{
+		r = vanity_table_add_base58(match_table, str, input_insensitive, id);
+	}
+	else if (network_is_test())
+	{
+		snprintf(prefix, sizeof(prefix), "m%s", str);
+		r = vanity_table_add_base58(match_table, prefix, input_insensitive, id);
+		if (r >= 0)
+		{
+			prefix[0] = 'n';
+			t = vanity_table_add_base58(match_table, prefix, input_insensitive, id);
+			r = (t < 0) ? t : r + t;
+		}
+	}
+	else
+	{
+		snprintf(prefix, sizeof(prefix), "1%s", str);
+		r = vanity_table_add_base58(match_table, prefix, input_insensitive, id);
+	}
+	if (r < 0)
+	{
+		error_log("Could not compile pattern.");
+		return -1;
+	}
+	if (r == 0)
+	{
+		error_log("No address can begin with the pattern '%s'.", str);
+		return -1;
+	}
+
+	return 1;
+}
+
+static void btk_vanity_print_hit(VanityHit hit, int row)
+{
+	if (pattern_file != NULL)
+	{
+		printf("\r");
+	}
+	else if (row >= 0)
+	{
+		btktermio_move_cursor(row, 0);
+	}
+	else
+	{
+		printf("\n");
+	}
+	printf("%-45s", hit->pubkey_str);
+
+	if (pattern_file != NULL)
+	{
+		printf("\nVanity Address Found!\nPattern:     %s%s\n%s%s\nAddress:     %s\n", (patterns[hit->id].anchor == VANITY_ANCHOR_END) ? "*" : "", patterns[hit->id].str, key_label, hit->privkey_str, hit->pubkey_str);
+	}
+	else if (patterns[hit->id].format == OUTPUT_BECH32_ADDRESS)
+	{
+		printf("\nVanity address found!\n%s%s\nAddress:     %s\n", key_label, hit->privkey_str, hit->pubkey_str);
+	}
+	else if (patterns[hit->id].format == OUTPUT_TAPROOT_ADDRESS && split_key != NULL)
+	{
+		printf("\nVanity address found!\n%s%s\nAddress:     %s\n", key_label, hit->privkey_str, hit->pubkey_str);
+	}
+	else if (patterns[hit->id].format == OUTPUT_TAPROOT_ADDRESS)
+	{
+		// The private key is the internal key. Wallets derive the address
+		// from it through the matching descriptor.
+		printf("\nVanity address found!\nPrivate Key: %s\nAddress:     %s\nDescriptor:  %s(%s)\n", hit->privkey_str, hit->pubkey_str, input_untweaked ? "rawtr" : "tr", hit->privkey_str);
+	}
+	else
+	{
+		printf("\nVanity Address Found!\n%s%s\nAddress:     %s\n", key_label, hit->privkey_str, hit->pubkey_str);
+	}
+
+	// The private key above already has the transform applied. k is the
+	// key the search had counted up to.
+	if (input_symmetry && patterns[hit->id].format == OUTPUT_TAPROOT_ADDRESS)
+	{
+		printf("Transform:   %s\n", transforms[hit->variant / PUBKEY_VARIANT_NEGATED]);
+	}
+	else if (input_symmetry)
+	{
+		printf("Transform:   %s, %s\n", transforms[hit->variant / PUBKEY_VARIANT_NEGATED], (hit->variant & PUBKEY_VARIANT_UNCOMPRESSED) ? "uncompressed" : "compressed");
+	}
+	fflush(stdout);
+}
+
+// Fills in the probabilities for total candidates after elapsed seconds,
+// checked at rate candidates per second. Must be called with hits_lock
+// held.
+static void btk_vanity_get_stats(VanityStats stats, unsigned long total, double elapsed, double rate)
+{
+	int i;
+
+	stats->elapsed = elapsed;
+	stats->total = total;
+	stats->rate = rate;
+	stats->found = hits_len;
+	stats->patterns = pattern_count;
+
+	stats->probability = 0;
+	for (i = 0; i < pattern_count; ++i)
+	{
+		if (!patterns[i].found)
+		{
+			stats->probability += patterns[i].probability;
+		}
+	}
+
+	// Every candidate matches independently, so the expected time to a
+	// match doesn't depend on how long the search has been running.
+	stats->eta = 0;
+	stats->success = 0;
+	if (stats->probability > 0)
+	{
+		if (stats->rate > 0)
+		{
+			stats->eta = 1 / (stats->probability * stats->rate);
+		}
+		stats->success = -expm1((double)(total - stats->since) * log1p(-stats->probability));
+	}
+}
+
+static void btk_vanity_print_stats(VanityStats stats, char *pubkey_str, int row)
+{
+	// With a pattern file, found keys scroll the screen, so the status
+	// line is just redrawn wherever the cursor is.
+	if (pattern_file != NULL)
+	{
+		printf("\r");
+	}
+	else if (row >= 0)
+	{
+		btktermio_move_cursor(row, 0);
+	}
+	else
+	{
+		printf("\n");
+	}
+
+	if (pattern_file != NULL)
+	{
+		printf("%-45s Patterns Found: %d of %d", pubkey_str, stats->found, pattern_count);
+	}
+	else if (stats->eta > 0)
+	{
+		printf("%-45s Estimated Seconds: %.0f of %.0f (%.1f%%)", pubkey_str, stats->elapsed, stats->eta, stats->success * 100);
+	}
+	else
+	{
+		printf("%-45s Estimated Seconds: %.0f of ?", pubkey_str, stats->elapsed);
+	}
+	fflush(stdout);
+}
+
+// Writes the stats as a single line of JSON.
+static int btk_vanity_write_stats(int fd, VanityStats stats)
+{
+	int r;
+
+	r = dprintf(fd, "{\"elapsed\": %.3f, \"candidates\": %lu, \"keys\": %lu, \"rate\": %.1f, \"found\": %d, \"patterns\": %d, \"probability\": %.6e, \"eta\": %.1f, \"success\": %.6f}\n",
+		stats->elapsed, stats->total, stats->total / variants_len, stats->rate, stats->found, stats->patterns, stats->probability, stats->eta, stats->success);
+	if (r < 0)
+	{
+		error_log("Could not write stats.");
+		return -1;
+	}
+
+	return 1;
+}
+
+// Seconds since start, on a clock that never jumps.
+static double btk_vanity_elapsed(struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) + ((now.tv_nsec - start->tv_nsec) / 1e9);
+}
+
+static void *btk_vanity_worker(void *arg)
+{
+	int r, expected;
+
+	r = btk_vanity_search(arg);
+	if (r < 0)
+	{
+		expected = VANITY_RUNNING;
+		atomic_compare_exchange_strong(&vanity_state, &expected, VANITY_ERROR);
+	}
+
+	return NULL;
+}
+
+static int btk_vanity_search(VanityWorker worker)
+{
+	int b, n, r, checked;
+	unsigned long chunk, offset, count = 0;
+	PrivKey priv = NULL;
+	PubKeyIter iter = NULL;
+	unsigned char *hashes = NULL;
+	char pubkey_str[OUTPUT_BUFFER];
+
+	priv = malloc(privkey_sizeof());
+	iter = malloc(pubkey_iter_sizeof());
+	hashes = malloc(PUBKEY_ITER_BATCH * variants_len * candidate_len);
+	if (priv == NULL || iter == NULL || hashes == NULL)
+	{
+		error_log("Memory allocation error");
+		return -1;
+	}
+
+	while (atomic_load_explicit(&vanity_state, memory_order_relaxed) == VANITY_RUNNING)
+	{
+		// Claim the next chunk of this part of the keyspace and count up
+		// from its first key.
+		if (!btk_vanity_next_chunk(&chunk))
+		{
+			break;
+		}
+		atomic_store(&worker->chunk, chunk);
+
+		if (fresh_seeds)
+		{
+			r = privkey_new(priv);
+		}
+		else
+		{
+			r = privkey_from_raw(priv, seed_raw, PRIVKEY_LENGTH);
+		}
+		if (r < 0)
+		{
+			error_log("Could not load seed key.");
+			return -1;
+		}
+		offset = ((uint64_t)chunk * part_count + part_index) * VANITY_CHUNK_KEYS;
+		privkey_add_uint(priv, offset);
+
+		r = pubkey_iter_init_offset(iter, priv, split_key);
+		if (r < 0)
+		{
+			error_log("Could not initialize public key iterator.");
+			return -1;
+		}
+
+		for (b = 0; b < VANITY_CHUNK_BATCHES; ++b)
+		{
+			if (atomic_load_explicit(&vanity_state, memory_order_relaxed) != VANITY_RUNNING)
+			{
+				break;
+			}
+
+			// Step and hash a whole batch of consecutive keys, then check
+			// each hash. Only a match is traced back to its private key.
+			// Taproot candidates are x-only keys, which an untweaked search
+			// gets without any hashing at all.
+			if (output_format == OUTPUT_TAPROOT_ADDRESS)
+			{
+				n = pubkey_iter_next_xonly_variants(hashes, iter, variants, variants_len, !input_untweaked);
+			}
+			else
+			{
+				n = pubkey_iter_next_hash160_variants(hashes, iter, variants, variants_len);
+			}
+			if (n < 0)
+			{
+				error_log("Could not calculate new public keys.");
+				return -1;
+			}
+
+			checked = btk_vanity_check(iter, hashes, n, offset);
+			if (checked < 0)
+			{
+				error_log("Could not check public key hashes.");
+				return -1;
+			}
+
+			// Publish progress for the status line.
+			r = btk_vanity_get_address(pubkey_str, hashes + ((n - 1) * variants_len * candidate_len), output_format);
+			if (r < 0)
+			{
+				error_log("Could not calculate address.");
+				return -1;
+			}
+			offset += n;
+			count += n * variants_len;
+			atomic_store_explicit(&worker->count, count, memory_order_relaxed);
+			pthread_mutex_lock(&sample_lock);
+			strcpy(sample_str, pubkey_str);
+			pthread_mutex_unlock(&sample_lock);
+
+			// Move on to a fresh key.
+			if (checked == 0)
+			{
+				break;
+			}
+		}
+
+		pubkey_iter_free(iter);
+
+		// A unit is only done once all of its chunks were searched.
+		if (worker_link != NULL && b == VANITY_CHUNK_BATCHES)
+		{
+			vanitycoord_chunk_done(worker_link, chunk);
+		}
+	}
+
+	free(iter);
+	free(hashes);
+	free(priv);
+
+	return 1;
+}
+
+// Checks the hashes of a batch of n keys from the iterator against the
+// patterns. Each key has variants_len hashes, one per variant, each
+// candidate_len bytes long. The first key is offset keys from the seed.
+// Returns 0 if a key was found and the chunk has to end there.
+static int btk_vanity_check(PubKeyIter iter, unsigned char *hashes, int n, unsigned long offset)
+{
+	int i, j, k, r, v;
+	int ids[VANITY_MATCH_MAX];
+	size_t back;
+	unsigned char *hash;
+	struct VanityDigits digits;
+
+	for (i = 0; i < n * variants_len; ++i)
+	{
+		hash = hashes + (i * candidate_len);
+		v = variants[i % variants_len];
+		back = n - 1 - (i / variants_len);
+
+		if (match_mask != NULL)
+		{
+			// Encoding and checksum only happen on a hit.
+			if (vanity_mask_match(match_mask, hash))
+			{
+				r = btk_vanity_confirm(0, v, hash, iter, back, offset + n - 1 - back);
+				if (r < 0)
+				{
+					error_log("Could not confirm vanity address.");
+					return -1;
+				}
+				if (r > 0 && fresh_seeds)
+				{
+					return 0;
+				}
+			}
+			continue;
+		}
+
+		// A candidate only gets encoded if its hash falls in one of the
+		// pattern ranges.
+		if (match_table != NULL)
+		{
+			k = vanity_table_match(match_table, hash, ids, VANITY_MATCH_MAX);
+			for (j = 0; j < k; ++j)
+			{
+				r = btk_vanity_confirm(ids[j], v, hash, iter, back, offset + n - 1 - back);
+				if (r < 0)
+				{
+					error_log("Could not confirm vanity address.");
+					return -1;
+				}
+				if (r > 0 && fresh_seeds)
+				{
+					return 0;
+				}
+			}
+		}
+
+		// Patterns elsewhere in the address only need the base58 digits,
+		// which take a checksum and a few divisions but no encoding. Short
+		// suffixes only need the last ten, from a single division.
+		if (place_count > 0)
+		{
+			if (place_suffixes)
+			{
+				r = vanity_digits_set_suffix(&digits, hash);
+			}
+			else
+			{
+				r = vanity_digits_set(&digits, hash);
+			}
+			if (r < 0)
+			{
+				error_log("Could not calculate address digits.");
+				return -1;
+			}
+			for (j = 0; j < place_count; ++j)
+			{
+				if (!vanity_place_match(patterns[place_ids[j]].place, &digits))
+				{
+					continue;
+				}
+				r = btk_vanity_confirm(place_ids[j], v, hash, iter, back, offset + n - 1 - back);
+				if (r < 0)
+				{
+					error_log("Could not confirm vanity address.");
+					return -1;
+				}
+				if (r > 0 && fresh_seeds)
+				{
+					return 0;
+				}
+			}
+		}
+	}
+
+	return 1;
+}
+
+// Encodes a candidate that passed the quick check and reports it if the
+// address really matches. Base58 ranges are rounded outward, so the quick
+// check can let a few extra candidates through. Returns 1 if a new key was
+// found, 0 if not.
+static int btk_vanity_confirm(int id, int variant, unsigned char *hash, PubKeyIter iter, size_t back, unsigned long offset)
+{
+	int r;
+	char pubkey_str[OUTPUT_BUFFER];
+
+	// Bech32 addresses are only valid for compressed keys.
+	if (patterns[id].format == OUTPUT_BECH32_ADDRESS && (variant & PUBKEY_VARIANT_UNCOMPRESSED))
+	{
+		return 0;
+	}
+
+	r = btk_vanity_get_address(pubkey_str, hash, patterns[id].format);
+	if (r < 0)
+	{
+		error_log("Could not calculate address.");
+		return -1;
+	}
+
+	if (btk_vanity_match(pubkey_str, &patterns[id]))
+	{
+		r = btk_vanity_report(id, variant, pubkey_str, iter, back, offset);
+		if (r < 0)
+		{
+			error_log("Could not report vanity address.");
+			return -1;
+		}
+		return r;
+	}
+
+	return 0;
+}
+
+// Queues a found key for printing, unless its pattern was already found.
+// The search stops once every pattern has been found. Returns 1 if the key
+// was queued, 0 if not.
+static int btk_vanity_report(int id, int variant, char *pubkey_str, PubKeyIter iter, size_t back, unsigned long offset)
+{
+	int r, expected;
+	PrivKey priv;
+	char privkey_str[OUTPUT_BUFFER];
+
+	priv = malloc(privkey_sizeof());
+	if (priv == NULL)
+	{
+		error_log("Memory allocation error");
+		return -1;
+	}
+
+	r = pubkey_iter_get_privkey_variant(priv, iter, back, variant);
+	if (r < 0)
+	{
+		error_log("Could not recover private key.");
+		return -1;
+	}
+	// A split key search only knows the tweak, which is given as hex since
+	// it isn't a key of its own.
+	if (split_key != NULL)
+	{
+		r = privkey_to_hex(privkey_str, priv, 0);
+	}
+	else
+	{
+		r = privkey_to_wif(privkey_str, priv);
+	}
+	if (r < 0)
+	{
+		error_log("Could not convert private key to WIF format.");
+		return -1;
+	}
+
+	free(priv);
+
+	r = FALSE;
+	pthread_mutex_lock(&hits_lock);
+	if (!patterns[id].found && atomic_load(&vanity_state) == VANITY_RUNNING)
+	{
+		r = TRUE;
+		patterns[id].found = TRUE;
+		hits[hits_len].id = id;
+		hits[hits_len].variant = variant;
+		hits[hits_len].offset = offset;
+		strcpy(hits[hits_len].pubkey_str, pubkey_str);
+		strcpy(hits[hits_len].privkey_str, privkey_str);
+		if (++hits_len == pattern_count)
+		{
+			expected = VANITY_RUNNING;
+			atomic_compare_exchange_strong(&vanity_state, &expected, VANITY_FOUND);
+		}
+	}
+	pthread_mutex_unlock(&hits_lock);
+
+	return r;
+}
+
+static int btk_vanity_get_address(char *pubkey_str, unsigned char *hash, int format)
+{
+	int r = 1;
+
+	switch (format)
+	{
+		case OUTPUT_ADDRESS:
+			r = pubkey_hash160_to_address(pubkey_str, hash);
+			if (r < 0)
+			{
+				error_log("Could not calculate public key address.");
+				return -1;
+			}
+			break;
+		case OUTPUT_BECH32_ADDRESS:
+			r = pubkey_hash160_to_bech32address(pubkey_str, hash);
+			if (r < 0)
+			{
+				error_log("Could not calculate bech32 public key address.");
+				return -1;
+			}
+			break;
+		case OUTPUT_TAPROOT_ADDRESS:
+			r = pubkey_xonly_to_taproot_address(pubkey_str, hash);
+			if (r < 0)
+			{
+				error_log("Could not calculate taproot public key address.");
+				return -1;
+			}
+			break;
+	}
+
+	return r;
+}
+
+static int btk_vanity_match(char *pubkey_str, VanityPattern pattern)
+{
+	int k, len, pattern_len;
+
+	len = strlen(pubkey_str);
+	pattern_len = strlen(pattern->str);
+	if (len < pattern->offset + pattern_len)
+	{
+		return FALSE;
+	}
+
+	if (pattern->anchor == VANITY_ANCHOR_END)
+	{
+		pubkey_str += len - pattern_len - pattern->offset;
+	}
+	else
+	{
+		pubkey_str += pattern->offset;
+	}
+
+	if (input_insensitive)
+	{
+		for (k = 0; pattern->str[k] != '\0'; ++k)
+		{
+			if (pubkey_str[k] != toupper(pattern->str[k]) && pubkey_str[k] != tolower(pattern->str[k]))
+			{
+				return FALSE;
+			}
+		}
+		return TRUE;
+	}
+
+	return strncmp(pattern->str, pubkey_str, pattern_len) == 0;
+}
+
+// Sets the key the search counts up from. Without a hex string, a random
+// key is used.
+static int btk_vanity_set_seed(char *hex)
+{
+	int r;
+	PrivKey priv;
+
+	priv = malloc(privkey_sizeof());
+	if (priv == NULL)
+	{
+		error_log("Memory allocation error");
+		return -1;
+	}
+
+	if (hex == NULL)
+	{
+		r = privkey_new(priv);
+	}
+	else if (strlen(hex) != PRIVKEY_LENGTH * 2)
+	{
+		error_log("Seed must be %i hexadecimal characters.", PRIVKEY_LENGTH * 2);
+		r = -1;
+	}
+	else
+	{
+		r = privkey_from_hex(priv, hex);
+	}
+	if (r < 0)
+	{
+		error_log("Could not get seed key.");
+		free(priv);
+		return -1;
+	}
+
+	r = privkey_to_raw(seed_raw, priv, 0);
+	if (r < 0)
+	{
+		error_log("Could not convert seed key to raw data.");
+		free(priv);
+		return -1;
+	}
+
+	free(priv);
+
+	return 1;
+}
+
+// Parses a keyspace part given as "i/n", with i counted from 1.
+static int btk_vanity_set_part(char *str)
+{
+	unsigned long i, n;
+	char c;
+
+	if (sscanf(str, "%lu/%lu%c", &i, &n, &c) != 2 || n < 1 || i < 1 || i > n)
+	{
+		error_log("Part must be given as i/n, with i between 1 and n.");
+		return -1;
+	}
+
+	part_index = i - 1;
+	part_count = n;
+
+	return 1;
+}
+
+// Sets the public key of a split key search from its hex encoding, in
+// either compressed or uncompressed form.
+static int btk_vanity_set_split(char *hex)
+{
+	int r;
+	size_t len;
+	unsigned char raw[PUBKEY_UNCOMPRESSED_LENGTH + 1];
+	PubKey check;
+
+	len = strlen(hex);
+	if (len != (PUBKEY_COMPRESSED_LENGTH + 1) * 2 && len != (PUBKEY_UNCOMPRESSED_LENGTH + 1) * 2)
+	{
+		error_log("Public key must be %i or %i hexadecimal characters.", (PUBKEY_COMPRESSED_LENGTH + 1) * 2, (PUBKEY_UNCOMPRESSED_LENGTH + 1) * 2);
+		return -1;
+	}
+
+	r = hex_str_to_raw(raw, hex);
+	if (r < 0)
+	{
+		error_log("Could not convert public key hex string.");
+		return -1;
+	}
+
+	split_key = malloc(pubkey_sizeof());
+	check = malloc(pubkey_sizeof());
+	if (split_key == NULL || check == NULL)
+	{
+		error_log("Memory allocation error");
+		return -1;
+	}
+
+	r = pubkey_from_raw(split_key, raw, len / 2);
+	if (r < 0)
+	{
+		error_log("Invalid public key.");
+		free(check);
+		return -1;
+	}
+
+	// Decompressing a compressed copy solves for the y of the key. It only
+	// matches the y given if the key is on the curve.
+	memcpy(check, split_key, pubkey_sizeof());
+	pubkey_compress(check);
+	r = pubkey_decompress(check);
+	if (r < 0 || (!pubkey_is_compressed(split_key) && memcmp(check, split_key, pubkey_sizeof()) != 0))
+	{
+		error_log("Public key is not on the curve.");
+		free(check);
+		return -1;
+	}
+	free(check);
+
+	return 1;
+}
+
+// Restores the seed, part and next chunk from a state file.
+static int btk_vanity_read_state(char *file, unsigned long *chunk)
+{
+	int r, have_seed, have_part, have_chunk;
+	FILE *f;
+	char line[VANITY_STATE_LINE_MAX];
+	char value[VANITY_STATE_LINE_MAX];
+
+	f = fopen(file, "r");
+	if (f == NULL)
+	{
+		error_log("Could not open state file.");
+		return -1;
+	}
+
+	have_seed = have_part = have_chunk = FALSE;
+	while (fgets(line, sizeof(line), f) != NULL)
+	{
+		if (sscanf(line, "seed %199s", value) == 1)
+		{
+			r = btk_vanity_set_seed(value);
+			if (r < 0)
+			{
+				error_log("Invalid seed in state file.");
+				fclose(f);
+				return -1;
+			}
+			have_seed = TRUE;
+		}
+		else if (sscanf(line, "part %199s", value) == 1)
+		{
+			r = btk_vanity_set_part(value);
+			if (r < 0)
+			{
+				error_log("Invalid part in state file.");
+				fclose(f);
+				return -1;
+			}
+			have_part = TRUE;
+		}
+		else if (sscanf(line, "chunk %lu", chunk) == 1)
+		{
+			have_chunk = TRUE;
+		}
+	}
+
+	fclose(f);
+
+	if (!have_seed || !have_part || !have_chunk)
+	{
+		error_log("State file is incomplete.");
+		return -1;
+	}
+
+	return 1;
+}
+
+// Saves the search position. Workers finish their chunks out of order, so
+// the lowest chunk still being searched is saved. Resuming repeats at most
+// one partial chunk per worker. The file holds the seed key, so it is only
+// readable by its owner, and it is replaced by a rename so that a crash
+// never leaves a truncated file behind.
+static int btk_vanity_write_state(char *file, VanityWorker workers)
+{
+	int i, r, fd;
+	unsigned long chunk, c;
+	FILE *f;
+	char *tmp;
+	char seed_str[PRIVKEY_LENGTH * 2 + 1];
+
+	chunk = atomic_load(&workers[0].chunk);
+	for (i = 1; i < worker_count; ++i)
+	{
+		c = atomic_load(&workers[i].chunk);
+		if (c < chunk)
+		{
+			chunk = c;
+		}
+	}
+
+	hex_encode(seed_str, seed_raw, PRIVKEY_LENGTH);
+
+	tmp = malloc(strlen(file) + 5);
+	if (tmp == NULL)
+	{
+		error_log("Memory allocation error");
+		return -1;
+	}
+	sprintf(tmp, "%s.tmp", file);
+
+	fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0 || (f = fdopen(fd, "w")) == NULL)
+	{
+		error_log("Could not open temporary state file.");
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+		free(tmp);
+		return -1;
+	}
+
+	fprintf(f, "seed %s\n", seed_str);
+	fprintf(f, "part %lu/%lu\n", part_index + 1, part_count);
+	fprintf(f, "chunk %lu\n", chunk);
+
+	r = fclose(f);
+	if (r != 0)
+	{
+		error_log("Could not write temporary state file.");
+		free(tmp);
+		return -1;
+	}
+
+	r = rename(tmp, file);
+	if (r != 0)
+	{
+		error_log("Could not replace state file.");
+		free(tmp);
+		return -1;
+	}
+
+	free(tmp);
+
+	return 1;
+}
+
+// Picks the variants of each point to check. Without -S, only the encoding
+// chosen by -C or -U is checked. With -S, the negated point and both
+// endomorphism images are checked too, in both encodings unless one was
+// chosen. That gives up to 12 candidates for each point calculated.
+// Taproot keys are x-only, so a negated point is the same candidate and
+// there is no uncompressed form.
+static void btk_vanity_set_variants(void)
+{
+	int v, compressed, uncompressed;
+
+	compressed = (output_compression != OUTPUT_UNCOMPRESS);
+	uncompressed = (output_compression == OUTPUT_UNCOMPRESS);
+	if (input_symmetry && output_compression == FALSE && output_format == OUTPUT_ADDRESS)
+	{
+		uncompressed = TRUE;
+	}
+
+	variants_len = 0;
+	for (v = 0; v < PUBKEY_VARIANTS; ++v)
+	{
+		if (!input_symmetry && v >= PUBKEY_VARIANT_NEGATED)
+		{
+			break;
+		}
+		if (output_format == OUTPUT_TAPROOT_ADDRESS && (v & PUBKEY_VARIANT_NEGATED))
+		{
+			continue;
+		}
+		if ((v & PUBKEY_VARIANT_UNCOMPRESSED) ? uncompressed : compressed)
+		{
+			variants[variants_len++] = v;
+		}
+	}
+}
+
+// Claims the next chunk to search. Returns 0 once the search is over.
+static int btk_vanity_next_chunk(unsigned long *chunk)
+{
+	if (worker_link == NULL)
+	{
+		*chunk = atomic_fetch_add(&next_chunk, 1);
+		return 1;
+	}
+
+	return vanitycoord_next_chunk(worker_link, chunk);
+}
+
+// Joins the coordinator at "host:port". The seed all of its workers share
+// is only sent to a worker that knows the secret and searches for the
+// same thing.
+static int btk_vanity_join(char *str)
+{
+	int r, port;
+	char *colon, *host;
+	char fingerprint[VANITY_FINGERPRINT_LEN * 2 + 1];
+
+	colon = strrchr(str, ':');
+	if (colon == NULL || colon == str)
+	{
+		error_log("Coordinator must be given as host:port.");
+		return -1;
+	}
+	port = atoi(colon + 1);
+	if (port < 1 || port > 65535)
+	{
+		error_log("Port must be between 1 and 65535.");
+		return -1;
+	}
+
+	r = btk_vanity_read_secret(secret_file);
+	if (r < 0)
+	{
+		error_log("Could not read secret file %s.", secret_file);
+		return -1;
+	}
+
+	r = btk_vanity_fingerprint(fingerprint);
+	if (r < 0)
+	{
+		error_log("Could not describe search.");
+		return -1;
+	}
+
+	host = malloc(colon - str + 1);
+	worker_link = malloc(vanitycoord_link_sizeof());
+	if (host == NULL || worker_link == NULL)
+	{
+		error_log("Memory allocation error");
+		free(host);
+		free(worker_link);
+		worker_link = NULL;
+		return -1;
+	}
+	memcpy(host, str, colon - str);
+	host[colon - str] = '\0';
+
+	r = vanitycoord_join(worker_link, host, port, shared_secret, fingerprint, seed_raw);
+	free(host);
+	if (r < 0)
+	{
+		error_log("Could not join coordinator.");
+		free(worker_link);
+		worker_link = NULL;
+		return -1;
+	}
+
+	return 1;
+}
+
+// Hashes everything that decides what a search finds into a short hex
+// string. Workers only join a coordinator that has the same one.
+static int btk_vanity_fingerprint(char *output)
+{
+	int i, r, len;
+	size_t size;
+	char *str;
+	unsigned char hash[32];
+
+	size = 100 + strlen(split_hex ? split_hex : "-") + (pattern_count * (VANITY_PATTERN_MAX + 40));
+	str = malloc(size);
+	if (str == NULL)
+	{
+		error_log("Memory allocation error");
+		return -1;
+	}
+
+	len = snprintf(str, size, "%d %d %d %d %d %d %s", output_format, output_compression, output_testnet, input_insensitive, input_symmetry, input_untweaked, split_hex ? split_hex : "-");
+	for (i = 0; i < pattern_count; ++i)
+	{
+		len += snprintf(str + len, size - len, " %d %d %d %s", patterns[i].format, patterns[i].offset, patterns[i].anchor, patterns[i].str);
+	}
+
+	r = crypto_get_sha256(hash, (unsigned char *)str, len);
+	free(str);
+	if (r < 0)
+	{
+		error_log("Could not hash search description.");
+		return -1;
+	}
+
+	hex_encode(output, hash, VANITY_FINGERPRINT_LEN);
+
+	return 1;
+}
+
+// Reads the shared secret from the first line of a file. Surrounding
+// whitespace is not part of it.
+static int btk_vanity_read_secret(char *path)
+{
+	int len;
+	char *start;
+	char line[VANITYCOORD_SECRET_MAX + 2];
+	FILE *file;
+
+	file = fopen(path, "r");
+	if (file == NULL)
+	{
+		error_log("Unable to open file.");
+		return -1;
+	}
+
+	if (fgets(line, sizeof(line), file) == NULL)
+	{
+		line[0] = '\0';
+	}
+	fclose(file);
+
+	len = strlen(line);
+	if (len == VANITYCOORD_SECRET_MAX + 1 && line[len - 1] != '\n')
+	{
+		memset(line, 0, sizeof(line));
+		error_log("Secret can not exceed %i characters.", VANITYCOORD_SECRET_MAX);
+		return -1;
+	}
+
+	for (; len > 0 && isspace(line[len - 1]); --len)
+		;
+	line[len] = '\0';
+	for (start = line; isspace(*start); ++start)
+		;
+
+	if (*start == '\0')
+	{
+		error_log("Secret file is empty.");
+		return -1;
+	}
+
+	strcpy(shared_secret, start);
+	memset(line, 0, sizeof(line));
+
+	return 1;
+}
+
+// Runs the coordinator. It hands out units of the keyspace to its workers
+// as they ask for them, sums up their progress, checks and prints what
+// they find and stops them all once every pattern has been found.
+static int btk_vanity_coordinate(void)
+{
+	int r, printed, workers_len;
+	unsigned long total;
+	double rate, elapsed, reported;
+	struct timespec start;
+	struct VanityStats stats;
+	char fingerprint[VANITY_FINGERPRINT_LEN * 2 + 1];
+	VanityCoord coord;
+
+	r = btk_vanity_read_secret(secret_file);
+	if (r < 0)
+	{
+		error_log("Could not read secret file %s.", secret_file);
+		return -1;
+	}
+
+	r = btk_vanity_fingerprint(fingerprint);
+	if (r < 0)
+	{
+		error_log("Could not describe search.");
+		return -1;
+	}
+
+	coord = malloc(vanitycoord_sizeof());
+	if (coord == NULL)
+	{
+		error_log("Memory allocation error");
+		return -1;
+	}
+
+	r = vanitycoord_init(coord, coordinator_port, coordinator_any, seed_raw, shared_secret, fingerprint, btk_vanity_accept);
+	if (r < 0)
+	{
+		error_log("Could not start coordinator.");
+		free(coord);
+		return -1;
+	}
+
+	printf("Waiting for workers on %s port %d...\n", coordinator_any ? "any address," : "localhost", coordinator_port);
+	fflush(stdout);
+
+	// Hits come in through btk_vanity_accept(), which runs on this thread.
+	printed = 0;
+	reported = 0;
+	memset(&stats, 0, sizeof(stats));
+	atomic_store(&vanity_state, VANITY_RUNNING);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while (atomic_load(&vanity_state) == VANITY_RUNNING)
+	{
+		r = vanitycoord_poll(coord, 250);
+		if (r < 0)
+		{
+			error_log("Could not serve workers.");
+			atomic_store(&vanity_state, VANITY_ERROR);
+			break;
+		}
+
+		vanitycoord_progress(coord, &total, &rate, &workers_len);
+		elapsed = btk_vanity_elapsed(&start);
+
+		// The rate is summed up from the workers' own reports.
+		pthread_mutex_lock(&hits_lock);
+		if (printed < hits_len)
+		{
+			stats.since = total;
+		}
+		while (printed < hits_len)
+		{
+			btk_vanity_print_hit(&hits[printed++], -1);
+		}
+		btk_vanity_get_stats(&stats, total, elapsed, rate);
+		pthread_mutex_unlock(&hits_lock);
+
+		if (elapsed - reported < VANITY_STATS_SECS)
+		{
+			continue;
+		}
+		reported = elapsed;
+
+		if (stats.eta > 0)
+		{
+			printf("\rWorkers: %-4d Estimated Seconds: %.0f of %.0f (%.1f%%)", workers_len, stats.elapsed, stats.eta, stats.success * 100);
+		}
+		else
+		{
+			printf("\rWorkers: %-4d Estimated Seconds: %.0f of ?", workers_len, stats.elapsed);
+		}
+		fflush(stdout);
+
+		if (stats_fd >= 0)
+		{
+			r = btk_vanity_write_stats(stats_fd, &stats);
+			if (r < 0)
+			{
+				stats_fd = -1;
+			}
+		}
+	}
+
+	vanitycoord_free(coord);
+	free(coord);
+
+	if (atomic_load(&vanity_state) == VANITY_ERROR)
+	{
+		error_log("Vanity search failed.");
+		return -1;
+	}
+
+	while (printed < hits_len)
+	{
+		btk_vanity_print_hit(&hits[printed++], -1);
+	}
+
+	return 1;
+}
+
+// Checks a hit reported by a worker. The key is recovered from the seed
+// and the offset, and its address has to match the pattern. Returns 0 for
+// a hit that does not.
+static int btk_vanity_accept(int id, unsigned long offset, int variant)
+{
+	int i, n, r, matched;
+	PrivKey priv;
+	PubKeyIter iter;
+	unsigned char *hashes;
+	char pubkey_str[OUTPUT_BUFFER];
+
+	if (id < 0 || id >= pattern_count)
+	{
+		return FALSE;
+	}
+	for (i = 0; i < variants_len && variants[i] != variant; ++i)
+		;
+	if (i == variants_len)
+	{
+		return FALSE;
+	}
+	if (patterns[id].format == OUTPUT_BECH32_ADDRESS && (variant & PUBKEY_VARIANT_UNCOMPRESSED))
+	{
+		return FALSE;
+	}
+
+	priv = malloc(privkey_sizeof());
+	iter = malloc(pubkey_iter_sizeof());
+	hashes = malloc(PUBKEY_ITER_BATCH * variants_len * candidate_len);
+	if (priv == NULL || iter == NULL || hashes == NULL)
+	{
+		error_log("Memory allocation error");
+		free(priv);
+		free(iter);
+		free(hashes);
+		return -1;
+	}
+
+	r = privkey_from_raw(priv, seed_raw, PRIVKEY_LENGTH);
+	if (r < 0)
+	{
+		error_log("Could not load seed key.");
+		free(priv);
+		free(iter);
+		free(hashes);
+		return -1;
+	}
+	privkey_add_uint(priv, offset);
+
+	r = pubkey_iter_init_offset(iter, priv, split_key);
+	free(priv);
+	if (r < 0)
+	{
+		error_log("Could not initialize public key iterator.");
+		free(iter);
+		free(hashes);
+		return -1;
+	}
+
+	// The key at offset is the first of the batch.
+	if (output_format == OUTPUT_TAPROOT_ADDRESS)
+	{
+		n = pubkey_iter_next_xonly_variants(hashes, iter, variants, variants_len, !input_untweaked);
+	}
+	else
+	{
+		n = pubkey_iter_next_hash160_variants(hashes, iter, variants, variants_len);
+	}
+	r = (n > 0) ? btk_vanity_get_address(pubkey_str, hashes + (i * candidate_len), patterns[id].format) : -1;
+	if (r < 0)
+	{
+		error_log("Could not calculate address.");
+		pubkey_iter_free(iter);
+		free(iter);
+		free(hashes);
+		return -1;
+	}
+
+	matched = btk_vanity_match(pubkey_str, &patterns[id]);
+	if (matched)
+	{
+		r = btk_vanity_report(id, variant, pubkey_str, iter, n - 1, offset);
+	}
+
+	pubkey_iter_free(iter);
+	free(iter);
+	free(hashes);
+
+	if (r < 0)
+	{
+		error_log("Could not report vanity address.");
+		return -1;
+	}
+
+	return matched;
+}
@@ -62,7 +62,13 @@ int base32_encode_raw(unsigned char *output, unsigned char *data, size_t data_le
 			}
 		}
 	}
-	r = ++k / 5;
+
+	// Pad a trailing partial group with zero bits.
+	if (k % 5 != 0)
+	{
+		*output <<= 5 - (k % 5);
+	}
+	r = (k + 4) / 5;
 
 	return r;
 }
@@ -7,14 +7,55 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <gmp.h>
 #include <assert.h>
 #include "error.h"
 
 #define BASE58_CODE_STRING_LENGTH 58
+#define BASE58_BASE               58
+
+// Inputs up to BASE58_LIMBS * 8 bytes, and strings up to BASE58_CHARS_MAX
+// characters, are converted with fixed size 64 bit limbs instead of GMP.
+// That covers addresses (25 bytes) and WIF keys (37 or 38 bytes).
+#define BASE58_LIMBS              5
+#define BASE58_CHARS_MAX          54
+#define BASE58_GROUP_DIGITS       10
+#define BASE58_GROUPS             7
+
+typedef unsigned __int128 uint128_t;
+
+static int base58_encode_limbs(char *, unsigned char *, size_t);
+static int base58_decode_limbs(unsigned char *, char *, size_t);
 
 static char *code_string = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
 
+// The value of each base58 character, or -1.
+static const signed char base58_map[256] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, 0, 1, 2, 3, 4, 5, 6, 7, 8, -1, -1, -1, -1, -1, -1,
+	-1, 9, 10, 11, 12, 13, 14, 15, 16, -1, 17, 18, 19, 20, 21, -1,
+	22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, -1, -1, -1, -1, -1,
+	-1, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, -1, 44, 45, 46,
+	47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+// base58_pow58[i] = 58^i
+static const uint64_t base58_pow58[BASE58_GROUP_DIGITS + 1] = {
+	1ULL, 58ULL, 3364ULL, 195112ULL, 11316496ULL, 656356768ULL,
+	38068692544ULL, 2207984167552ULL, 128063081718016ULL, 7427658739644928ULL, 430804206899405824ULL
+};
+
 int base58_encode(char *output, unsigned char *input, size_t input_len)
 {
 	int i, j;
@@ -25,6 +66,11 @@ int base58_encode(char *output, unsigned char *input, size_t input_len)
 	assert(input);
 	assert(input_len);
 
+	if (input_len <= BASE58_LIMBS * 8)
+	{
+		return base58_encode_limbs(output, input, input_len);
+	}
+
 	mpz_init(x);
 	mpz_init(r);
 	mpz_init(d);
@@ -38,7 +84,7 @@ int base58_encode(char *output, unsigned char *input, size_t input_len)
 		mpz_tdiv_qr(x, r, x, d);
 		output[i] = code_string[mpz_get_ui(r)];
 	}
-	for (j = 0; input[j] == 0; ++j, ++i)
+	for (j = 0; j < (int)input_len && input[j] == 0; ++j, ++i)
 	{
 		output[i] = code_string[0];
 	}
@@ -69,6 +115,11 @@ int base58_decode(unsigned char *output, char *input)
 	assert(output);
 
 	input_len = strlen(input);
+
+	if (input_len <= BASE58_CHARS_MAX)
+	{
+		return base58_decode_limbs(output, input, input_len);
+	}
 	
 	mpz_init(x);
 	mpz_init(b);
@@ -78,12 +129,12 @@ int base58_decode(unsigned char *output, char *input)
 	
 	for (i = 0; i < (int)input_len; ++i)
 	{
-		for (j = 0; j < BASE58_CODE_STRING_LENGTH && code_string[j] != input[i]; ++j)
-			;
-
-		if (j >= BASE58_CODE_STRING_LENGTH)
+		j = base58_map[(unsigned char)input[i]];
+		if (j < 0)
 		{
 			error_log("Input contains invalid base58 character at index %i (0x%02x).", i, input[i]);
+			mpz_clear(x);
+			mpz_clear(b);
 			return -1;
 		}
 
@@ -101,10 +152,140 @@ int base58_decode(unsigned char *output, char *input)
 
 int base58_ischar(char c)
 {
-	int i;
+	return (base58_map[(unsigned char)c] >= 0);
+}
+
+int base58_get_raw(char c)
+{
+	assert(c);
+
+	if (base58_map[(unsigned char)c] < 0)
+	{
+		error_log("Invalid base58 character: 0x%02x.", c);
+		return -1;
+	}
+
+	return base58_map[(unsigned char)c];
+}
+
+static int base58_encode_limbs(char *output, unsigned char *input, size_t input_len)
+{
+	int i, j, zeros, top, groups, len;
+	uint64_t n[BASE58_LIMBS], v;
+	uint64_t group[BASE58_GROUPS];
+	uint128_t t;
 
-	for (i = 0; i < BASE58_CODE_STRING_LENGTH && code_string[i] != c; ++i)
+	// Each leading zero byte is encoded as a '1'.
+	for (zeros = 0; zeros < (int)input_len && input[zeros] == 0; ++zeros)
 		;
 
-	return (i < BASE58_CODE_STRING_LENGTH);
+	memset(n, 0, sizeof(n));
+	for (i = 0; i < (int)input_len; ++i)
+	{
+		j = (int)input_len - 1 - i;
+		n[j / 8] |= (uint64_t)input[i] << ((j % 8) * 8);
+	}
+	top = ((int)input_len + 7) / 8;
+	while (top > 0 && n[top - 1] == 0)
+	{
+		--top;
+	}
+
+	// Dividing by 58^10 gives ten digits at a time, least significant
+	// group first.
+	for (groups = 0; top > 0; ++groups)
+	{
+		t = 0;
+		for (j = top - 1; j >= 0; --j)
+		{
+			t = (t << 64) | n[j];
+			n[j] = (uint64_t)(t / base58_pow58[BASE58_GROUP_DIGITS]);
+			t %= base58_pow58[BASE58_GROUP_DIGITS];
+		}
+		group[groups] = (uint64_t)t;
+
+		while (top > 0 && n[top - 1] == 0)
+		{
+			--top;
+		}
+	}
+
+	// Only the top group can be short.
+	len = 0;
+	if (groups > 0)
+	{
+		len = (groups - 1) * BASE58_GROUP_DIGITS;
+		for (v = group[groups - 1]; v > 0; v /= BASE58_BASE)
+		{
+			++len;
+		}
+	}
+
+	memset(output, code_string[0], zeros);
+	for (i = 0; i < len; ++i)
+	{
+		v = group[i / BASE58_GROUP_DIGITS] / base58_pow58[i % BASE58_GROUP_DIGITS];
+		output[zeros + len - 1 - i] = code_string[v % BASE58_BASE];
+	}
+	output[zeros + len] = '\0';
+
+	return 1;
+}
+
+static int base58_decode_limbs(unsigned char *output, char *input, size_t input_len)
+{
+	int i, j, k, top, len, d;
+	uint64_t n[BASE58_LIMBS], v;
+	uint128_t t;
+
+	// Up to ten characters make one multiply-add over the limbs. 58^54
+	// is below 2^320, so the limbs can't overflow.
+	memset(n, 0, sizeof(n));
+	top = 0;
+	for (i = 0; i < (int)input_len; i += k)
+	{
+		k = (int)input_len - i;
+		if (k > BASE58_GROUP_DIGITS)
+		{
+			k = BASE58_GROUP_DIGITS;
+		}
+
+		v = 0;
+		for (j = i; j < i + k; ++j)
+		{
+			d = base58_map[(unsigned char)input[j]];
+			if (d < 0)
+			{
+				error_log("Input contains invalid base58 character at index %i (0x%02x).", j, input[j]);
+				return -1;
+			}
+			v = (v * BASE58_BASE) + d;
+		}
+
+		t = v;
+		for (j = 0; j < top; ++j)
+		{
+			t += (uint128_t)n[j] * base58_pow58[k];
+			n[j] = (uint64_t)t;
+			t >>= 64;
+		}
+		if (t > 0)
+		{
+			n[top++] = (uint64_t)t;
+		}
+	}
+
+	// Big endian, without leading zeros, like mpz_export().
+	len = 0;
+	for (i = (top * 8) - 1; i >= 0; --i)
+	{
+		v = (n[i / 8] >> ((i % 8) * 8)) & 0xff;
+		if (len == 0 && v == 0)
+		{
+			continue;
+		}
+		output[len++] = (unsigned char)v;
+	}
+
+	return len;
 }
@@ -11,5 +11,6 @@
 int base58_encode(char *, unsigned char *, size_t);
 int base58_decode(unsigned char *, char *);
 int base58_ischar(char);
+int base58_get_raw(char);
 
 #endif
@@ -79,14 +79,11 @@ int base58check_decode(unsigned char *output, char *input, int type) {
 		// Leading zeros are lost in the decoding algorithm and
 		// only mainnet addresses have this requirement because
 		// the mainnet flag itself is a zero.
-		while (r < 25)
+		if (r < 25)
 		{
-			for (i = 0; i < 24; i++)
-			{
-				output[24 - i] = output[24 - 1 - i];
-				output[24 - 1 - i] = 0x00;
-			}
-			r++;
+			memmove(output + (25 - r), output, r);
+			memset(output, 0, 25 - r);
+			r = 25;
 		}
 	}
 
@@ -118,4 +115,115 @@ int base58check_decode(unsigned char *output, char *input, int type) {
 	}
 
 	return len;
-}
\ No newline at end of file
+}
+
+int base58check_decode_batch(unsigned char *output, int *valid, char **input, size_t n, size_t len)
+{
+	int r, count;
+	size_t i, j, zeros, input_len, raw_len;
+	unsigned char *raw, *record, *checksums, *sha;
+
+	assert(output);
+	assert(valid);
+	assert(input);
+	assert(len);
+
+	raw_len = len + CHECKSUM_LENGTH;
+
+	// Base58 takes more characters than bytes, so a decoded string
+	// always fits in twice the expected length. The whole record, with
+	// its leading zeros, follows.
+	raw = malloc(raw_len * 3);
+	checksums = malloc(n * CHECKSUM_LENGTH);
+	sha = malloc(n * 32);
+	if (raw == NULL || checksums == NULL || sha == NULL)
+	{
+		error_log("Memory allocation error.");
+		free(raw);
+		free(checksums);
+		free(sha);
+		return -1;
+	}
+
+	record = raw + (raw_len * 2);
+
+	memset(output, 0, n * len);
+	memset(checksums, 0, n * CHECKSUM_LENGTH);
+
+	for (i = 0; i < n; ++i)
+	{
+		valid[i] = 0;
+
+		// Screen the characters first so that bad input is only marked
+		// invalid, and never fills the error log.
+		input_len = strlen(input[i]);
+		if (input_len == 0 || input_len > raw_len * 2)
+		{
+			continue;
+		}
+		for (j = 0; j < input_len; ++j)
+		{
+			if (!base58_ischar(input[i][j]))
+			{
+				break;
+			}
+		}
+		if (j < input_len)
+		{
+			continue;
+		}
+
+		r = base58_decode(raw, input[i]);
+		if (r < 0)
+		{
+			error_log("Could not decode input from base58.");
+			free(raw);
+			free(checksums);
+			free(sha);
+			return -1;
+		}
+
+		// Each leading '1' stands for a zero byte that the decoder drops,
+		// so the data goes straight in after them without any shifting.
+		for (zeros = 0; input[i][zeros] == '1'; ++zeros)
+			;
+		if (zeros + r != raw_len)
+		{
+			continue;
+		}
+
+		memset(record, 0, zeros);
+		memcpy(record + zeros, raw, r);
+		memcpy(output + (i * len), record, len);
+		memcpy(checksums + (i * CHECKSUM_LENGTH), record + len, CHECKSUM_LENGTH);
+		valid[i] = 1;
+	}
+
+	// All the checksums are taken in one batch. Entries that did not
+	// decode are hashed along with the rest and ignored.
+	r = crypto_get_hash256_batch(sha, output, len, n);
+	if (r < 0)
+	{
+		error_log("Could not generate checksums from decoded data.");
+		free(raw);
+		free(checksums);
+		free(sha);
+		return -1;
+	}
+
+	count = 0;
+	for (i = 0; i < n; ++i)
+	{
+		if (valid[i] && memcmp(sha + (i * 32), checksums + (i * CHECKSUM_LENGTH), CHECKSUM_LENGTH) != 0)
+		{
+			valid[i] = 0;
+		}
+		count += valid[i];
+	}
+
+	free(raw);
+	free(checksums);
+	free(sha);
+
+	return count;
+}
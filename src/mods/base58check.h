@@ -8,10 +8,13 @@
 #ifndef BASE58CHECK_H
 #define BASE58CHECK_H 1
 
+#include <stddef.h>
+
 #define BASE58CHECK_TYPE_NA              0
 #define BASE58CHECK_TYPE_ADDRESS_MAINNET 1
 
 int base58check_encode(char *, unsigned char *, size_t);
 int base58check_decode(unsigned char *, char *, int);
+int base58check_decode_batch(unsigned char *, int *, char **, size_t, size_t);
 
 #endif
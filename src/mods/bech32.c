@@ -7,10 +7,12 @@
 
 #include <stddef.h>
 #include <string.h>
+#include <ctype.h>
+#include <strings.h>
 #include <stdint.h>
+#include <pthread.h>
 #include <assert.h>
 #include "bech32.h"
-#include "base32.h"
 #include "network.h"
 #include "error.h"
 
@@ -18,119 +20,393 @@
 #define BECH32_PREFIX_TESTNET         "tb"
 #define BECH32_SEPARATOR              '1'
 #define BECH32_VERSION_BYTE           0
+#define BECH32M_VERSION_BYTE          1
 #define BECH32_CHECKSUM_LENGTH        6
+#define BECH32_CONSTANT               1
+#define BECH32M_CONSTANT              0x2bc830a3
+#define BECH32_PROGRAM_MIN            2
+#define BECH32_VERSION_MAX            16
 
-static uint32_t bech32_polymod_step(uint8_t value, uint32_t chk);
+static int bech32_encode_prefix(char *, uint32_t *, int);
+static void bech32_encode_data(char *, uint32_t, unsigned char *, size_t, uint32_t);
+static uint32_t bech32_polymod(uint32_t, uint8_t *, size_t);
+static uint32_t bech32_polymod_step(uint32_t, uint8_t);
+static int bech32_program_is_valid(int, size_t);
+static void bech32_table_init(void);
+
+static const char bech32_charset[] = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+
+// Symbol values by character, upper and lower case alike, or -1.
+static const signed char bech32_map[128] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	15, -1, 10, 17, 21, 20, 26, 30, 7, 5, -1, -1, -1, -1, -1, -1,
+	-1, 29, -1, 24, 13, 25, 9, 8, 23, -1, 18, 22, 31, 27, 19, -1,
+	1, 0, 3, 16, 11, 28, 12, 14, 6, 4, 2, -1, -1, -1, -1, -1,
+	-1, 29, -1, 24, 13, 25, 9, 8, 23, -1, 18, 22, 31, 27, 19, -1,
+	1, 0, 3, 16, 11, 28, 12, 14, 6, 4, 2, -1, -1, -1, -1, -1
+};
+
+static const uint32_t bech32_gen[5] = {0x3b6a57b2, 0x26508e6d, 0x1ea119fa, 0x3d4233dd, 0x2a1462b3};
+
+// The checksum is linear, so the generator terms that the top bits of
+// the state feed in can be looked up. bech32_table takes the top 10 bits
+// through two symbols at once, bech32_table_step the top 5 through one.
+static uint32_t bech32_table[1024];
+static uint32_t bech32_table_step[32];
+static pthread_once_t bech32_table_once = PTHREAD_ONCE_INIT;
 
 int bech32_get_address(char *output, unsigned char *data, size_t data_len)
 {
-	int i, l, c, r;
-	char *hrp;
-	uint32_t chk;
+	assert(output);
+	assert(data);
+	assert(data_len);
+	// Version 0 programs are a P2WPKH hash160 or a P2WSH sha256.
+	assert(data_len == 20 || data_len == 32);
 
+	return bech32_get_witness_address(output, BECH32_VERSION_BYTE, data, data_len);
+}
+
+int bech32m_get_address(char *output, unsigned char *data, size_t data_len)
+{
 	assert(output);
 	assert(data);
 	assert(data_len);
-	// For now I'm only supporting P2WPKH so the data length can only be 20
-	assert(data_len == 20);
+	// Version 1 witness programs are 32 byte taproot output keys (BIP 341).
+	assert(data_len == 32);
 
-	chk = 1;
+	return bech32_get_witness_address(output, BECH32M_VERSION_BYTE, data, data_len);
+}
 
-	// Get human readable part (hrp)
-	if (network_is_main())
+int bech32_get_witness_address(char *output, int version, unsigned char *data, size_t data_len)
+{
+	int r;
+	uint32_t chk;
+
+	assert(output);
+	assert(data);
+	assert(bech32_program_is_valid(version, data_len));
+
+	r = bech32_encode_prefix(output, &chk, version);
+
+	// Version 0 takes the bech32 checksum (BIP 173), later versions the
+	// bech32m one (BIP 350). They differ only in the final constant.
+	bech32_encode_data(output + r, chk, data, data_len, (version == 0) ? BECH32_CONSTANT : BECH32M_CONSTANT);
+
+	return 1;
+}
+
+int bech32_get_witness_address_batch(char *output, int version, unsigned char *data, size_t data_len, size_t n)
+{
+	int r;
+	size_t i;
+	uint32_t chk;
+
+	assert(output);
+	assert(data);
+	assert(bech32_program_is_valid(version, data_len));
+
+	// The n programs are data_len bytes each, one after the other. Their
+	// addresses are written BECH32_ADDRESS_MAX + 1 bytes apart. All of
+	// them share a prefix, so it is encoded and checksummed only once.
+	r = bech32_encode_prefix(output, &chk, version);
+	for (i = 0; i < n; ++i)
 	{
-		hrp = BECH32_PREFIX_MAINNET;
+		if (i > 0)
+		{
+			memcpy(output + (i * (BECH32_ADDRESS_MAX + 1)), output, r);
+		}
+		bech32_encode_data(output + (i * (BECH32_ADDRESS_MAX + 1)) + r, chk, data + (i * data_len), data_len, (version == 0) ? BECH32_CONSTANT : BECH32M_CONSTANT);
 	}
-	else if (network_is_test())
+
+	return 1;
+}
+
+int bech32_get_program(unsigned char *output, int *version, char *address)
+{
+	int v, lower, upper;
+	size_t i, n, len, sep, output_len;
+	uint32_t chk, bits, value;
+	uint8_t values[BECH32_ADDRESS_MAX * 2];
+	char c;
+
+	assert(output);
+	assert(version);
+	assert(address);
+
+	len = strlen(address);
+	if (len > BECH32_ADDRESS_MAX)
 	{
-		hrp = BECH32_PREFIX_TESTNET;
+		error_log("Bech32 address can not exceed %i characters.", BECH32_ADDRESS_MAX);
+		return -1;
 	}
 
-	// hrp
-	l = strlen(hrp);
-	for (i = 0; i < l; ++i)
+	// The separator is the last '1', as the hrp may contain others.
+	sep = 0;
+	lower = upper = 0;
+	for (i = 0; i < len; ++i)
 	{
-		*(output++) = hrp[i];
-		chk = bech32_polymod_step((hrp[i] >> 5), chk);
+		c = address[i];
+		if (c < 33 || c > 126)
+		{
+			error_log("Bech32 address contains an invalid character.");
+			return -1;
+		}
+		lower |= islower(c) ? 1 : 0;
+		upper |= isupper(c) ? 1 : 0;
+		if (c == BECH32_SEPARATOR)
+		{
+			sep = i;
+		}
 	}
-	chk = bech32_polymod_step(0, chk);
-	for (i = 0; i < l; ++i)
+	if (lower && upper)
 	{
-		chk = bech32_polymod_step((hrp[i] & 31), chk);
+		error_log("Bech32 address can not mix upper and lower case.");
+		return -1;
 	}
-
-	// separator
-	*(output++) = BECH32_SEPARATOR;
-
-	// version byte
-	c = base32_get_char(BECH32_VERSION_BYTE);
-	if (c < 0)
+	if (sep == 0 || sep + 1 + BECH32_CHECKSUM_LENGTH >= len)
 	{
-		error_log("Could not encode version byte to base32.");
+		error_log("Bech32 address is missing its separator or data.");
 		return -1;
 	}
-	*(output++) = (char)c;
-	chk = bech32_polymod_step(BECH32_VERSION_BYTE, chk);
 
-	// data
-	r = base32_encode(output, data, data_len);
-	if (r < 0)
+	// Get network from the human readable part (hrp)
+	if (sep == strlen(BECH32_PREFIX_MAINNET) && strncasecmp(address, BECH32_PREFIX_MAINNET, sep) == 0)
+	{
+		network_set_main();
+	}
+	else if (sep == strlen(BECH32_PREFIX_TESTNET) && strncasecmp(address, BECH32_PREFIX_TESTNET, sep) == 0)
+	{
+		network_set_test();
+	}
+	else
 	{
-		error_log("Could not encode input to base32.");
+		error_log("Bech32 address has an unknown prefix.");
 		return -1;
 	}
-	l = strlen(output);
-	for (i = 0; i < l; ++i)
+
+	// The checksum covers the expanded hrp and every data symbol.
+	n = 0;
+	for (i = 0; i < sep; ++i)
 	{
-		r = base32_get_raw(*output);
-		if (r < 0)
+		values[n++] = tolower(address[i]) >> 5;
+	}
+	values[n++] = 0;
+	for (i = 0; i < sep; ++i)
+	{
+		values[n++] = tolower(address[i]) & 31;
+	}
+	for (i = sep + 1; i < len; ++i)
+	{
+		v = bech32_map[(unsigned char)address[i]];
+		if (v < 0)
 		{
-			error_log("Could not determine base32 character value.");
+			error_log("Bech32 address contains an invalid character.");
 			return -1;
 		}
-		chk = bech32_polymod_step(r, chk);
-		output++;
+		values[n++] = (uint8_t)v;
 	}
 
-	// trailing zeros needed for checksum
-	for (i = 0; i < 6; ++i)
+	pthread_once(&bech32_table_once, bech32_table_init);
+	chk = bech32_polymod(1, values, n);
+
+	*version = values[n - (len - sep - 1)];
+	if (*version > BECH32_VERSION_MAX)
 	{
-		chk = bech32_polymod_step(0, chk);
+		error_log("Invalid witness version %i.", *version);
+		return -1;
 	}
 
-	chk ^= 1;
+	// Version 0 takes the bech32 checksum, later versions bech32m.
+	if (chk != ((*version == 0) ? BECH32_CONSTANT : BECH32M_CONSTANT))
+	{
+		error_log("Bech32 address contains an invalid checksum.");
+		return -1;
+	}
 
-	// get/append checksum
-	for (i = 0; i < BECH32_CHECKSUM_LENGTH; ++i)
+	// The data between the version and the checksum is regrouped from 5
+	// to 8 bits.
+	bits = 0;
+	value = 0;
+	output_len = 0;
+	for (i = n - (len - sep - 2); i < n - BECH32_CHECKSUM_LENGTH; ++i)
 	{
-		c = base32_get_char((chk >> (5 * (5 - i))) & 31);
-		if (c < 0)
+		value = ((value << 5) | values[i]) & 0xfff;
+		bits += 5;
+		if (bits >= 8)
 		{
-			error_log("Could not determine bech32 checksum.");
-			return -1;
+			bits -= 8;
+			if (output_len == BECH32_PROGRAM_MAX)
+			{
+				error_log("Witness program can not exceed %i bytes.", BECH32_PROGRAM_MAX);
+				return -1;
+			}
+			output[output_len++] = (value >> bits) & 0xff;
 		}
-		*(output++) = (char)c;
 	}
 
-	*output = '\0';
+	if (bits >= 5 || (value & ((1 << bits) - 1)) != 0)
+	{
+		error_log("Bech32 address contains invalid padding.");
+		return -1;
+	}
+	if (!bech32_program_is_valid(*version, output_len))
+	{
+		error_log("Invalid witness program length %i for version %i.", (int)output_len, *version);
+		return -1;
+	}
 
-	return 1;
-	
+	return (int)output_len;
 }
 
+// Writes the hrp, separator and version character, and returns how many
+// characters that took. chk gets the checksum state after them.
+static int bech32_encode_prefix(char *output, uint32_t *chk, int version)
+{
+	size_t i, n, hrp_len;
+	uint8_t values[16];
+	char *hrp;
+
+	// Get human readable part (hrp)
+	if (network_is_test())
+	{
+		hrp = BECH32_PREFIX_TESTNET;
+	}
+	else
+	{
+		hrp = BECH32_PREFIX_MAINNET;
+	}
+	hrp_len = strlen(hrp);
+
+	n = 0;
+	for (i = 0; i < hrp_len; ++i)
+	{
+		values[n++] = hrp[i] >> 5;
+	}
+	values[n++] = 0;
+	for (i = 0; i < hrp_len; ++i)
+	{
+		values[n++] = hrp[i] & 31;
+	}
+	values[n++] = version;
+
+	pthread_once(&bech32_table_once, bech32_table_init);
+	*chk = bech32_polymod(1, values, n);
+
+	memcpy(output, hrp, hrp_len);
+	output[hrp_len] = BECH32_SEPARATOR;
+	output[hrp_len + 1] = bech32_charset[version];
+
+	return (int)hrp_len + 2;
+}
 
-static uint32_t bech32_polymod_step(uint8_t value, uint32_t chk)
+// Writes the data characters and checksum, and terminates the string.
+static void bech32_encode_data(char *output, uint32_t chk, unsigned char *data, size_t data_len, uint32_t constant)
+{
+	size_t i, n;
+	uint32_t bits, value;
+	uint8_t values[BECH32_ADDRESS_MAX];
+
+	// Regroup the data from 8 to 5 bits, padding the last group with
+	// zeros. The trailing zero symbols make room for the checksum.
+	n = 0;
+	bits = 0;
+	value = 0;
+	for (i = 0; i < data_len; ++i)
+	{
+		value = ((value << 8) | data[i]) & 0xfff;
+		bits += 8;
+		while (bits >= 5)
+		{
+			bits -= 5;
+			values[n++] = (value >> bits) & 31;
+		}
+	}
+	if (bits > 0)
+	{
+		values[n++] = (value << (5 - bits)) & 31;
+	}
+	for (i = 0; i < BECH32_CHECKSUM_LENGTH; ++i)
+	{
+		values[n++] = 0;
+	}
+
+	chk = bech32_polymod(chk, values, n) ^ constant;
+	for (i = 0; i < BECH32_CHECKSUM_LENGTH; ++i)
+	{
+		values[n - BECH32_CHECKSUM_LENGTH + i] = (chk >> (5 * (5 - i))) & 31;
+	}
+
+	for (i = 0; i < n; ++i)
+	{
+		output[i] = bech32_charset[values[i]];
+	}
+	output[n] = '\0';
+}
+
+// Runs the checksum over values, two symbols per table lookup.
+static uint32_t bech32_polymod(uint32_t chk, uint8_t *values, size_t values_len)
 {
 	size_t i;
-	uint8_t b;
-	uint32_t gen[5] = {0x3b6a57b2, 0x26508e6d, 0x1ea119fa, 0x3d4233dd, 0x2a1462b3};
 
-	b = (chk >> 25);
-	chk = (chk & 0x1ffffff) << 5 ^ value;
-	for (i = 0; i < 5; ++i)
+	for (i = 0; i + 1 < values_len; i += 2)
+	{
+		chk = ((chk & 0xfffff) << 10) ^ bech32_table[chk >> 20] ^ ((uint32_t)values[i] << 5) ^ values[i + 1];
+	}
+	if (i < values_len)
 	{
-		chk ^= ((b >> i) & 1) ? gen[i] : 0;
+		chk = bech32_polymod_step(chk, values[i]);
 	}
 
 	return chk;
 }
+
+static uint32_t bech32_polymod_step(uint32_t chk, uint8_t value)
+{
+	return ((chk & 0x1ffffff) << 5) ^ bech32_table_step[chk >> 25] ^ value;
+}
+
+static int bech32_program_is_valid(int version, size_t program_len)
+{
+	if (version < 0 || version > BECH32_VERSION_MAX)
+	{
+		return 0;
+	}
+	if (program_len < BECH32_PROGRAM_MIN || program_len > BECH32_PROGRAM_MAX)
+	{
+		return 0;
+	}
+	if (version == 0 && program_len != 20 && program_len != 32)
+	{
+		return 0;
+	}
+
+	return 1;
+}
+
+static void bech32_table_init(void)
+{
+	size_t i, j;
+	uint32_t chk;
+
+	for (i = 0; i < 32; ++i)
+	{
+		chk = 0;
+		for (j = 0; j < 5; ++j)
+		{
+			if ((i >> j) & 1)
+			{
+				chk ^= bech32_gen[j];
+			}
+		}
+		bech32_table_step[i] = chk;
+	}
+
+	// Two zero symbols shifted through a state holding only these 10 bits.
+	for (i = 0; i < 1024; ++i)
+	{
+		chk = bech32_polymod_step((uint32_t)i << 20, 0);
+		bech32_table[i] = bech32_polymod_step(chk, 0);
+	}
+}
@@ -10,6 +10,13 @@
 
 #include <stddef.h>
 
+#define BECH32_ADDRESS_MAX            90
+#define BECH32_PROGRAM_MAX            40
+
 int bech32_get_address(char *, unsigned char *, size_t);
+int bech32m_get_address(char *, unsigned char *, size_t);
+int bech32_get_witness_address(char *, int, unsigned char *, size_t);
+int bech32_get_witness_address_batch(char *, int, unsigned char *, size_t, size_t);
+int bech32_get_program(unsigned char *, int *, char *);
 
 #endif
\ No newline at end of file
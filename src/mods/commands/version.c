@@ -242,20 +242,16 @@ int version_to_json(char *output, Version v)
 	output += version_services_to_json(output, v->addr_recv_services);
 	output += sprintf(output, "  },\n");
 	output += sprintf(output, "  \"addr_recv_ip_address\": \"");
-	for(i = 0; i < IP_ADDR_FIELD_LEN; ++i)
-	{
-		output += sprintf(output, "%02x", v->addr_recv_ip_address[i]);
-	}
+	hex_encode(output, v->addr_recv_ip_address, IP_ADDR_FIELD_LEN);
+	output += IP_ADDR_FIELD_LEN * 2;
 	output += sprintf(output, "\",\n");
 	output += sprintf(output, "  \"addr_recv_port\": %"PRIu16",\n", v->addr_recv_port);
 	output += sprintf(output, "  \"addr_trans_services\": {\n");
 	output += version_services_to_json(output, v->addr_trans_services);
 	output += sprintf(output, "  },\n");
 	output += sprintf(output, "  \"addr_trans_ip_address\": \"");
-	for(i = 0; i < IP_ADDR_FIELD_LEN; ++i)
-	{
-		output += sprintf(output, "%02x", v->addr_trans_ip_address[i]);
-	}
+	hex_encode(output, v->addr_trans_ip_address, IP_ADDR_FIELD_LEN);
+	output += IP_ADDR_FIELD_LEN * 2;
 	output += sprintf(output, "\",\n");
 	output += sprintf(output, "  \"addr_trans_port\": %"PRIu16",\n", v->addr_trans_port);
 	output += sprintf(output, "  \"nonce\": %"PRIu64",\n", v->nonce);
@@ -7,79 +7,119 @@
 
 #include <string.h>
 #include <stdint.h>
-#include <gcrypt.h>
 #include <assert.h>
 #include "crypto.h"
+#include "sha256.h"
+#include "rmd160.h"
 #include "error.h"
 
-static int crypto_init(void)
+// Inputs hashed per pass in the batch functions, bounding the stack space
+// taken by the intermediate digests.
+#define CRYPTO_HASH160_CHUNK    256
+#define CRYPTO_HASH256_CHUNK    256
+
+int crypto_get_sha256(unsigned char *output, unsigned char *input, size_t input_len)
 {
-	static int isInit = 0;
+	assert(output);
+	assert(input);
+	assert(input_len);
 
-	if (!isInit)
-	{
-		if (!gcry_check_version(GCRYPT_VERSION))
-		{
-			error_log("Libgcrypt version mismatch.");
-			return -1;
-		}
-		gcry_control(GCRYCTL_SUSPEND_SECMEM_WARN);
-		gcry_control(GCRYCTL_INIT_SECMEM, 16384, 0);
-		gcry_control(GCRYCTL_RESUME_SECMEM_WARN);
-		gcry_control(GCRYCTL_INITIALIZATION_FINISHED, 0);
+	// In-tree SHA-256, using the SHA extensions when the processor has them.
+	sha256_hash(output, input, input_len);
 
-		isInit = 1;
-	}
+	return 1;
+}
+
+int crypto_get_rmd160(unsigned char *output, unsigned char *input, size_t input_len)
+{
+	assert(output);
+	assert(input);
+	assert(input_len);
+
+	rmd160_hash(output, input, input_len);
 
 	return 1;
 }
 
-int crypto_get_sha256(unsigned char *output, unsigned char *input, size_t input_len)
+int crypto_get_hash160(unsigned char *output, unsigned char *input, size_t input_len)
 {
-	gcry_md_hd_t gc;
-	
+	unsigned char sha[32];
+
 	assert(output);
 	assert(input);
 	assert(input_len);
 
-	if (crypto_init() < 0)
-	{
-		error_log("Could not initialize encryption library.");
-		return -1;
-	}
-	
-	gcry_md_open(&gc, GCRY_MD_SHA256, 0);
-	
-	gcry_md_write(gc, input, input_len);
-	
-	memcpy(output, gcry_md_read(gc, 0), 32);
-	
-	gcry_md_close(gc);
-	
+	// RMD(SHA(data))
+	sha256_hash(sha, input, input_len);
+	rmd160_hash(output, sha, 32);
+
 	return 1;
 }
 
-int crypto_get_rmd160(unsigned char *output, unsigned char *input, size_t input_len)
+int crypto_get_hash160_batch(unsigned char *output, unsigned char *input, size_t input_len, size_t n)
 {
-	gcry_md_hd_t gc;
-	
+	size_t i, len;
+	unsigned char sha[CRYPTO_HASH160_CHUNK * 32];
+
 	assert(output);
 	assert(input);
 	assert(input_len);
-	
-	if (crypto_init() < 0)
+
+	// The n inputs are input_len bytes each, one after the other, like
+	// the public keys of an iterator batch. Equal lengths let both hashes
+	// run several messages in parallel lanes.
+	for (i = 0; i < n; i += len)
 	{
-		error_log("Could not initialize encryption library.");
-		return -1;
+		len = n - i;
+		if (len > CRYPTO_HASH160_CHUNK)
+		{
+			len = CRYPTO_HASH160_CHUNK;
+		}
+
+		sha256_hash_batch(sha, input + (i * input_len), input_len, len);
+		rmd160_hash_batch(output + (i * 20), sha, 32, len);
 	}
 
-	gcry_md_open(&gc, GCRY_MD_RMD160, 0);
+	return 1;
+}
+
+int crypto_get_hash256(unsigned char *output, unsigned char *input, size_t input_len)
+{
+	unsigned char sha[32];
+
+	assert(output);
+	assert(input);
+	assert(input_len);
+
+	// SHA(SHA(data))
+	sha256_hash(sha, input, input_len);
+	sha256_hash(output, sha, 32);
+
+	return 1;
+}
+
+int crypto_get_hash256_batch(unsigned char *output, unsigned char *input, size_t input_len, size_t n)
+{
+	size_t i, len;
+	unsigned char sha[CRYPTO_HASH256_CHUNK * 32];
 
-	gcry_md_write(gc, input, input_len);
+	assert(output);
+	assert(input);
+	assert(input_len);
 
-	memcpy(output, gcry_md_read(gc, 0), 20);
+	// Same layout as crypto_get_hash160_batch(), for checksumming many
+	// payloads of one length, like the addresses of a batch.
+	for (i = 0; i < n; i += len)
+	{
+		len = n - i;
+		if (len > CRYPTO_HASH256_CHUNK)
+		{
+			len = CRYPTO_HASH256_CHUNK;
+		}
 
-	gcry_md_close(gc);
+		sha256_hash_batch(sha, input + (i * input_len), input_len, len);
+		sha256_hash_batch(output + (i * 32), sha, 32, len);
+	}
 
 	return 1;
 }
@@ -87,49 +127,50 @@ int crypto_get_rmd160(unsigned char *output, unsigned char *input, size_t input_
 int crypto_get_checksum(uint32_t *output, unsigned char *data, size_t len)
 {
 	int r;
-	unsigned char *sha1, *sha2;
+	unsigned char sha[32];
 
 	assert(output);
 	assert(data);
 	assert(len);
 
-	sha1 = malloc(32);
-	if (sha1 == NULL)
-	{
-		error_log("Memory allocation error.");
-		return -1;
-	}
-	sha2 = malloc(32);
-	if (sha2 == NULL)
-	{
-		error_log("Memory allocation error.");
-		return -1;
-	}
-
-	r = crypto_get_sha256(sha1, data, len);
-	if (r < 0)
-	{
-		error_log("Could not generate SHA256 hash for input.");
-		return -1;
-	}
-	r = crypto_get_sha256(sha2, sha1, 32);
+	r = crypto_get_hash256(sha, data, len);
 	if (r < 0)
 	{
 		error_log("Could not generate SHA256 hash for input.");
 		return -1;
 	}
 
-	*output <<= 8;
-	*output += sha2[0];
-	*output <<= 8;
-	*output += sha2[1];
-	*output <<= 8;
-	*output += sha2[2];
-	*output <<= 8;
-	*output += sha2[3];
-	
-	free(sha1);
-	free(sha2);
-	
+	// The first four bytes, big endian.
+	*output = ((uint32_t)sha[0] << 24) | ((uint32_t)sha[1] << 16) | ((uint32_t)sha[2] << 8) | sha[3];
+
+	return 1;
+}
+
+int crypto_sha256_init(Sha256 ctx)
+{
+	assert(ctx);
+
+	sha256_init(ctx);
+
+	return 1;
+}
+
+int crypto_sha256_update(Sha256 ctx, unsigned char *input, size_t input_len)
+{
+	assert(ctx);
+	assert(input || input_len == 0);
+
+	sha256_update(ctx, input, input_len);
+
+	return 1;
+}
+
+int crypto_sha256_final(unsigned char *output, Sha256 ctx)
+{
+	assert(output);
+	assert(ctx);
+
+	sha256_final(output, ctx);
+
 	return 1;
 }
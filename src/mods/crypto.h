@@ -8,10 +8,19 @@
 #ifndef CRYPTO_H
 #define CRYPTO_H 1
 
+#include <stddef.h>
 #include <stdint.h>
+#include "sha256.h"
 
 int crypto_get_sha256(unsigned char *, unsigned char *, size_t);
 int crypto_get_rmd160(unsigned char *, unsigned char *, size_t);
+int crypto_get_hash160(unsigned char *, unsigned char *, size_t);
+int crypto_get_hash160_batch(unsigned char *, unsigned char *, size_t, size_t);
+int crypto_get_hash256(unsigned char *, unsigned char *, size_t);
+int crypto_get_hash256_batch(unsigned char *, unsigned char *, size_t, size_t);
 int crypto_get_checksum(uint32_t *, unsigned char *, size_t);
+int crypto_sha256_init(Sha256);
+int crypto_sha256_update(Sha256, unsigned char *, size_t);
+int crypto_sha256_final(unsigned char *, Sha256);
 
 #endif
@@ -8,49 +8,59 @@
 #include <stdio.h>
 #include <stddef.h>
 #include <stdarg.h>
+#include <pthread.h>
 
 #define ERROR_LIST_MAX		20
 #define ERROR_LENGTH_MAX	200
 
 static char error_stack[ERROR_LIST_MAX][ERROR_LENGTH_MAX];
 static int N = 0;
+static pthread_mutex_t error_lock = PTHREAD_MUTEX_INITIALIZER;
 
 void error_log(char *error, ...)
 {
 	va_list argList;
 
+	pthread_mutex_lock(&error_lock);
 	if (N < ERROR_LIST_MAX)
 	{
 		va_start(argList, error);
 		vsnprintf(error_stack[N++], ERROR_LENGTH_MAX - 1, error, argList);
 		va_end(argList);
 	}
+	pthread_mutex_unlock(&error_lock);
 }
 
 void error_print(void)
 {
 	int i;
 
+	pthread_mutex_lock(&error_lock);
 	for (i = N-1; i >= 0; --i)
 	{
 		fprintf(stderr, "%s ", error_stack[i]);
 	}
 	fprintf(stderr, "\n");
+	pthread_mutex_unlock(&error_lock);
 }
 
 char *error_get(void)
 {
+	char *r = NULL;
+
+	pthread_mutex_lock(&error_lock);
 	if (N > 0)
 	{
-		return error_stack[--N];
-	}
-	else
-	{
-		return NULL;
+		r = error_stack[--N];
 	}
+	pthread_mutex_unlock(&error_lock);
+
+	return r;
 }
 
 void error_clear(void)
 {
+	pthread_mutex_lock(&error_lock);
 	N = 0;
+	pthread_mutex_unlock(&error_lock);
 }
\ No newline at end of file
@@ -0,0 +1,343 @@
+/*
+ * Copyright (c) 2017 Brian Barto
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GPL License. See LICENSE for more details.
+ */
+
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include "field.h"
+#include "error.h"
+
+// p = 2^256 - 2^32 - 977, so 2^256 is congruent to FIELD_C modulo p.
+#define FIELD_P0    0xFFFFFFFEFFFFFC2FULL
+#define FIELD_PN    0xFFFFFFFFFFFFFFFFULL
+#define FIELD_C     0x1000003D1ULL
+
+typedef unsigned __int128 uint128_t;
+
+static void field_sqr_n(Field, Field, int);
+static void field_pow_223(Field, Field, Field, Field);
+
+// Brings a four limb value plus an overflow bit into the range [0, p).
+static void field_reduce(uint64_t *r, uint64_t overflow)
+{
+	int i;
+	uint128_t t;
+	uint64_t s[FIELD_LIMBS];
+
+	// Fold the overflow bit back in. This can't carry out again since the
+	// limbs are necessarily small whenever the overflow bit is set.
+	if (overflow)
+	{
+		t = (uint128_t)r[0] + FIELD_C;
+		r[0] = (uint64_t)t;
+		for (i = 1; i < FIELD_LIMBS; ++i)
+		{
+			t = (uint128_t)r[i] + (uint64_t)(t >> 64);
+			r[i] = (uint64_t)t;
+		}
+	}
+
+	// r >= p exactly when r + (2^256 - p) overflows, in which case the
+	// truncated sum is r - p.
+	t = (uint128_t)r[0] + FIELD_C;
+	s[0] = (uint64_t)t;
+	for (i = 1; i < FIELD_LIMBS; ++i)
+	{
+		t = (uint128_t)r[i] + (uint64_t)(t >> 64);
+		s[i] = (uint64_t)t;
+	}
+	if (t >> 64)
+	{
+		memcpy(r, s, sizeof(s));
+	}
+}
+
+void field_set_int(Field r, uint64_t a)
+{
+	assert(r);
+
+	r->n[0] = a;
+	r->n[1] = 0;
+	r->n[2] = 0;
+	r->n[3] = 0;
+
+	field_reduce(r->n, 0);
+}
+
+void field_set(Field r, Field a)
+{
+	assert(r);
+	assert(a);
+
+	memcpy(r->n, a->n, sizeof(r->n));
+}
+
+int field_set_raw(Field r, unsigned char *input)
+{
+	int i, j;
+
+	assert(r);
+	assert(input);
+
+	for (i = 0; i < FIELD_LIMBS; ++i)
+	{
+		r->n[i] = 0;
+		for (j = 0; j < 8; ++j)
+		{
+			r->n[i] = (r->n[i] << 8) | input[FIELD_LENGTH - 8 - (i * 8) + j];
+		}
+	}
+
+	if (r->n[3] == FIELD_PN && r->n[2] == FIELD_PN && r->n[1] == FIELD_PN && r->n[0] >= FIELD_P0)
+	{
+		error_log("Value is not a valid field element.");
+		return -1;
+	}
+
+	return 1;
+}
+
+void field_get_raw(unsigned char *output, Field a)
+{
+	int i, j;
+
+	assert(output);
+	assert(a);
+
+	for (i = 0; i < FIELD_LIMBS; ++i)
+	{
+		for (j = 0; j < 8; ++j)
+		{
+			output[FIELD_LENGTH - 1 - (i * 8) - j] = (unsigned char)(a->n[i] >> (j * 8));
+		}
+	}
+}
+
+int field_is_zero(Field a)
+{
+	assert(a);
+
+	return (a->n[0] | a->n[1] | a->n[2] | a->n[3]) == 0;
+}
+
+int field_is_odd(Field a)
+{
+	assert(a);
+
+	return (int)(a->n[0] & 1);
+}
+
+int field_is_equal(Field a, Field b)
+{
+	assert(a);
+	assert(b);
+
+	return ((a->n[0] ^ b->n[0]) | (a->n[1] ^ b->n[1]) | (a->n[2] ^ b->n[2]) | (a->n[3] ^ b->n[3])) == 0;
+}
+
+void field_add(Field r, Field a, Field b)
+{
+	int i;
+	uint128_t t = 0;
+
+	assert(r);
+	assert(a);
+	assert(b);
+
+	for (i = 0; i < FIELD_LIMBS; ++i)
+	{
+		t = (uint128_t)a->n[i] + b->n[i] + (uint64_t)(t >> 64);
+		r->n[i] = (uint64_t)t;
+	}
+
+	field_reduce(r->n, (uint64_t)(t >> 64));
+}
+
+void field_sub(Field r, Field a, Field b)
+{
+	int i;
+	uint64_t borrow = 0;
+	uint128_t t;
+
+	assert(r);
+	assert(a);
+	assert(b);
+
+	for (i = 0; i < FIELD_LIMBS; ++i)
+	{
+		t = (uint128_t)a->n[i] - b->n[i] - borrow;
+		r->n[i] = (uint64_t)t;
+		borrow = (uint64_t)(t >> 64) & 1;
+	}
+
+	// On underflow we hold a - b + 2^256. Adding p is the same as
+	// subtracting FIELD_C, which can't underflow again.
+	if (borrow)
+	{
+		t = (uint128_t)r->n[0] - FIELD_C;
+		r->n[0] = (uint64_t)t;
+		for (i = 1; i < FIELD_LIMBS; ++i)
+		{
+			t = (uint128_t)r->n[i] - ((uint64_t)(t >> 64) & 1);
+			r->n[i] = (uint64_t)t;
+		}
+	}
+}
+
+void field_neg(Field r, Field a)
+{
+	struct Field zero;
+
+	assert(r);
+	assert(a);
+
+	memset(&zero, 0, sizeof(zero));
+	field_sub(r, &zero, a);
+}
+
+void field_mul(Field r, Field a, Field b)
+{
+	int i, j;
+	uint64_t l[FIELD_LIMBS * 2];
+	uint64_t c;
+	uint128_t t;
+
+	assert(r);
+	assert(a);
+	assert(b);
+
+	// 512 bit schoolbook product
+	memset(l, 0, sizeof(l));
+	for (i = 0; i < FIELD_LIMBS; ++i)
+	{
+		c = 0;
+		for (j = 0; j < FIELD_LIMBS; ++j)
+		{
+			t = (uint128_t)a->n[i] * b->n[j] + l[i + j] + c;
+			l[i + j] = (uint64_t)t;
+			c = (uint64_t)(t >> 64);
+		}
+		l[i + FIELD_LIMBS] = c;
+	}
+
+	// Fold the high half down: hi * 2^256 + lo = hi * FIELD_C + lo (mod p)
+	c = 0;
+	for (i = 0; i < FIELD_LIMBS; ++i)
+	{
+		t = (uint128_t)l[i + FIELD_LIMBS] * FIELD_C + l[i] + c;
+		r->n[i] = (uint64_t)t;
+		c = (uint64_t)(t >> 64);
+	}
+
+	// The remaining carry is at most 34 bits wide, so folding it in once
+	// more leaves at most a single overflow bit for field_reduce().
+	t = (uint128_t)c * FIELD_C + r->n[0];
+	r->n[0] = (uint64_t)t;
+	for (i = 1; i < FIELD_LIMBS; ++i)
+	{
+		t = (uint128_t)r->n[i] + (uint64_t)(t >> 64);
+		r->n[i] = (uint64_t)t;
+	}
+
+	field_reduce(r->n, (uint64_t)(t >> 64));
+}
+
+void field_sqr(Field r, Field a)
+{
+	field_mul(r, a, a);
+}
+
+void field_inv(Field r, Field a)
+{
+	struct Field x2, x22, t;
+
+	assert(r);
+	assert(a);
+
+	// Fermat inversion, a^(p-2). The exponent in binary is 223 ones, a zero,
+	// 22 ones and then 0000101101, so an addition chain over those runs of
+	// ones is much shorter than plain square-and-multiply.
+	field_pow_223(&t, &x2, &x22, a);
+	field_sqr_n(&t, &t, 23);
+	field_mul(&t, &t, &x22);
+	field_sqr_n(&t, &t, 5);
+	field_mul(&t, &t, a);
+	field_sqr_n(&t, &t, 3);
+	field_mul(&t, &t, &x2);
+	field_sqr_n(&t, &t, 2);
+	field_mul(r, &t, a);
+}
+
+void field_sqrt(Field r, Field a)
+{
+	struct Field x2, x22, t;
+
+	assert(r);
+	assert(a);
+
+	// Since p = 3 mod 4, a square root is a^((p+1)/4). The exponent shares
+	// its leading runs of ones with p-2 and ends in 0000110000 instead. The
+	// caller is responsible for checking that a actually was a square.
+	field_pow_223(&t, &x2, &x22, a);
+	field_sqr_n(&t, &t, 23);
+	field_mul(&t, &t, &x22);
+	field_sqr_n(&t, &t, 6);
+	field_mul(&t, &t, &x2);
+	field_sqr_n(r, &t, 2);
+}
+
+// Squares a in place n times.
+static void field_sqr_n(Field r, Field a, int n)
+{
+	int i;
+
+	field_set(r, a);
+	for (i = 0; i < n; ++i)
+	{
+		field_sqr(r, r);
+	}
+}
+
+// Sets r = a^(2^223 - 1), along with the intermediate powers a^(2^2 - 1)
+// and a^(2^22 - 1) that the inversion and square root chains reuse.
+static void field_pow_223(Field r, Field x2, Field x22, Field a)
+{
+	struct Field x3, x6, x9, x11, x44, x88, x176, x220;
+
+	field_sqr(x2, a);
+	field_mul(x2, x2, a);
+
+	field_sqr(&x3, x2);
+	field_mul(&x3, &x3, a);
+
+	field_sqr_n(&x6, &x3, 3);
+	field_mul(&x6, &x6, &x3);
+
+	field_sqr_n(&x9, &x6, 3);
+	field_mul(&x9, &x9, &x3);
+
+	field_sqr_n(&x11, &x9, 2);
+	field_mul(&x11, &x11, x2);
+
+	field_sqr_n(x22, &x11, 11);
+	field_mul(x22, x22, &x11);
+
+	field_sqr_n(&x44, x22, 22);
+	field_mul(&x44, &x44, x22);
+
+	field_sqr_n(&x88, &x44, 44);
+	field_mul(&x88, &x88, &x44);
+
+	field_sqr_n(&x176, &x88, 88);
+	field_mul(&x176, &x176, &x88);
+
+	field_sqr_n(&x220, &x176, 44);
+	field_mul(&x220, &x220, &x44);
+
+	field_sqr_n(r, &x220, 3);
+	field_mul(r, r, &x3);
+}
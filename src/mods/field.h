@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2017 Brian Barto
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GPL License. See LICENSE for more details.
+ */
+
+#ifndef FIELD_H
+#define FIELD_H 1
+
+#include <stdint.h>
+
+#define FIELD_LIMBS        4
+#define FIELD_LENGTH       32
+
+// Elements of the secp256k1 prime field. Values are stored as four
+// little-endian 64 bit limbs and are always kept fully reduced modulo p.
+typedef struct Field *Field;
+struct Field
+{
+	uint64_t n[FIELD_LIMBS];
+};
+
+void field_set_int(Field, uint64_t);
+void field_set(Field, Field);
+int  field_set_raw(Field, unsigned char *);
+void field_get_raw(unsigned char *, Field);
+int  field_is_zero(Field);
+int  field_is_odd(Field);
+int  field_is_equal(Field, Field);
+void field_add(Field, Field, Field);
+void field_sub(Field, Field, Field);
+void field_neg(Field, Field);
+void field_mul(Field, Field, Field);
+void field_sqr(Field, Field);
+void field_inv(Field, Field);
+void field_sqrt(Field, Field);
+
+#endif
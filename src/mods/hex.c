@@ -8,11 +8,55 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
-#include <ctype.h>
+#include <pthread.h>
 #include <assert.h>
 #include "hex.h"
 #include "error.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HEX_X86 1
+#endif
+
+// Encodes or decodes as many whole blocks as it can, and returns how many
+// input bytes it took. The scalar code does the rest.
+typedef size_t (*HexBlocks)(void *, void *, size_t);
+
+#ifdef HEX_X86
+static size_t hex_encode_ssse3(void *, void *, size_t);
+static size_t hex_encode_avx2(void *, void *, size_t);
+static size_t hex_decode_ssse3(void *, void *, size_t);
+static size_t hex_decode_avx2(void *, void *, size_t);
+#endif
+static void hex_select(void);
+
+static const char hex_digits[] = "0123456789abcdef";
+
+// Nibble values by character, upper and lower case alike, or -1.
+static const signed char hex_map[256] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, -1, -1, -1, -1, -1, -1,
+	-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+// The block functions are picked once, from what the processor supports.
+static HexBlocks hex_encode_blocks = NULL;
+static HexBlocks hex_decode_blocks = NULL;
+static pthread_once_t hex_select_once = PTHREAD_ONCE_INIT;
+
 int hex_to_dec(char l, char r)
 {
 	int decimal;
@@ -26,44 +70,34 @@ int hex_to_dec(char l, char r)
 		return -1;
 	}
 
-	l = tolower(l);
-	r = tolower(r);
+	decimal = (hex_map[(unsigned char)l] << 4) + hex_map[(unsigned char)r];
 
-	l = isdigit(l) ? l - 48 : l - 87;
-	r = isdigit(r) ? r - 48 : r - 87;
-	
-	decimal = (l << 4) + r;
-	
 	return decimal;
 }
 
 int hex_str_to_raw(unsigned char *output, char *input)
 {
 	int r;
-	size_t i, input_len;
+	size_t input_len;
 
 	assert(output);
 	assert(input);
-	
+
 	input_len = strlen(input);
-	
+
 	if (input_len % 2 != 0)
 	{
 		error_log("Invalid hex string. Length is not even.");
 		return -1;
 	}
-	
-	for (i = 0; i < input_len; i += 2)
+
+	r = hex_decode(output, input, input_len);
+	if (r < 0)
 	{
-		r = hex_to_dec(input[i], input[i + 1]);
-		if (r < 0)
-		{
-			error_log("Could not convert hex character to decimal.");
-			return -1;
-		}
-		*output++ = r;
+		error_log("Could not convert hex character to decimal.");
+		return -1;
 	}
-	
+
 	return 1;
 }
 
@@ -71,6 +105,211 @@ int hex_ischar(char c)
 {
 	assert(c);
 
-	return (c >= 'A' && c <= 'F') || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+	return (hex_map[(unsigned char)c] >= 0);
+}
+
+int hex_encode(char *output, unsigned char *input, size_t input_len)
+{
+	size_t i;
+
+	assert(output);
+	assert(input || input_len == 0);
+
+	pthread_once(&hex_select_once, hex_select);
+
+	// Lowercase, two characters per byte, null terminated.
+	i = 0;
+	if (hex_encode_blocks != NULL)
+	{
+		i = hex_encode_blocks(output, input, input_len);
+	}
+	for (; i < input_len; ++i)
+	{
+		output[i * 2] = hex_digits[input[i] >> 4];
+		output[(i * 2) + 1] = hex_digits[input[i] & 0x0f];
+	}
+	output[input_len * 2] = '\0';
+
+	return 1;
+}
+
+int hex_decode(unsigned char *output, char *input, size_t input_len)
+{
+	int h, l;
+	size_t i;
+
+	assert(output);
+	assert(input || input_len == 0);
+
+	if (input_len % 2 != 0)
+	{
+		error_log("Invalid hex string. Length is not even.");
+		return -1;
+	}
+
+	pthread_once(&hex_select_once, hex_select);
+
+	// Blocks stop short of a bad character, so the scalar code finds
+	// and reports it.
+	i = 0;
+	if (hex_decode_blocks != NULL)
+	{
+		i = hex_decode_blocks(output, input, input_len / 2);
+	}
+	for (; i < input_len / 2; ++i)
+	{
+		h = hex_map[(unsigned char)input[i * 2]];
+		l = hex_map[(unsigned char)input[(i * 2) + 1]];
+		if (h < 0 || l < 0)
+		{
+			error_log("Invalid hex character: 0x%c%c.", input[i * 2], input[(i * 2) + 1]);
+			return -1;
+		}
+		output[i] = (unsigned char)((h << 4) | l);
+	}
+
+	return (int)(input_len / 2);
 }
 
+#ifdef HEX_X86
+
+// Each nibble indexes a table of the 16 digits, and the high and low
+// digits are interleaved. 16 bytes per step.
+__attribute__((target("ssse3")))
+static size_t hex_encode_ssse3(void *output, void *input, size_t input_len)
+{
+	size_t i;
+	__m128i v, hi, lo, digits, mask;
+
+	digits = _mm_loadu_si128((__m128i *)hex_digits);
+	mask = _mm_set1_epi8(0x0f);
+
+	for (i = 0; i + 16 <= input_len; i += 16)
+	{
+		v = _mm_loadu_si128((__m128i *)((unsigned char *)input + i));
+		hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+		lo = _mm_shuffle_epi8(digits, _mm_and_si128(v, mask));
+		_mm_storeu_si128((__m128i *)((char *)output + (i * 2)), _mm_unpacklo_epi8(hi, lo));
+		_mm_storeu_si128((__m128i *)((char *)output + (i * 2) + 16), _mm_unpackhi_epi8(hi, lo));
+	}
+
+	return i;
+}
+
+// Same as the SSSE3 version, 32 bytes per step. Unpacking works within
+// each 128 bit lane, so the lanes are put back in order before storing.
+__attribute__((target("avx2")))
+static size_t hex_encode_avx2(void *output, void *input, size_t input_len)
+{
+	size_t i;
+	__m256i v, hi, lo, a, b, digits, mask;
+
+	digits = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *)hex_digits));
+	mask = _mm256_set1_epi8(0x0f);
+
+	for (i = 0; i + 32 <= input_len; i += 32)
+	{
+		v = _mm256_loadu_si256((__m256i *)((unsigned char *)input + i));
+		hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+		lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(v, mask));
+		a = _mm256_unpacklo_epi8(hi, lo);
+		b = _mm256_unpackhi_epi8(hi, lo);
+		_mm256_storeu_si256((__m256i *)((char *)output + (i * 2)), _mm256_permute2x128_si256(a, b, 0x20));
+		_mm256_storeu_si256((__m256i *)((char *)output + (i * 2) + 32), _mm256_permute2x128_si256(a, b, 0x31));
+	}
+	if (i + 16 <= input_len)
+	{
+		i += hex_encode_ssse3((char *)output + (i * 2), (unsigned char *)input + i, 16);
+	}
+
+	return i;
+}
+
+// Digits and letters of either case are mapped to their values, and any
+// other character stops the loop. Pairs of nibbles are then multiplied
+// and added into bytes. 16 bytes per step.
+__attribute__((target("ssse3")))
+static size_t hex_decode_ssse3(void *output, void *input, size_t output_len)
+{
+	size_t i;
+	int k;
+	__m128i v[2], d, l, is_digit, is_alpha, weights;
+
+	weights = _mm_set1_epi16(0x0110);
+
+	for (i = 0; i + 16 <= output_len; i += 16)
+	{
+		for (k = 0; k < 2; ++k)
+		{
+			v[k] = _mm_loadu_si128((__m128i *)((char *)input + (i * 2) + (k * 16)));
+			d = _mm_sub_epi8(v[k], _mm_set1_epi8('0'));
+			l = _mm_sub_epi8(_mm_or_si128(v[k], _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+			is_digit = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+			is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(l, _mm_set1_epi8(5)), l);
+			if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xffff)
+			{
+				return i;
+			}
+			v[k] = _mm_or_si128(_mm_and_si128(is_digit, d), _mm_and_si128(is_alpha, _mm_add_epi8(l, _mm_set1_epi8(10))));
+			v[k] = _mm_maddubs_epi16(v[k], weights);
+		}
+		_mm_storeu_si128((__m128i *)((unsigned char *)output + i), _mm_packus_epi16(v[0], v[1]));
+	}
+
+	return i;
+}
+
+// Same as the SSSE3 version, 32 bytes per step. Packing works within
+// each 128 bit lane, so the quarters are put back in order.
+__attribute__((target("avx2")))
+static size_t hex_decode_avx2(void *output, void *input, size_t output_len)
+{
+	size_t i;
+	int k;
+	__m256i v[2], d, l, is_digit, is_alpha, weights;
+
+	weights = _mm256_set1_epi16(0x0110);
+
+	for (i = 0; i + 32 <= output_len; i += 32)
+	{
+		for (k = 0; k < 2; ++k)
+		{
+			v[k] = _mm256_loadu_si256((__m256i *)((char *)input + (i * 2) + (k * 32)));
+			d = _mm256_sub_epi8(v[k], _mm256_set1_epi8('0'));
+			l = _mm256_sub_epi8(_mm256_or_si256(v[k], _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+			is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+			is_alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(l, _mm256_set1_epi8(5)), l);
+			if ((uint32_t)_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_alpha)) != 0xffffffff)
+			{
+				return i;
+			}
+			v[k] = _mm256_or_si256(_mm256_and_si256(is_digit, d), _mm256_and_si256(is_alpha, _mm256_add_epi8(l, _mm256_set1_epi8(10))));
+			v[k] = _mm256_maddubs_epi16(v[k], weights);
+		}
+		_mm256_storeu_si256((__m256i *)((unsigned char *)output + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(v[0], v[1]), 0xd8));
+	}
+	if (i + 16 <= output_len)
+	{
+		i += hex_decode_ssse3((unsigned char *)output + i, (char *)input + (i * 2), 16);
+	}
+
+	return i;
+}
+
+#endif
+
+static void hex_select(void)
+{
+#ifdef HEX_X86
+	if (__builtin_cpu_supports("avx2"))
+	{
+		hex_encode_blocks = hex_encode_avx2;
+		hex_decode_blocks = hex_decode_avx2;
+	}
+	else if (__builtin_cpu_supports("ssse3"))
+	{
+		hex_encode_blocks = hex_encode_ssse3;
+		hex_decode_blocks = hex_decode_ssse3;
+	}
+#endif
+}
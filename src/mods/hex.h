@@ -14,5 +14,7 @@
 int hex_to_dec(char, char);
 int hex_str_to_raw(unsigned char *, char *);
 int hex_ischar(char);
+int hex_encode(char *, unsigned char *, size_t);
+int hex_decode(unsigned char *, char *, size_t);
 
 #endif
@@ -14,9 +14,18 @@
 #include <sys/select.h>
 #include <time.h>
 #include <errno.h>
+#include <assert.h>
 #include "input.h"
 #include "error.h"
 
+#define INPUT_BUFFER_SIZE 65536
+
+// Piped input read ahead by input_get_line(). It must be drained before
+// any other read from stdin.
+static char input_buffer[INPUT_BUFFER_SIZE];
+static size_t input_buffer_pos = 0;
+static size_t input_buffer_len = 0;
+
 int input_available(void)
 {
 	int r, input_len;
@@ -27,6 +36,11 @@ int input_available(void)
 	FD_ZERO(&input_stream);
 	input_len = 0;
 
+	if (input_buffer_pos < input_buffer_len)
+	{
+		return 1;
+	}
+
 	if (isatty(STDIN_FILENO))
 	{
 		return 0;
@@ -250,4 +264,63 @@ int input_get_from_pipe(unsigned char** dest)
 	}
 
 	return r;
-}
\ No newline at end of file
+}
+
+int input_get_line(char *dest, size_t dest_len)
+{
+	int r;
+	size_t i;
+	char c;
+
+	assert(dest);
+	assert(dest_len);
+
+	// Reads one line per call like input_get_str(), but through a large
+	// buffer, so streams of many short lines cost a read() per buffer
+	// instead of one per character. Lines longer than dest_len - 1 are
+	// cut short and the rest of the line is dropped.
+	i = 0;
+	while (1)
+	{
+		if (input_buffer_pos == input_buffer_len)
+		{
+			r = read(STDIN_FILENO, input_buffer, INPUT_BUFFER_SIZE);
+			if (r < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				error_log("Input read error. Errno: %i", errno);
+				return -1;
+			}
+			input_buffer_pos = 0;
+			input_buffer_len = (size_t)r;
+			if (r == 0)
+			{
+				// EOF. A last line without a newline still counts.
+				break;
+			}
+		}
+
+		c = input_buffer[input_buffer_pos++];
+		if (c == '\n')
+		{
+			dest[i] = '\0';
+			if (i > 0 && dest[i - 1] == '\r')
+			{
+				dest[--i] = '\0';
+			}
+			return 1;
+		}
+
+		if (i < dest_len - 1)
+		{
+			dest[i++] = c;
+		}
+	}
+
+	dest[i] = '\0';
+
+	return (i > 0) ? 1 : 0;
+}
@@ -15,5 +15,6 @@ int input_available(void);
 int input_get(unsigned char** dest, char *prompt, int);
 int input_get_str(char** dest, char *prompt);
 int input_get_from_pipe(unsigned char** dest);
+int input_get_line(char *, size_t);
 
 #endif
\ No newline at end of file
@@ -19,6 +19,7 @@
 #define MESSAGE_TESTNET        0x0709110B
 #define MESSAGE_COMMAND_MAXLEN 12
 #define MESSAGE_PAYLOAD_MAXLEN 1024
+#define MESSAGE_HASH_CHUNK     256
 
 struct Message
 {
@@ -26,9 +27,12 @@ struct Message
 	char           command[MESSAGE_COMMAND_MAXLEN];
 	uint32_t       length;
 	uint32_t       checksum;
+	uint32_t       payload_checksum;
 	unsigned char  payload[MESSAGE_PAYLOAD_MAXLEN];
 };
 
+static int message_set_payload(Message, unsigned char *, size_t);
+
 int message_new(Message m, const char *command, unsigned char *payload, size_t payload_len)
 {
 	int r;
@@ -60,17 +64,19 @@ int message_new(Message m, const char *command, unsigned char *payload, size_t p
 		m->magic = MESSAGE_TESTNET;
 	}
 
-	strncpy(m->command, command, MESSAGE_COMMAND_MAXLEN);
+	// The command field is padded with zeros but not terminated when full.
+	memset(m->command, 0, MESSAGE_COMMAND_MAXLEN);
+	memcpy(m->command, command, strnlen(command, MESSAGE_COMMAND_MAXLEN));
 	m->length = payload_len;
 	if (payload_len)
 	{
-		memcpy(m->payload, payload, payload_len);
-		r = crypto_get_checksum(&m->checksum, m->payload, (size_t)m->length);
+		r = message_set_payload(m, payload, payload_len);
 		if (r < 0)
 		{
 			error_log("Could not generate checksum for message payload.");
 			return -1;
 		}
+		m->checksum = m->payload_checksum;
 	}
 
 	return 1;
@@ -98,6 +104,8 @@ int message_serialize(unsigned char *output, size_t *output_len, Message m)
 
 int message_deserialize(Message output, unsigned char *input, size_t input_len)
 {
+	int r;
+
 	assert(output);
 	assert(input);
 	assert(input_len);
@@ -114,12 +122,22 @@ int message_deserialize(Message output, unsigned char *input, size_t input_len)
 	input = deserialize_uint32(&(output->checksum), input, SERIALIZE_ENDIAN_BIG);
 	if (output->length)
 	{
+		if (output->length > MESSAGE_PAYLOAD_MAXLEN)
+		{
+			error_log("Message length (%i) can not exceed %i bytes in length.", output->length, MESSAGE_PAYLOAD_MAXLEN);
+			return -1;
+		}
 		if (input_len < 12 + MESSAGE_COMMAND_MAXLEN + output->length)
 		{
 			error_log("Input length (%i) insifficient to create a new message. %i bytes required.", input_len, 12 + MESSAGE_COMMAND_MAXLEN + output->length);
 			return -1;
 		}
-		input = deserialize_uchar(output->payload, input, output->length);
+		r = message_set_payload(output, input, output->length);
+		if (r < 0)
+		{
+			error_log("Could not generate checksum for message payload.");
+			return -1;
+		}
 	}
 	
 	return 12 + MESSAGE_COMMAND_MAXLEN + output->length;
@@ -136,9 +154,6 @@ int message_cmp_command(Message m, char *command)
 
 int message_is_valid(Message m)
 {
-	int r;
-	uint32_t checksum;
-
 	assert(m);
 
 	// If we don't have a payload then there is nothing to validate
@@ -147,14 +162,8 @@ int message_is_valid(Message m)
 		return 1;
 	}
 
-	r = crypto_get_checksum(&checksum, m->payload, (size_t)m->length);
-	if (r < 0)
-	{
-		error_log("Could not generate checksum for message payload.");
-		return -1;
-	}
-
-	return (checksum == m->checksum);
+	// The payload was hashed when it was copied in.
+	return (m->payload_checksum == m->checksum);
 }
 
 int message_get_payload(unsigned char *output, Message m)
@@ -178,3 +187,55 @@ size_t message_sizeof(void)
 {
 	return sizeof(struct Message);
 }
+
+// Copies the payload in and takes its checksum in the same pass, a chunk
+// at a time, so each chunk is hashed while it is still in cache.
+static int message_set_payload(Message m, unsigned char *payload, size_t payload_len)
+{
+	int r;
+	size_t i, n;
+	unsigned char sha[32];
+	struct Sha256 ctx;
+
+	r = crypto_sha256_init(&ctx);
+	if (r < 0)
+	{
+		error_log("Could not initialize SHA256 hash.");
+		return -1;
+	}
+
+	for (i = 0; i < payload_len; i += n)
+	{
+		n = payload_len - i;
+		if (n > MESSAGE_HASH_CHUNK)
+		{
+			n = MESSAGE_HASH_CHUNK;
+		}
+
+		memcpy(m->payload + i, payload + i, n);
+		r = crypto_sha256_update(&ctx, m->payload + i, n);
+		if (r < 0)
+		{
+			error_log("Could not hash message payload.");
+			return -1;
+		}
+	}
+
+	r = crypto_sha256_final(sha, &ctx);
+	if (r < 0)
+	{
+		error_log("Could not finalize SHA256 hash.");
+		return -1;
+	}
+
+	// The checksum is the start of SHA(SHA(payload)), big endian.
+	r = crypto_get_sha256(sha, sha, 32);
+	if (r < 0)
+	{
+		error_log("Could not generate SHA256 hash for payload.");
+		return -1;
+	}
+	deserialize_uint32(&m->payload_checksum, sha, SERIALIZE_ENDIAN_BIG);
+
+	return 1;
+}
@@ -5,214 +5,660 @@
  * under the terms of the GPL License. See LICENSE for more details.
  */
 
-#include <gmp.h>
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <pthread.h>
 #include "point.h"
+#include "field.h"
+#include "error.h"
 
-#define BITCOIN_PRIME             "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEFFFFFC2F"
-#define BITCOIN_GENERATOR_POINT_X "79BE667EF9DCBBAC55A06295CE870B07029BFCDB2DCE28D959F2815B16F81798"
-#define BITCOIN_GENERATOR_POINT_Y "483ADA7726A3C4655DA4FBFC0E1108A8FD17B448A68554199C47D08FFB10D4B8"
+#define BITCOIN_CURVE_B           7
+#define GENERATOR_WINDOW_BITS     4
+#define GENERATOR_WINDOW_SIZE     (1 << GENERATOR_WINDOW_BITS)
+#define GENERATOR_WINDOWS         (256 / GENERATOR_WINDOW_BITS)
+
+static struct Field generator_x = {{0x59F2815B16F81798ULL, 0x029BFCDB2DCE28D9ULL, 0x55A06295CE870B07ULL, 0x79BE667EF9DCBBACULL}};
+static struct Field generator_y = {{0x9C47D08FFB10D4B8ULL, 0xFD17B448A6855419ULL, 0x5DA4FBFC0E1108A8ULL, 0x483ADA7726A3C465ULL}};
+
+// generator_table[i][j] holds j * 16^i * G. Entry zero of each window is
+// unused since it would be the point at infinity.
+static struct Point generator_table[GENERATOR_WINDOWS][GENERATOR_WINDOW_SIZE];
+static int generator_table_status = 0;
+static pthread_once_t generator_table_once = PTHREAD_ONCE_INIT;
+
+static void point_generator_table_init(void);
+static int point_generator_table_build(void);
 
 void point_init(Point p)
 {
 	assert(p);
 
-	mpz_init(p->x);
-	mpz_init(p->y);
+	field_set_int(&p->x, 0);
+	field_set_int(&p->y, 0);
 }
 
 void point_set(Point a, Point b)
 {
 	assert(a);
 	assert(b);
-	assert(b->x && b->y);
 
-	mpz_set(a->x, b->x);
-	mpz_set(a->y, b->y);
+	field_set(&a->x, &b->x);
+	field_set(&a->y, &b->y);
 }
 
 void point_set_generator(Point p)
 {
 	assert(p);
 	
-	mpz_set_str(p->x, BITCOIN_GENERATOR_POINT_X, 16);
-	mpz_set_str(p->y, BITCOIN_GENERATOR_POINT_Y, 16);
+	field_set(&p->x, &generator_x);
+	field_set(&p->y, &generator_y);
 }
 
 void point_double(Point result, Point a)
 {
-	static mpz_t tempx, tempy, p, slope;
-	static int init = 0;
+	struct Field tempx, tempy, slope;
 	
 	assert(result);
-	assert(a->x && a->y);
-	
-	if (!init)
-	{
-		mpz_init(tempx);
-		mpz_init(tempy);
-		mpz_init(p);
-		mpz_init(slope);
-		init = 1;
-	}
-	
-	mpz_set_str(p, BITCOIN_PRIME, 16);
+	assert(a);
 	
 	// slope = ((3 * x^2) * inverseMod((2*y), p)) % p
-	mpz_pow_ui(tempx, a->x, 2);
-	mpz_mul_ui(tempx, tempx, 3);
-	mpz_mul_ui(tempy, a->y, 2);
-	mpz_invert(tempy, tempy, p);
-	mpz_mul(slope, tempx, tempy);
-	mpz_mod(slope, slope, p);
+	field_sqr(&tempx, &a->x);
+	field_add(&slope, &tempx, &tempx);
+	field_add(&tempx, &slope, &tempx);
+	field_add(&tempy, &a->y, &a->y);
+	field_inv(&tempy, &tempy);
+	field_mul(&slope, &tempx, &tempy);
 
 	// xdbl = slope^2 - 2*x
-	mpz_mul_ui(tempx, a->x, 2);
-	mpz_pow_ui(result->x, slope, 2);
-	mpz_sub(result->x, result->x, tempx);
-	mpz_mod(result->x, result->x, p);
+	field_add(&tempx, &a->x, &a->x);
+	field_sqr(&tempy, &slope);
+	field_sub(&tempy, &tempy, &tempx);
 
 	// ydbl = slope *(x-xdbl)-y
-	mpz_sub(tempx, a->x, result->x);
-	mpz_mul(tempx, slope, tempx);
-	mpz_sub(result->y, tempx, a->y);
-	mpz_mod(result->y, result->y, p);
+	field_sub(&tempx, &a->x, &tempy);
+	field_mul(&tempx, &slope, &tempx);
+	field_sub(&result->y, &tempx, &a->y);
+	field_set(&result->x, &tempy);
 }
 
 void point_add(Point result, Point a, Point b)
 {
-	static mpz_t tempx, tempy, sumx, sumy, p, slope;
-	static int init = 0;
+	struct Field tempx, tempy, sumx, slope;
 	
 	assert(result);
 	assert(a);
 	assert(b);
-	assert(a->x && a->y);
-	assert(b->x && b->y);
-	
-	if (!init)
-	{
-		mpz_init(tempx);
-		mpz_init(tempy);
-		mpz_init(sumx);
-		mpz_init(sumy);
-		mpz_init(p);
-		mpz_init(slope);
-		init = 1;
-	}
-	
-	mpz_set_str(p, BITCOIN_PRIME, 16);
 	
 	// slope = (y1-y2) * inverseMod(x1-x2, p)
-	mpz_sub(tempx, a->x, b->x);
-	mpz_sub(tempy, a->y, b->y);
-	mpz_invert(tempx, tempx, p);
-	mpz_mul(slope, tempy, tempx);
-	mpz_mod(slope, slope, p);
+	field_sub(&tempx, &a->x, &b->x);
+	field_sub(&tempy, &a->y, &b->y);
+	field_inv(&tempx, &tempx);
+	field_mul(&slope, &tempy, &tempx);
 	
 	// xsum = slope^2 - (x1+x2)
-	mpz_pow_ui(tempy, slope, 2);
-	mpz_add(tempx, a->x, b->x);
-	mpz_sub(sumx, tempy, tempx);
-	mpz_mod(sumx, sumx, p);
+	field_sqr(&tempy, &slope);
+	field_add(&tempx, &a->x, &b->x);
+	field_sub(&sumx, &tempy, &tempx);
 	
 	// ysum = slope*(x1-xsum)-y1
-	mpz_sub(tempx, a->x, sumx);
-	mpz_mul(tempx, slope, tempx);
-	mpz_sub(sumy, tempx, a->y);
-	mpz_mod(sumy, sumy, p);
-	
-	mpz_set(result->x, sumx);
-	mpz_set(result->y, sumy);
+	field_sub(&tempx, &a->x, &sumx);
+	field_mul(&tempx, &slope, &tempx);
+	field_sub(&result->y, &tempx, &a->y);
+	field_set(&result->x, &sumx);
 }
 
 void point_solve_y(Point point, unsigned char even_odd_flag)
 {
-	mpz_t tempx, tempy, exp, p;
+	struct Field tempx, b;
 
 	assert(point);
-	assert(point->x);
-	assert(point->y);
 
-	mpz_init(tempx);
-	mpz_init(tempy);
-	mpz_init(exp);
-	mpz_init(p);
-	
-	mpz_set_str(p, BITCOIN_PRIME, 16);
+	// y^2 = x^3 + 7
+	// y = (x^3 + 7) ^ ((p+1)/4)
+	field_set_int(&b, BITCOIN_CURVE_B);
+	field_sqr(&tempx, &point->x);
+	field_mul(&tempx, &tempx, &point->x);
+	field_add(&tempx, &tempx, &b);
+	field_sqrt(&point->y, &tempx);
 
-	// https://stackoverflow.com/questions/43629265/deriving-an-ecdsa-uncompressed-public-key-from-a-compressed-one
-	// (y^2) % p = (x^3 + 7) % p
-	// y^2 = ((x^3 % p) + 7) % p
-	// y = (((x^3 % p) + 7) % p) ^ ((p+1)/4) % p
+	// Determine odd or even
+	if (field_is_odd(&point->y) != (even_odd_flag & 1))
+	{
+		field_neg(&point->y, &point->y);
+	}
+}
 
-	// This calculates y squared: ((x^3 % p) + 7) % p
-	mpz_powm_ui(tempx, point->x, 3, p);
-	mpz_add_ui(tempx, tempx, 7);
-	mpz_mod(tempx, tempx, p);
+int point_mul_generator(JacobianPoint result, unsigned char *scalar)
+{
+	int i, w;
 
-	// Next we calculate the exponent: ((p+1)/4)
-	mpz_add_ui(exp, p, 1);
-	mpz_tdiv_q_ui(exp, exp, 4);
+	assert(result);
+	assert(scalar);
 
-	// Raise y squared to the power of exp (keeping modulo p) to get the square root
-	mpz_powm_sec(tempy, tempx, exp, p);
+	// The table is built on first use, possibly by several threads at once.
+	pthread_once(&generator_table_once, point_generator_table_init);
+	if (generator_table_status < 0)
+	{
+		error_log("Could not build generator table.");
+		return -1;
+	}
 
-	// Determine odd or even
-	if ((mpz_even_p(tempy) && (even_odd_flag & 1)) || (mpz_odd_p(tempy) && !(even_odd_flag & 1)))
+	// Sum one table entry per 4 bit window of the scalar, least significant
+	// window first.
+	point_jacobian_set_infinity(result);
+	for (i = 0; i < GENERATOR_WINDOWS; ++i)
 	{
-		mpz_neg(tempy, tempy);
-		mpz_mod(tempy, tempy, p);
+		w = scalar[31 - (i / 2)];
+		w = (i % 2) ? (w >> 4) : (w & 0x0F);
+		if (w == 0)
+		{
+			continue;
+		}
+
+		point_jacobian_add_mixed(result, result, &generator_table[i][w]);
 	}
 
-	// set out y value
-	mpz_set(point->y, tempy);
+	if (result->infinity)
+	{
+		error_log("Scalar multiple of the generator is the point at infinity.");
+		return -1;
+	}
 
-	mpz_clear(tempx);
-	mpz_clear(tempy);
-	mpz_clear(exp);
-	mpz_clear(p);
+	return 1;
 }
 
 int point_verify(Point a)
 {
-	int r = 0;
-	static mpz_t tempx, tempy, tempr, p;
-	static int init = 0;
+	struct Field tempx, tempy, b;
+	
+	assert(a);
 	
-	assert(a->x && a->y);
+	// x^3 + 7 == y^2
+	field_set_int(&b, BITCOIN_CURVE_B);
+	field_sqr(&tempx, &a->x);
+	field_mul(&tempx, &tempx, &a->x);
+	field_add(&tempx, &tempx, &b);
+	field_sqr(&tempy, &a->y);
 	
-	if (!init)
+	return field_is_equal(&tempx, &tempy);
+}
+
+void point_clear(Point p)
+{
+	assert(p);
+
+	memset(p, 0, sizeof(*p));
+}
+
+void point_jacobian_set(JacobianPoint result, Point a)
+{
+	assert(result);
+	assert(a);
+
+	field_set(&result->x, &a->x);
+	field_set(&result->y, &a->y);
+	field_set_int(&result->z, 1);
+	result->infinity = 0;
+}
+
+void point_jacobian_set_infinity(JacobianPoint result)
+{
+	assert(result);
+
+	field_set_int(&result->x, 0);
+	field_set_int(&result->y, 1);
+	field_set_int(&result->z, 0);
+	result->infinity = 1;
+}
+
+void point_jacobian_double(JacobianPoint result, JacobianPoint a)
+{
+	struct Field a2, b2, c2, d, e, f;
+
+	assert(result);
+	assert(a);
+
+	if (a->infinity)
 	{
-		mpz_init(tempx);
-		mpz_init(tempy);
-		mpz_init(tempr);
-		mpz_init(p);
-		init = 1;
+		point_jacobian_set_infinity(result);
+		return;
 	}
-	
-	mpz_set_str(p, BITCOIN_PRIME, 16);
-	
-	mpz_set(tempx, a->x);
-	mpz_set(tempy, a->y);
-	
-	// ((x^3) + 7 - (y^2)) % p == 0
-	mpz_pow_ui(tempx, tempx, 3);
-	mpz_pow_ui(tempy, tempy, 2);
-	mpz_add_ui(tempx, tempx, 7);
-	mpz_sub(tempr, tempx, tempy);
-	mpz_mod(tempr, tempr, p);
-	
-	if (mpz_cmp_ui(tempr, 0) == 0)
+
+	// dbl-2009-l: A = x^2, B = y^2, C = B^2, D = 2((x + B)^2 - A - C),
+	// E = 3A, F = E^2
+	field_sqr(&a2, &a->x);
+	field_sqr(&b2, &a->y);
+	field_sqr(&c2, &b2);
+	field_add(&d, &a->x, &b2);
+	field_sqr(&d, &d);
+	field_sub(&d, &d, &a2);
+	field_sub(&d, &d, &c2);
+	field_add(&d, &d, &d);
+	field_add(&e, &a2, &a2);
+	field_add(&e, &e, &a2);
+	field_sqr(&f, &e);
+
+	// z3 = 2yz
+	field_mul(&result->z, &a->y, &a->z);
+	field_add(&result->z, &result->z, &result->z);
+
+	// x3 = F - 2D
+	field_sub(&result->x, &f, &d);
+	field_sub(&result->x, &result->x, &d);
+
+	// y3 = E(D - x3) - 8C
+	field_add(&c2, &c2, &c2);
+	field_add(&c2, &c2, &c2);
+	field_add(&c2, &c2, &c2);
+	field_sub(&d, &d, &result->x);
+	field_mul(&d, &e, &d);
+	field_sub(&result->y, &d, &c2);
+
+	result->infinity = 0;
+}
+
+void point_jacobian_add(JacobianPoint result, JacobianPoint a, JacobianPoint b)
+{
+	struct Field z1z1, z2z2, u1, u2, s1, s2, h, hh, hhh, r, v;
+
+	assert(result);
+	assert(a);
+	assert(b);
+
+	if (a->infinity)
 	{
-		r = 1;
+		field_set(&result->x, &b->x);
+		field_set(&result->y, &b->y);
+		field_set(&result->z, &b->z);
+		result->infinity = b->infinity;
+		return;
 	}
-	
-	return r;
+	if (b->infinity)
+	{
+		field_set(&result->x, &a->x);
+		field_set(&result->y, &a->y);
+		field_set(&result->z, &a->z);
+		result->infinity = a->infinity;
+		return;
+	}
+
+	// u1 = x1 * z2^2, u2 = x2 * z1^2, s1 = y1 * z2^3, s2 = y2 * z1^3
+	field_sqr(&z1z1, &a->z);
+	field_sqr(&z2z2, &b->z);
+	field_mul(&u1, &a->x, &z2z2);
+	field_mul(&u2, &b->x, &z1z1);
+	field_mul(&s1, &a->y, &b->z);
+	field_mul(&s1, &s1, &z2z2);
+	field_mul(&s2, &b->y, &a->z);
+	field_mul(&s2, &s2, &z1z1);
+
+	// h = u2 - u1, r = s2 - s1
+	field_sub(&h, &u2, &u1);
+	field_sub(&r, &s2, &s1);
+
+	if (field_is_zero(&h))
+	{
+		if (field_is_zero(&r))
+		{
+			point_jacobian_double(result, a);
+		}
+		else
+		{
+			point_jacobian_set_infinity(result);
+		}
+		return;
+	}
+
+	field_sqr(&hh, &h);
+	field_mul(&hhh, &h, &hh);
+	field_mul(&v, &u1, &hh);
+
+	// z3 = z1 * z2 * h
+	field_mul(&result->z, &a->z, &b->z);
+	field_mul(&result->z, &result->z, &h);
+
+	// x3 = r^2 - h^3 - 2v
+	field_sqr(&result->x, &r);
+	field_sub(&result->x, &result->x, &hhh);
+	field_sub(&result->x, &result->x, &v);
+	field_sub(&result->x, &result->x, &v);
+
+	// y3 = r(v - x3) - s1 * h^3
+	field_sub(&v, &v, &result->x);
+	field_mul(&v, &r, &v);
+	field_mul(&s1, &s1, &hhh);
+	field_sub(&result->y, &v, &s1);
+
+	result->infinity = 0;
 }
 
-void point_clear(Point p)
+void point_jacobian_add_mixed(JacobianPoint result, JacobianPoint a, Point b)
 {
-	mpz_clear(p->x);
-	mpz_clear(p->y);
-}
\ No newline at end of file
+	struct Field z1z1, u2, s2, h, hh, hhh, r, v;
+
+	assert(result);
+	assert(a);
+	assert(b);
+
+	if (a->infinity)
+	{
+		point_jacobian_set(result, b);
+		return;
+	}
+
+	// Same as point_jacobian_add() with z2 = 1, which saves the
+	// multiplications by z2.
+	field_sqr(&z1z1, &a->z);
+	field_mul(&u2, &b->x, &z1z1);
+	field_mul(&s2, &b->y, &a->z);
+	field_mul(&s2, &s2, &z1z1);
+
+	field_sub(&h, &u2, &a->x);
+	field_sub(&r, &s2, &a->y);
+
+	if (field_is_zero(&h))
+	{
+		if (field_is_zero(&r))
+		{
+			point_jacobian_double(result, a);
+		}
+		else
+		{
+			point_jacobian_set_infinity(result);
+		}
+		return;
+	}
+
+	field_sqr(&hh, &h);
+	field_mul(&hhh, &h, &hh);
+	field_mul(&v, &a->x, &hh);
+
+	field_mul(&result->z, &a->z, &h);
+
+	field_sqr(&u2, &r);
+	field_sub(&u2, &u2, &hhh);
+	field_sub(&u2, &u2, &v);
+	field_sub(&u2, &u2, &v);
+
+	field_sub(&v, &v, &u2);
+	field_mul(&v, &r, &v);
+	field_mul(&s2, &a->y, &hhh);
+	field_sub(&result->y, &v, &s2);
+	field_set(&result->x, &u2);
+
+	result->infinity = 0;
+}
+
+int point_jacobian_to_affine(Point result, JacobianPoint a)
+{
+	struct Field zinv, zinv2;
+
+	assert(result);
+	assert(a);
+
+	if (a->infinity)
+	{
+		error_log("Can not convert the point at infinity to affine coordinates.");
+		return -1;
+	}
+
+	field_inv(&zinv, &a->z);
+	field_sqr(&zinv2, &zinv);
+	field_mul(&result->x, &a->x, &zinv2);
+	field_mul(&zinv2, &zinv2, &zinv);
+	field_mul(&result->y, &a->y, &zinv2);
+
+	return 1;
+}
+
+int point_batch_normalize(Point result, JacobianPoint points, size_t n)
+{
+	size_t i;
+	struct Field inv, zinv, zinv2;
+	Field acc;
+
+	assert(result);
+	assert(points);
+
+	if (n == 0)
+	{
+		return 1;
+	}
+
+	acc = malloc(sizeof(*acc) * n);
+	if (acc == NULL)
+	{
+		error_log("Memory allocation error.");
+		return -1;
+	}
+
+	// Montgomery's trick: invert the product of all z values once, then
+	// peel the individual inverses off with two multiplications each.
+	for (i = 0; i < n; ++i)
+	{
+		if (points[i].infinity)
+		{
+			free(acc);
+			error_log("Can not convert the point at infinity to affine coordinates.");
+			return -1;
+		}
+		if (i == 0)
+		{
+			field_set(&acc[i], &points[i].z);
+		}
+		else
+		{
+			field_mul(&acc[i], &acc[i - 1], &points[i].z);
+		}
+	}
+
+	field_inv(&inv, &acc[n - 1]);
+
+	for (i = n - 1; i > 0; --i)
+	{
+		field_mul(&zinv, &inv, &acc[i - 1]);
+		field_mul(&inv, &inv, &points[i].z);
+
+		field_sqr(&zinv2, &zinv);
+		field_mul(&result[i].x, &points[i].x, &zinv2);
+		field_mul(&zinv2, &zinv2, &zinv);
+		field_mul(&result[i].y, &points[i].y, &zinv2);
+	}
+	field_sqr(&zinv2, &inv);
+	field_mul(&result[0].x, &points[0].x, &zinv2);
+	field_mul(&zinv2, &zinv2, &inv);
+	field_mul(&result[0].y, &points[0].y, &zinv2);
+
+	free(acc);
+
+	return 1;
+}
+
+int point_batch_add(Point result, Point base, Point addends, size_t n)
+{
+	int r;
+	size_t i;
+	struct Field inv, dxinv, dx, slope, t;
+	struct JacobianPoint jp;
+	Field acc;
+
+	assert(result);
+	assert(base);
+	assert(addends);
+
+	if (n == 0)
+	{
+		return 1;
+	}
+
+	acc = malloc(sizeof(*acc) * n);
+	if (acc == NULL)
+	{
+		error_log("Memory allocation error.");
+		return -1;
+	}
+
+	// Every affine addition base + addends[i] needs 1 / (x_i - x_base). Take
+	// the product of all of those differences, invert it once, and peel the
+	// individual inverses off on the way back. A zero difference (the addend
+	// is +/- base) is replaced with one here and handled separately below.
+	for (i = 0; i < n; ++i)
+	{
+		field_sub(&dx, &addends[i].x, &base->x);
+		if (field_is_zero(&dx))
+		{
+			field_set_int(&dx, 1);
+		}
+		if (i == 0)
+		{
+			field_set(&acc[i], &dx);
+		}
+		else
+		{
+			field_mul(&acc[i], &acc[i - 1], &dx);
+		}
+	}
+
+	field_inv(&inv, &acc[n - 1]);
+
+	for (i = n; i-- > 0; )
+	{
+		field_sub(&dx, &addends[i].x, &base->x);
+		if (field_is_zero(&dx))
+		{
+			point_jacobian_set(&jp, base);
+			point_jacobian_add_mixed(&jp, &jp, &addends[i]);
+			r = point_jacobian_to_affine(&result[i], &jp);
+			if (r < 0)
+			{
+				free(acc);
+				error_log("Point addition resulted in the point at infinity.");
+				return -1;
+			}
+			continue;
+		}
+
+		if (i > 0)
+		{
+			field_mul(&dxinv, &inv, &acc[i - 1]);
+			field_mul(&inv, &inv, &dx);
+		}
+		else
+		{
+			field_set(&dxinv, &inv);
+		}
+
+		// slope = (y_i - y_base) / (x_i - x_base)
+		field_sub(&slope, &addends[i].y, &base->y);
+		field_mul(&slope, &slope, &dxinv);
+
+		// x = slope^2 - x_base - x_i
+		field_sqr(&t, &slope);
+		field_sub(&t, &t, &base->x);
+		field_sub(&t, &t, &addends[i].x);
+
+		// y = slope * (x_base - x) - y_base
+		field_sub(&dx, &base->x, &t);
+		field_mul(&dx, &slope, &dx);
+		field_sub(&result[i].y, &dx, &base->y);
+		field_set(&result[i].x, &t);
+	}
+
+	free(acc);
+
+	return 1;
+}
+
+int point_set_generator_multiples(Point result, size_t n)
+{
+	int r;
+	size_t i;
+	struct Point g;
+	JacobianPoint multiples;
+
+	assert(result);
+
+	if (n == 0)
+	{
+		return 1;
+	}
+
+	multiples = malloc(sizeof(*multiples) * n);
+	if (multiples == NULL)
+	{
+		error_log("Memory allocation error.");
+		return -1;
+	}
+
+	// result[i] = (i + 1) * G
+	point_set_generator(&g);
+	point_jacobian_set(&multiples[0], &g);
+	for (i = 1; i < n; ++i)
+	{
+		point_jacobian_add_mixed(&multiples[i], &multiples[i - 1], &g);
+	}
+
+	r = point_batch_normalize(result, multiples, n);
+	if (r < 0)
+	{
+		free(multiples);
+		error_log("Could not normalize multiples of the generator.");
+		return -1;
+	}
+
+	free(multiples);
+
+	return 1;
+}
+
+static void point_generator_table_init(void)
+{
+	generator_table_status = point_generator_table_build();
+}
+
+static int point_generator_table_build(void)
+{
+	int i, j, r;
+	struct Point g;
+	struct JacobianPoint base;
+	JacobianPoint table;
+
+	table = malloc(sizeof(*table) * GENERATOR_WINDOWS * GENERATOR_WINDOW_SIZE);
+	if (table == NULL)
+	{
+		error_log("Memory allocation error.");
+		return -1;
+	}
+
+	// Build the table in Jacobian coordinates and normalize it all at once,
+	// which costs a single field inversion. Entry zero of each window is
+	// never used, so it just holds G to keep every entry a finite point.
+	point_set_generator(&g);
+	point_jacobian_set(&base, &g);
+	for (i = 0; i < GENERATOR_WINDOWS; ++i)
+	{
+		point_jacobian_set(&table[i * GENERATOR_WINDOW_SIZE], &g);
+		table[i * GENERATOR_WINDOW_SIZE + 1] = base;
+		for (j = 2; j < GENERATOR_WINDOW_SIZE; ++j)
+		{
+			point_jacobian_add(&table[i * GENERATOR_WINDOW_SIZE + j], &table[i * GENERATOR_WINDOW_SIZE + j - 1], &base);
+		}
+		for (j = 0; j < GENERATOR_WINDOW_BITS; ++j)
+		{
+			point_jacobian_double(&base, &base);
+		}
+	}
+
+	r = point_batch_normalize(&generator_table[0][0], table, GENERATOR_WINDOWS * GENERATOR_WINDOW_SIZE);
+	if (r < 0)
+	{
+		free(table);
+		error_log("Could not normalize generator table.");
+		return -1;
+	}
+
+	free(table);
+
+	return 1;
+}
@@ -8,13 +8,25 @@
 #ifndef POINT_H
 #define POINT_H 1
 
-#include <gmp.h>
+#include <stddef.h>
+#include "field.h"
 
 typedef struct Point *Point;
 struct Point
 {
-	mpz_t x;
-	mpz_t y;
+	struct Field x;
+	struct Field y;
+};
+
+// Jacobian coordinates: the affine point is (x / z^2, y / z^3). Group
+// operations on these need no field inversion.
+typedef struct JacobianPoint *JacobianPoint;
+struct JacobianPoint
+{
+	struct Field x;
+	struct Field y;
+	struct Field z;
+	int infinity;
 };
 
 void point_init(Point);
@@ -22,8 +34,18 @@ void point_set(Point, Point);
 void point_set_generator(Point);
 void point_double(Point, Point);
 void point_add(Point, Point, Point);
+int  point_mul_generator(JacobianPoint, unsigned char *);
 void point_solve_y(Point, unsigned char);
 int  point_verify(Point);
 void point_clear(Point);
+void point_jacobian_set(JacobianPoint, Point);
+void point_jacobian_set_infinity(JacobianPoint);
+void point_jacobian_double(JacobianPoint, JacobianPoint);
+void point_jacobian_add(JacobianPoint, JacobianPoint, JacobianPoint);
+void point_jacobian_add_mixed(JacobianPoint, JacobianPoint, Point);
+int  point_jacobian_to_affine(Point, JacobianPoint);
+int  point_batch_normalize(Point, JacobianPoint, size_t);
+int  point_batch_add(Point, Point, Point, size_t);
+int  point_set_generator_multiples(Point, size_t);
 
 #endif
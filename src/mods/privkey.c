@@ -9,6 +9,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <stdint.h>
 #include <gmp.h>
 #include <assert.h>
 #include "privkey.h"
@@ -23,6 +24,12 @@
 #define MAINNET_PREFIX      0x80
 #define TESTNET_PREFIX      0xEF
 
+#define PRIVKEY_ORDER       "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141"
+
+// A cube root of unity modulo the group order. Multiplying a key by it
+// maps its public key (x, y) to (beta * x, y).
+#define PRIVKEY_LAMBDA      "5363AD4CC05C30E0A5261C028812645A122E22EA20816678DF02967C1B23BD72"
+
 #define PRIVKEY_COMPRESSED_FLAG    0x01
 #define PRIVKEY_UNCOMPRESSED_FLAG  0x00
 
@@ -32,6 +39,8 @@ struct PrivKey
 	int cflag;
 };
 
+static void privkey_set_mpz(PrivKey, mpz_t);
+
 int privkey_new(PrivKey key)
 {
 	int r;
@@ -70,23 +79,18 @@ int privkey_uncompress(PrivKey key)
 
 int privkey_to_hex(char *str, PrivKey key, int cflag)
 {
-	int i;
+	unsigned char flag;
 	
 	assert(key);
 	assert(str);
 	
-	for (i = 0; i < PRIVKEY_LENGTH; ++i)
-	{
-		sprintf(str + (i * 2), "%02x", key->data[i]);
-	}
+	hex_encode(str, key->data, PRIVKEY_LENGTH);
 
 	if (cflag)
 	{
-		sprintf(str + (i * 2), "%02x", key->cflag);
-		++i;
+		flag = (unsigned char)key->cflag;
+		hex_encode(str + (PRIVKEY_LENGTH * 2), &flag, 1);
 	}
-
-	str[i * 2] = '\0';
 	
 	return 1;
 }
@@ -273,16 +277,13 @@ int privkey_from_hex(PrivKey key, char *input)
 	}
 
 	// load input string as private key
-	for (i = 0; i < PRIVKEY_LENGTH * 2; i += 2)
+	r = hex_decode(key->data, input, PRIVKEY_LENGTH * 2);
+	if (r < 0)
 	{
-		r = hex_to_dec(input[i], input[i+1]);
-		if (r < 0)
-		{
-			error_log("Could not convert hexidecimal characters to decimal.");
-			return -1;
-		}
-		key->data[i/2] = r;
+		error_log("Could not convert hexidecimal characters to decimal.");
+		return -1;
 	}
+	i = PRIVKEY_LENGTH * 2;
 
 	if (input[i] && input[i+1])
 	{
@@ -603,3 +604,85 @@ int privkey_rehash(PrivKey key)
 
 	return 1;
 }
+
+int privkey_add_uint(PrivKey key, uint64_t value)
+{
+	mpz_t d, n;
+
+	assert(key);
+
+	mpz_init(d);
+	mpz_init(n);
+
+	mpz_set_str(n, PRIVKEY_ORDER, 16);
+	mpz_import(d, PRIVKEY_LENGTH, 1, 1, 1, 0, key->data);
+	mpz_add_ui(d, d, value);
+	mpz_mod(d, d, n);
+
+	privkey_set_mpz(key, d);
+
+	mpz_clear(d);
+	mpz_clear(n);
+
+	return 1;
+}
+
+int privkey_negate(PrivKey key)
+{
+	mpz_t d, n;
+
+	assert(key);
+
+	mpz_init(d);
+	mpz_init(n);
+
+	mpz_set_str(n, PRIVKEY_ORDER, 16);
+	mpz_import(d, PRIVKEY_LENGTH, 1, 1, 1, 0, key->data);
+	mpz_neg(d, d);
+	mpz_mod(d, d, n);
+
+	privkey_set_mpz(key, d);
+
+	mpz_clear(d);
+	mpz_clear(n);
+
+	return 1;
+}
+
+int privkey_mul_lambda(PrivKey key)
+{
+	mpz_t d, n, l;
+
+	assert(key);
+
+	mpz_init(d);
+	mpz_init(n);
+	mpz_init(l);
+
+	mpz_set_str(n, PRIVKEY_ORDER, 16);
+	mpz_set_str(l, PRIVKEY_LAMBDA, 16);
+	mpz_import(d, PRIVKEY_LENGTH, 1, 1, 1, 0, key->data);
+	mpz_mul(d, d, l);
+	mpz_mod(d, d, n);
+
+	privkey_set_mpz(key, d);
+
+	mpz_clear(d);
+	mpz_clear(n);
+	mpz_clear(l);
+
+	return 1;
+}
+
+// Stores a value already reduced modulo the group order as key data.
+static void privkey_set_mpz(PrivKey key, mpz_t d)
+{
+	size_t c;
+
+	memset(key->data, 0, PRIVKEY_LENGTH);
+	c = (mpz_sizeinbase(d, 2) + 7) / 8;
+	if (mpz_sgn(d) != 0)
+	{
+		mpz_export(key->data + PRIVKEY_LENGTH - c, &c, 1, 1, 1, 0, d);
+	}
+}
@@ -8,6 +8,9 @@
 #ifndef PRIVKEY_H
 #define PRIVKEY_H 1
 
+#include <stddef.h>
+#include <stdint.h>
+
 #define PRIVKEY_LENGTH         32
 #define PRIVKEY_WIF_LENGTH_MIN 51
 #define PRIVKEY_WIF_LENGTH_MAX 52
@@ -33,5 +36,8 @@ int privkey_is_compressed(PrivKey);
 int privkey_is_zero(PrivKey);
 size_t privkey_sizeof(void);
 int privkey_rehash(PrivKey);
+int privkey_add_uint(PrivKey, uint64_t);
+int privkey_negate(PrivKey);
+int privkey_mul_lambda(PrivKey);
 
 #endif
@@ -10,9 +10,11 @@
 #include <stdlib.h>
 #include <gmp.h>
 #include <assert.h>
+#include <pthread.h>
 #include "pubkey.h"
 #include "privkey.h"
 #include "point.h"
+#include "field.h"
 #include "crypto.h"
 #include "base58check.h"
 #include "bech32.h"
@@ -25,21 +27,58 @@
 #define PUBKEY_COMPRESSED_FLAG_EVEN   0x02
 #define PUBKEY_COMPRESSED_FLAG_ODD    0x03
 #define PUBKEY_UNCOMPRESSED_FLAG      0x04
-#define PUBKEY_POINTS                 (PRIVKEY_LENGTH * 8)
+#define PUBKEY_ITER_HASH_CHUNK        32
 
 struct PubKey
 {
 	unsigned char data[PUBKEY_UNCOMPRESSED_LENGTH + 1];
 };
 
+// Holds a batch of consecutive points (k + i) * G, where k is the private
+// key of the first point. The extra point at the end is the first point
+// of the next batch. An iterator with an offset point Q holds Q + (k + i) * G
+// instead, and k is only the part of the private key it knows.
+struct PubKeyIter
+{
+	PrivKey key;
+	Point points;
+	size_t pos;
+	int compressed;
+
+	// Scratch space for taproot tweaks, allocated on first use.
+	JacobianPoint tweak_jpoints;
+	Point tweak_points;
+};
+
+// iter_multiples[i] = (i + 1) * G
+static struct Point iter_multiples[PUBKEY_ITER_BATCH];
+static int iter_multiples_status = 0;
+static pthread_once_t iter_multiples_once = PTHREAD_ONCE_INIT;
+
+// A cube root of unity modulo p, and its square. (beta * x, y) is the point
+// lambda * (x, y), see privkey_mul_lambda().
+static unsigned char iter_beta_raw[FIELD_LENGTH] = {
+	0x7a, 0xe9, 0x6a, 0x2b, 0x65, 0x7c, 0x07, 0x10,
+	0x6e, 0x64, 0x47, 0x9e, 0xac, 0x34, 0x34, 0xe9,
+	0x9c, 0xf0, 0x49, 0x75, 0x12, 0xf5, 0x89, 0x95,
+	0xc1, 0x39, 0x6c, 0x28, 0x71, 0x95, 0x01, 0xee
+};
+static struct Field iter_beta[2];
+
+// SHA256("TapTweak"), the tag of the BIP 341 tweak hash.
+static unsigned char iter_taptweak[32];
+
+static void pubkey_set_point(PubKey, Point, int);
+static int pubkey_get_point(Point, PubKey);
+static int pubkey_iter_advance(PubKeyIter);
+static void pubkey_iter_multiples_init(void);
+
 int pubkey_get(PubKey pubkey, PrivKey privkey)
 {
 	int r;
-	size_t i, l;
-	char privkey_hex[((PRIVKEY_LENGTH + 1) * 2) + 1];
-	mpz_t bignum;
-	Point point;
-	Point points[PUBKEY_POINTS];
+	unsigned char privkey_raw[PRIVKEY_LENGTH + 1];
+	struct JacobianPoint jpoint;
+	struct Point point;
 	
 	assert(privkey);
 	assert(pubkey);
@@ -50,123 +89,114 @@ int pubkey_get(PubKey pubkey, PrivKey privkey)
 		return -1;
 	}
 
-	mpz_init(bignum);
+	// Load private key bytes.
+	r = privkey_to_raw(privkey_raw, privkey, 0);
+	if (r < 0)
+	{
+		error_log("Could not convert private key to raw data.");
+		return -1;
+	}
 
-	// Load private key from hex string.
-	r = privkey_to_hex(privkey_hex, privkey, 0);
+	// Calculating public key
+	r = point_mul_generator(&jpoint, privkey_raw);
 	if (r < 0)
 	{
-		error_log("Could not convert private key to hex string.");
+		error_log("Could not multiply generator point by private key.");
 		return -1;
 	}
-	privkey_hex[PRIVKEY_LENGTH * 2] = '\0';
-	mpz_set_str(bignum, privkey_hex, 16);
-	
-	// Initalize the points
-	point = malloc(sizeof(*point));
-	if (point == NULL)
+
+	// A single inversion to get back to affine coordinates for export.
+	r = point_jacobian_to_affine(&point, &jpoint);
+	if (r < 0)
 	{
-		error_log("Memory allocation error.");
+		error_log("Could not convert public key point to affine coordinates.");
 		return -1;
 	}
-	point_init(point);
-	for (i = 0; i < PUBKEY_POINTS; ++i)
+
+	pubkey_set_point(pubkey, &point, privkey_is_compressed(privkey));
+
+	point_clear(&point);
+
+	return 1;
+}
+
+// Derives the public keys in order and stops at the first private key that
+// has none. Returns how many were derived, so callers can still use the
+// keys before a bad one.
+int pubkey_get_batch(PubKey *pubkeys, PrivKey *privkeys, size_t n)
+{
+	int r;
+	size_t i, m;
+	unsigned char privkey_raw[PRIVKEY_LENGTH + 1];
+	JacobianPoint jpoints;
+	Point points;
+
+	assert(pubkeys);
+	assert(privkeys);
+
+	if (n == 0)
 	{
-		points[i] = malloc(sizeof(*point));
-		if (points[i] == NULL)
-		{
-			error_log("Memory allocation error.");
-			return -1;
-		}
-		point_init(points[i]);
+		return 0;
 	}
 
-	// Calculating public key
-	point_set_generator(points[0]);
-	for (i = 1; i < PUBKEY_POINTS; ++i)
+	jpoints = malloc(sizeof(*jpoints) * n);
+	points = malloc(sizeof(*points) * n);
+	if (jpoints == NULL || points == NULL)
 	{
-		point_double(points[i], points[i-1]);
-		if (!point_verify(points[i]))
-		{
-			error_log("Unexpected point value while calculating public key.");
-			return -1;
-		}
+		free(jpoints);
+		free(points);
+		error_log("Memory allocation error.");
+		return -1;
 	}
 
-	// Add all points corresponding to 1 bits
-	for (i = 0; i < PUBKEY_POINTS; ++i)
+	for (m = 0; m < n; ++m)
 	{
-		if (mpz_tstbit(bignum, i) == 1)
+		if (privkey_is_zero(privkeys[m]))
 		{
-			if (mpz_cmp_ui(point->x, 0) == 0 && mpz_cmp_ui(point->y, 0) == 0)
-			{
-				point_set(point, points[i]);
-			}
-			else
-			{
-				point_add(point, point, points[i]);
-			}
-			if (!point_verify(points[i]))
-			{
-				error_log("Unexpected point value while calculating public key.");
-				return -1;
-			}
+			error_log("Private key can not be zero.");
+			break;
 		}
-	}
-	
-	// Setting compression flag
-	if (privkey_is_compressed(privkey))
-	{
-		if (mpz_even_p(point->y))
+
+		r = privkey_to_raw(privkey_raw, privkeys[m], 0);
+		if (r < 0)
 		{
-			pubkey->data[0] = PUBKEY_COMPRESSED_FLAG_EVEN;
+			free(jpoints);
+			free(points);
+			error_log("Could not convert private key to raw data.");
+			return -1;
 		}
-		else
+
+		// Fails for a multiple of the group order.
+		r = point_mul_generator(&jpoints[m], privkey_raw);
+		if (r < 0)
 		{
-			pubkey->data[0] = PUBKEY_COMPRESSED_FLAG_ODD;
+			error_log("Could not multiply generator point by private key.");
+			break;
 		}
 	}
-	else
-	{
-		pubkey->data[0] = PUBKEY_UNCOMPRESSED_FLAG;
-	}
-	
-	// Exporting x,y coordinates as byte string, making sure to leave leading
-	// zeros if either exports as less than 32 bytes.
-	l = (mpz_sizeinbase(point->x, 2) + 7) / 8;
-	mpz_export(pubkey->data + 1 + (32 - l), &i, 1, 1, 1, 0, point->x);
-	if (l != i)
-	{
-		error_log("Length of public key x-value export (%zu) does not match expected length (%zu).", i, l);
-		return -1;
-	}
-	if (!privkey_is_compressed(privkey))
+
+	// One inversion shared by the whole batch.
+	if (m > 0)
 	{
-		l = (mpz_sizeinbase(point->y, 2) + 7) / 8;
-		mpz_export(pubkey->data + 33 + (32 - l), &i, 1, 1, 1, 0, point->y);
-		if (l != i)
+		r = point_batch_normalize(points, jpoints, m);
+		if (r < 0)
 		{
-			error_log("Length of public key y-value export (%zu) does not match expected length (%zu).", i, l);
+			free(jpoints);
+			free(points);
+			error_log("Could not convert public key points to affine coordinates.");
 			return -1;
 		}
 	}
 
-	// Clear all mpz data
-	mpz_clear(bignum);
-	point_clear(point);
-	for (i = 0; i < PUBKEY_POINTS; ++i)
+	for (i = 0; i < m; ++i)
 	{
-		point_clear(points[i]);
+		pubkey_set_point(pubkeys[i], &points[i], privkey_is_compressed(privkeys[i]));
 	}
 
-	// Free all points
-	free(point);
-	for (i = 0; i < PUBKEY_POINTS; ++i)
-	{
-		free(points[i]);
-	}
+	free(jpoints);
+	free(points);
 
-	return 1;
+	return (int)m;
 }
 
 int pubkey_from_raw(PubKey key, unsigned char *input, size_t input_len)
@@ -230,7 +260,7 @@ int pubkey_compress(PubKey key)
 
 int pubkey_decompress(PubKey key)
 {
-	size_t i, l;
+	int r;
 	Point point;
 
 	if (key->data[0] == PUBKEY_UNCOMPRESSED_FLAG)
@@ -252,23 +282,26 @@ int pubkey_decompress(PubKey key)
 	}
 	point_init(point);
 
-	mpz_import(point->x, PUBKEY_COMPRESSED_LENGTH, 1, 1, 1, 0, key->data + 1);
+	r = field_set_raw(&point->x, key->data + 1);
+	if (r < 0)
+	{
+		error_log("Invalid point x value.");
+		point_clear(point);
+		free(point);
+		return -1;
+	}
 
 	point_solve_y(point, key->data[0]);
 
 	if (!point_verify(point))
 	{
 		error_log("Invalid point values.");
+		point_clear(point);
+		free(point);
 		return -1;
 	}
 
-	l = (mpz_sizeinbase(point->y, 2) + 7) / 8;
-	mpz_export(key->data + 33 + (32 - l), &i, 1, 1, 1, 0, point->y);
-	if (l != i)
-	{
-		error_log("Length of public key y-value export (%zu) does not match expected length (%zu).", i, l);
-		return -1;
-	}
+	field_get_raw(key->data + 33, &point->y);
 
 	key->data[0] = PUBKEY_UNCOMPRESSED_FLAG;
 
@@ -287,7 +320,7 @@ int pubkey_is_compressed(PubKey key)
 
 int pubkey_to_hex(char *str, PubKey key)
 {
-	int i, l;
+	int l;
 	
 	assert(str);
 	assert(key);
@@ -306,11 +339,7 @@ int pubkey_to_hex(char *str, PubKey key)
 			return -1;
 	}
 	
-	for (i = 0; i < l; i += 2)
-	{
-		sprintf(str + i, "%02x", key->data[i/2]);
-	}
-	str[l] = '\0';
+	hex_encode(str, key->data, l / 2);
 	
 	return 1;
 }
@@ -335,15 +364,67 @@ int pubkey_to_raw(unsigned char *raw, PubKey key)
 int pubkey_to_address(char *address, PubKey key)
 {
 	int r;
-	size_t len;
-	unsigned char sha[32];
 	unsigned char rmd[20];
-	unsigned char rmd_bit[21];
-	char base58[21 * 2];
 
 	assert(address);
 	assert(key);
 
+	r = pubkey_get_hash160(rmd, key);
+	if (r < 0)
+	{
+		error_log("Could not generate hash160 from public key data.");
+		return -1;
+	}
+
+	r = pubkey_hash160_to_address(address, rmd);
+	if (r < 0)
+	{
+		error_log("Could not generate address from public key data.");
+		return -1;
+	}
+
+	return 1;
+}
+
+int pubkey_to_bech32address(char *address, PubKey key)
+{
+	int r;
+	unsigned char rmd[20];
+
+	assert(address);
+	assert(key);
+
+	if (!pubkey_is_compressed(key))
+	{
+		error_log("Public key is uncompressed. Bech32 addresses require a compressed public key.");
+		return -1;
+	}
+
+	r = pubkey_get_hash160(rmd, key);
+	if (r < 0)
+	{
+		error_log("Could not generate hash160 from public key data.");
+		return -1;
+	}
+
+	r = pubkey_hash160_to_bech32address(address, rmd);
+	if (r < 0)
+	{
+		error_log("Could not generate bech32 address from public key data.");
+		return -1;
+	}
+
+	return 1;
+}
+
+int pubkey_get_hash160(unsigned char *output, PubKey key)
+{
+	int r;
+	size_t len;
+
+	assert(output);
+	assert(key);
+
 	if (pubkey_is_compressed(key))
 	{
 		len = PUBKEY_COMPRESSED_LENGTH + 1;
@@ -354,19 +435,94 @@ int pubkey_to_address(char *address, PubKey key)
 	}
 
 	// RMD(SHA(data))
-	r = crypto_get_sha256(sha, key->data, len);
+	r = crypto_get_hash160(output, key->data, len);
 	if (r < 0)
 	{
-		error_log("Could not generate SHA256 hash from public key data.");
+		error_log("Could not generate hash160 from public key data.");
 		return -1;
 	}
-	r = crypto_get_rmd160(rmd, sha, 32);
-	if (r < 0)
+
+	return 1;
+}
+
+// Hashes n public keys, 20 bytes of output each. The batch hash needs
+// inputs of one length, so compressed and uncompressed keys are gathered
+// and hashed apart.
+int pubkey_get_hash160_batch(unsigned char *output, PubKey *keys, size_t n)
+{
+	int r, compressed;
+	size_t i, j, len;
+	size_t *index;
+	unsigned char *data, *hashes;
+
+	assert(output);
+	assert(keys || n == 0);
+
+	if (n == 0)
+	{
+		return 1;
+	}
+
+	index = malloc(sizeof(*index) * n);
+	data = malloc((PUBKEY_UNCOMPRESSED_LENGTH + 1) * n);
+	hashes = malloc(20 * n);
+	if (index == NULL || data == NULL || hashes == NULL)
 	{
-		error_log("Could not generate RMD160 hash from public key data.");
+		error_log("Memory allocation error.");
+		free(index);
+		free(data);
+		free(hashes);
 		return -1;
 	}
 
+	for (compressed = 0; compressed < 2; ++compressed)
+	{
+		len = compressed ? PUBKEY_COMPRESSED_LENGTH + 1 : PUBKEY_UNCOMPRESSED_LENGTH + 1;
+		for (i = 0, j = 0; i < n; ++i)
+		{
+			if (pubkey_is_compressed(keys[i]) == compressed)
+			{
+				memcpy(data + (j * len), keys[i]->data, len);
+				index[j++] = i;
+			}
+		}
+		if (j == 0)
+		{
+			continue;
+		}
+
+		r = crypto_get_hash160_batch(hashes, data, len, j);
+		if (r < 0)
+		{
+			error_log("Could not generate hash160 from public key data.");
+			free(index);
+			free(data);
+			free(hashes);
+			return -1;
+		}
+
+		for (i = 0; i < j; ++i)
+		{
+			memcpy(output + (index[i] * 20), hashes + (i * 20), 20);
+		}
+	}
+
+	free(index);
+	free(data);
+	free(hashes);
+
+	return 1;
+}
+
+int pubkey_hash160_to_address(char *address, unsigned char *rmd)
+{
+	int r;
+	unsigned char rmd_bit[21];
+	char base58[21 * 2];
+
+	assert(address);
+	assert(rmd);
+
 	// Set address version bit
 	if (network_is_main())
 	{
@@ -383,7 +539,7 @@ int pubkey_to_address(char *address, PubKey key)
 	r = base58check_encode(base58, rmd_bit, 21);
 	if (r < 0)
 	{
-		error_log("Could not generate address from public key data.");
+		error_log("Could not generate address from hash160.");
 		return -1;
 	}
 
@@ -392,39 +548,34 @@ int pubkey_to_address(char *address, PubKey key)
 	return 1;
 }
 
-int pubkey_to_bech32address(char *address, PubKey key)
+int pubkey_xonly_to_taproot_address(char *address, unsigned char *xonly)
 {
 	int r;
-	unsigned char sha[32];
-	unsigned char rmd[20];
 
 	assert(address);
-	assert(key);
+	assert(xonly);
 
-	if (!pubkey_is_compressed(key))
-	{
-		error_log("Public key is uncompressed. Bech32 addresses require a compressed public key.");
-		return -1;
-	}
-
-	// RMD(SHA(data))
-	r = crypto_get_sha256(sha, key->data, PUBKEY_COMPRESSED_LENGTH + 1);
+	r = bech32m_get_address(address, xonly, PUBKEY_COMPRESSED_LENGTH);
 	if (r < 0)
 	{
-		error_log("Could not generate SHA256 hash from public key data.");
-		return -1;
-	}
-	r = crypto_get_rmd160(rmd, sha, 32);
-	if (r < 0)
-	{
-		error_log("Could not generate RMD160 hash from public key data.");
+		error_log("Could not generate taproot address from x-only key.");
 		return -1;
 	}
 
+	return 1;
+}
+
+int pubkey_hash160_to_bech32address(char *address, unsigned char *rmd)
+{
+	int r;
+
+	assert(address);
+	assert(rmd);
+
 	r = bech32_get_address(address, rmd, 20);
 	if (r < 0)
 	{
-		error_log("Could not generate bech32 address from public key data.");
+		error_log("Could not generate bech32 address from hash160.");
 		return -1;
 	}
 
@@ -525,8 +676,544 @@ int pubkey_address_from_str(char *address, char *str)
 	return 1;
 }
 
+int pubkey_iter_init(PubKeyIter iter, PrivKey start)
+{
+	return pubkey_iter_init_offset(iter, start, NULL);
+}
+
+int pubkey_iter_init_offset(PubKeyIter iter, PrivKey start, PubKey offset)
+{
+	int r;
+	unsigned char privkey_raw[PRIVKEY_LENGTH + 1];
+	struct JacobianPoint jpoint;
+	struct Point point;
+
+	assert(iter);
+	assert(start);
+
+	// Set first, so pubkey_iter_free() is safe whatever happens below.
+	iter->key = NULL;
+	iter->points = NULL;
+	iter->tweak_jpoints = NULL;
+	iter->tweak_points = NULL;
+
+	if (privkey_is_zero(start))
+	{
+		error_log("Private key can not be zero.");
+		return -1;
+	}
+
+	pthread_once(&iter_multiples_once, pubkey_iter_multiples_init);
+	if (iter_multiples_status < 0)
+	{
+		error_log("Could not calculate multiples of the generator point.");
+		return -1;
+	}
+
+	iter->key = malloc(privkey_sizeof());
+	iter->points = malloc(sizeof(*iter->points) * (PUBKEY_ITER_BATCH + 1));
+	if (iter->key == NULL || iter->points == NULL)
+	{
+		error_log("Memory allocation error.");
+		pubkey_iter_free(iter);
+		return -1;
+	}
+
+	// Keep our own copy of the starting key, compression flag included.
+	r = privkey_to_raw(privkey_raw, start, 1);
+	if (r < 0)
+	{
+		error_log("Could not convert private key to raw data.");
+		memset(privkey_raw, 0, sizeof(privkey_raw));
+		pubkey_iter_free(iter);
+		return -1;
+	}
+	r = privkey_from_raw(iter->key, privkey_raw, r);
+	if (r < 0)
+	{
+		error_log("Could not copy private key.");
+		memset(privkey_raw, 0, sizeof(privkey_raw));
+		pubkey_iter_free(iter);
+		return -1;
+	}
+
+	// The first point is the only full scalar multiplication.
+	r = point_mul_generator(&jpoint, privkey_raw);
+	memset(privkey_raw, 0, sizeof(privkey_raw));
+	if (r < 0)
+	{
+		error_log("Could not multiply generator point by private key.");
+		pubkey_iter_free(iter);
+		return -1;
+	}
+	if (offset != NULL)
+	{
+		r = pubkey_get_point(&point, offset);
+		if (r < 0)
+		{
+			error_log("Could not get offset point.");
+			pubkey_iter_free(iter);
+			return -1;
+		}
+		point_jacobian_add_mixed(&jpoint, &jpoint, &point);
+	}
+	r = point_jacobian_to_affine(&iter->points[0], &jpoint);
+	if (r < 0)
+	{
+		error_log("Could not convert public key point to affine coordinates.");
+		pubkey_iter_free(iter);
+		return -1;
+	}
+
+	r = point_batch_add(iter->points + 1, &iter->points[0], iter_multiples, PUBKEY_ITER_BATCH);
+	if (r < 0)
+	{
+		error_log("Could not calculate sequential public keys.");
+		pubkey_iter_free(iter);
+		return -1;
+	}
+
+	iter->pos = 0;
+	iter->compressed = privkey_is_compressed(start);
+
+	return 1;
+}
+
+int pubkey_iter_next(PubKey key, PubKeyIter iter)
+{
+	int r;
+
+	assert(key);
+	assert(iter);
+	assert(iter->points);
+
+	r = pubkey_iter_advance(iter);
+	if (r < 0)
+	{
+		error_log("Could not advance public key iterator.");
+		return -1;
+	}
+
+	pubkey_set_point(key, &iter->points[iter->pos], iter->compressed);
+	iter->pos++;
+
+	return 1;
+}
+
+int pubkey_iter_next_hash160(unsigned char *output, PubKeyIter iter)
+{
+	int r, variant;
+
+	assert(output);
+	assert(iter);
+	assert(iter->points);
+
+	// Hash whatever is left of the current batch, or a whole new batch. The
+	// batch never wraps around, so the offsets passed to
+	// pubkey_iter_get_privkey() stay within it. The only variant is the
+	// point itself, compressed like the starting key.
+	variant = iter->compressed ? 0 : PUBKEY_VARIANT_UNCOMPRESSED;
+	r = pubkey_iter_next_hash160_variants(output, iter, &variant, 1);
+	if (r < 0)
+	{
+		error_log("Could not generate hash160 from public key data.");
+		return -1;
+	}
+
+	return r;
+}
+
+int pubkey_iter_next_hash160_variants(unsigned char *output, PubKeyIter iter, int *variants, int variants_len)
+{
+	int r, n, m, i, j, v;
+	size_t len[PUBKEY_VARIANTS];
+	unsigned char keys[PUBKEY_VARIANTS][PUBKEY_ITER_HASH_CHUNK * (PUBKEY_UNCOMPRESSED_LENGTH + 1)];
+	unsigned char hashes[PUBKEY_ITER_HASH_CHUNK * 20];
+	struct PubKey key;
+	struct Point point;
+	struct Field x[3];
+	struct Field y[2];
+
+	assert(output);
+	assert(iter);
+	assert(iter->points);
+	assert(variants);
+	assert(variants_len > 0 && variants_len <= PUBKEY_VARIANTS);
+
+	// Like pubkey_iter_next_hash160(), but each point gives variants_len
+	// hashes, stored one after the other. Negating a point or applying the
+	// endomorphism costs at most a field multiplication, so every variant
+	// is an extra candidate for next to nothing.
+	for (i = 0; i < variants_len; ++i)
+	{
+		assert(variants[i] >= 0 && variants[i] < PUBKEY_VARIANTS);
+		if (variants[i] & PUBKEY_VARIANT_UNCOMPRESSED)
+		{
+			len[i] = PUBKEY_UNCOMPRESSED_LENGTH + 1;
+		}
+		else
+		{
+			len[i] = PUBKEY_COMPRESSED_LENGTH + 1;
+		}
+	}
+
+	// The keys of a variant all have the same length, so they are
+	// collected a chunk of points at a time and hashed together.
+	n = 0;
+	do
+	{
+		m = 0;
+		do
+		{
+			r = pubkey_iter_advance(iter);
+			if (r < 0)
+			{
+				error_log("Could not advance public key iterator.");
+				return -1;
+			}
+
+			field_set(&x[0], &iter->points[iter->pos].x);
+			field_mul(&x[1], &x[0], &iter_beta[0]);
+			field_mul(&x[2], &x[0], &iter_beta[1]);
+			field_set(&y[0], &iter->points[iter->pos].y);
+			field_neg(&y[1], &y[0]);
+			iter->pos++;
+
+			for (i = 0; i < variants_len; ++i)
+			{
+				v = variants[i];
+				field_set(&point.x, &x[v / PUBKEY_VARIANT_ENDO]);
+				field_set(&point.y, &y[(v & PUBKEY_VARIANT_NEGATED) != 0]);
+				pubkey_set_point(&key, &point, !(v & PUBKEY_VARIANT_UNCOMPRESSED));
+				memcpy(keys[i] + (m * len[i]), key.data, len[i]);
+			}
+
+			++m;
+		}
+		while (m < PUBKEY_ITER_HASH_CHUNK && iter->pos < PUBKEY_ITER_BATCH);
+
+		for (i = 0; i < variants_len; ++i)
+		{
+			r = crypto_get_hash160_batch(hashes, keys[i], len[i], m);
+			if (r < 0)
+			{
+				error_log("Could not generate hash160 from public key data.");
+				return -1;
+			}
+
+			for (j = 0; j < m; ++j)
+			{
+				memcpy(output + ((((n + j) * variants_len) + i) * 20), hashes + (j * 20), 20);
+			}
+		}
+
+		n += m;
+	}
+	while (iter->pos < PUBKEY_ITER_BATCH);
+
+	return n;
+}
+
+int pubkey_iter_next_xonly_variants(unsigned char *output, PubKeyIter iter, int *variants, int variants_len, int tweak)
+{
+	int r, n, i;
+	size_t len;
+	unsigned char buffer[96];
+	unsigned char tweak_raw[32];
+	struct Point point;
+	struct Field x[3];
+
+	assert(output);
+	assert(iter);
+	assert(iter->points);
+	assert(variants);
+	assert(variants_len <= PUBKEY_VARIANTS);
+
+	// Like pubkey_iter_next_hash160_variants(), but gives the 32 byte x-only
+	// key of each point. Negation doesn't change x, so only the
+	// endomorphism part of a variant matters.
+	if (tweak)
+	{
+		if (iter->tweak_jpoints == NULL)
+		{
+			len = PUBKEY_ITER_BATCH * PUBKEY_VARIANTS;
+			iter->tweak_jpoints = malloc(sizeof(*iter->tweak_jpoints) * len);
+			iter->tweak_points = malloc(sizeof(*iter->tweak_points) * len);
+			if (iter->tweak_jpoints == NULL || iter->tweak_points == NULL)
+			{
+				error_log("Memory allocation error.");
+				return -1;
+			}
+		}
+		memcpy(buffer, iter_taptweak, 32);
+		memcpy(buffer + 32, iter_taptweak, 32);
+	}
+
+	n = 0;
+	do
+	{
+		r = pubkey_iter_advance(iter);
+		if (r < 0)
+		{
+			error_log("Could not advance public key iterator.");
+			return -1;
+		}
+
+		field_set(&x[0], &iter->points[iter->pos].x);
+		field_mul(&x[1], &x[0], &iter_beta[0]);
+		field_mul(&x[2], &x[0], &iter_beta[1]);
+
+		for (i = 0; i < variants_len; ++i)
+		{
+			assert(variants[i] >= 0 && variants[i] < PUBKEY_VARIANTS);
+			field_get_raw(output + (((n * variants_len) + i) * 32), &x[variants[i] / PUBKEY_VARIANT_ENDO]);
+			if (!tweak)
+			{
+				continue;
+			}
+
+			// BIP 86 output key: the internal key with an even y, plus
+			// hash_TapTweak(x) * G. A tweak at or above the group order
+			// is too unlikely to check for.
+			memcpy(buffer + 64, output + (((n * variants_len) + i) * 32), 32);
+			r = crypto_get_sha256(tweak_raw, buffer, sizeof(buffer));
+			if (r < 0)
+			{
+				error_log("Could not generate tweak hash.");
+				return -1;
+			}
+			r = point_mul_generator(&iter->tweak_jpoints[(n * variants_len) + i], tweak_raw);
+			if (r < 0)
+			{
+				error_log("Could not multiply generator point by tweak.");
+				return -1;
+			}
+			field_set(&point.x, &x[variants[i] / PUBKEY_VARIANT_ENDO]);
+			field_set(&point.y, &iter->points[iter->pos].y);
+			if (field_is_odd(&point.y))
+			{
+				field_neg(&point.y, &point.y);
+			}
+			point_jacobian_add_mixed(&iter->tweak_jpoints[(n * variants_len) + i], &iter->tweak_jpoints[(n * variants_len) + i], &point);
+		}
+
+		iter->pos++;
+		++n;
+	}
+	while (iter->pos < PUBKEY_ITER_BATCH);
+
+	// One shared inversion takes every tweaked key back to affine x.
+	if (tweak)
+	{
+		r = point_batch_normalize(iter->tweak_points, iter->tweak_jpoints, n * variants_len);
+		if (r < 0)
+		{
+			error_log("Could not normalize tweaked keys.");
+			return -1;
+		}
+		for (i = 0; i < n * variants_len; ++i)
+		{
+			field_get_raw(output + (i * 32), &iter->tweak_points[i].x);
+		}
+	}
+
+	return n;
+}
+
+int pubkey_iter_get_privkey(PrivKey key, PubKeyIter iter, size_t back)
+{
+	int r;
+	unsigned char privkey_raw[PRIVKEY_LENGTH + 1];
+
+	assert(key);
+	assert(iter);
+
+	// back counts keys before the most recently generated one, in the
+	// current batch.
+	if (iter->pos <= back)
+	{
+		error_log("Public key is not in the current batch.");
+		return -1;
+	}
+
+	r = privkey_to_raw(privkey_raw, iter->key, 1);
+	if (r < 0)
+	{
+		error_log("Could not convert private key to raw data.");
+		return -1;
+	}
+	r = privkey_from_raw(key, privkey_raw, r);
+	if (r < 0)
+	{
+		error_log("Could not copy private key.");
+		return -1;
+	}
+
+	privkey_add_uint(key, iter->pos - 1 - back);
+
+	return 1;
+}
+
+int pubkey_iter_get_privkey_variant(PrivKey key, PubKeyIter iter, size_t back, int variant)
+{
+	int r, i;
+
+	assert(key);
+	assert(iter);
+	assert(variant >= 0 && variant < PUBKEY_VARIANTS);
+
+	r = pubkey_iter_get_privkey(key, iter, back);
+	if (r < 0)
+	{
+		error_log("Could not get private key from iterator.");
+		return -1;
+	}
+
+	for (i = 0; i < variant / PUBKEY_VARIANT_ENDO; ++i)
+	{
+		privkey_mul_lambda(key);
+	}
+	if (variant & PUBKEY_VARIANT_NEGATED)
+	{
+		privkey_negate(key);
+	}
+	if (variant & PUBKEY_VARIANT_UNCOMPRESSED)
+	{
+		privkey_uncompress(key);
+	}
+	else
+	{
+		privkey_compress(key);
+	}
+
+	return 1;
+}
+
+void pubkey_iter_free(PubKeyIter iter)
+{
+	assert(iter);
+
+	free(iter->key);
+	free(iter->points);
+	free(iter->tweak_jpoints);
+	free(iter->tweak_points);
+	iter->key = NULL;
+	iter->points = NULL;
+	iter->tweak_jpoints = NULL;
+	iter->tweak_points = NULL;
+}
+
+size_t pubkey_iter_sizeof(void)
+{
+	return sizeof(struct PubKeyIter);
+}
+
 size_t pubkey_sizeof(void)
 {
 	return sizeof(struct PubKey);
 }
 
+static void pubkey_set_point(PubKey pubkey, Point point, int compressed)
+{
+	// Setting compression flag
+	if (compressed)
+	{
+		if (!field_is_odd(&point->y))
+		{
+			pubkey->data[0] = PUBKEY_COMPRESSED_FLAG_EVEN;
+		}
+		else
+		{
+			pubkey->data[0] = PUBKEY_COMPRESSED_FLAG_ODD;
+		}
+	}
+	else
+	{
+		pubkey->data[0] = PUBKEY_UNCOMPRESSED_FLAG;
+	}
+
+	// Exporting x,y coordinates as fixed width byte strings.
+	field_get_raw(pubkey->data + 1, &point->x);
+	if (!compressed)
+	{
+		field_get_raw(pubkey->data + 33, &point->y);
+	}
+}
+
+// Gets the curve point of a public key in either encoding.
+static int pubkey_get_point(Point point, PubKey pubkey)
+{
+	int r;
+	struct PubKey key;
+
+	memcpy(&key, pubkey, sizeof(key));
+	r = pubkey_decompress(&key);
+	if (r < 0)
+	{
+		error_log("Could not decompress public key.");
+		return -1;
+	}
+
+	r = field_set_raw(&point->x, key.data + 1);
+	if (r < 0)
+	{
+		error_log("Invalid point x value.");
+		return -1;
+	}
+	r = field_set_raw(&point->y, key.data + 33);
+	if (r < 0)
+	{
+		error_log("Invalid point y value.");
+		return -1;
+	}
+
+	if (!point_verify(point))
+	{
+		error_log("Public key is not on the curve.");
+		return -1;
+	}
+
+	return 1;
+}
+
+// Refills the batch once every point in it has been used.
+static int pubkey_iter_advance(PubKeyIter iter)
+{
+	int r;
+
+	if (iter->pos == PUBKEY_ITER_BATCH)
+	{
+		// Advance the whole batch by PUBKEY_ITER_BATCH * G, sharing one
+		// field inversion among all of the additions.
+		point_set(&iter->points[0], &iter->points[PUBKEY_ITER_BATCH]);
+		r = point_batch_add(iter->points + 1, &iter->points[0], iter_multiples, PUBKEY_ITER_BATCH);
+		if (r < 0)
+		{
+			error_log("Could not calculate sequential public keys.");
+			return -1;
+		}
+
+		privkey_add_uint(iter->key, PUBKEY_ITER_BATCH);
+		iter->pos = 0;
+	}
+
+	return 1;
+}
+
+static void pubkey_iter_multiples_init(void)
+{
+	iter_multiples_status = point_set_generator_multiples(iter_multiples, PUBKEY_ITER_BATCH);
+	if (iter_multiples_status < 0)
+	{
+		return;
+	}
+
+	iter_multiples_status = field_set_raw(&iter_beta[0], iter_beta_raw);
+	field_sqr(&iter_beta[1], &iter_beta[0]);
+	if (iter_multiples_status < 0)
+	{
+		return;
+	}
+
+	iter_multiples_status = crypto_get_sha256(iter_taptweak, (unsigned char *)"TapTweak", 8);
+}
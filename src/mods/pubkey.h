@@ -12,10 +12,21 @@
 
 #define PUBKEY_UNCOMPRESSED_LENGTH    64
 #define PUBKEY_COMPRESSED_LENGTH      32
+#define PUBKEY_ITER_BATCH             1024
+
+// Variants of an iterator point. A variant number is the sum of the flags
+// below and zero to two times PUBKEY_VARIANT_ENDO, the number of times
+// the secp256k1 endomorphism is applied.
+#define PUBKEY_VARIANT_UNCOMPRESSED   0x01
+#define PUBKEY_VARIANT_NEGATED        0x02
+#define PUBKEY_VARIANT_ENDO           0x04
+#define PUBKEY_VARIANTS               12
 
 typedef struct PubKey *PubKey;
+typedef struct PubKeyIter *PubKeyIter;
 
 int pubkey_get(PubKey, PrivKey);
+int pubkey_get_batch(PubKey *, PrivKey *, size_t);
 int pubkey_from_raw(PubKey key, unsigned char *input, size_t input_len);
 int pubkey_compress(PubKey);
 int pubkey_decompress(PubKey);
@@ -24,8 +35,23 @@ int pubkey_to_hex(char *, PubKey);
 int pubkey_to_raw(unsigned char *, PubKey);
 int pubkey_to_address(char *, PubKey);
 int pubkey_to_bech32address(char *, PubKey);
+int pubkey_get_hash160(unsigned char *, PubKey);
+int pubkey_get_hash160_batch(unsigned char *, PubKey *, size_t);
+int pubkey_hash160_to_address(char *, unsigned char *);
+int pubkey_hash160_to_bech32address(char *, unsigned char *);
+int pubkey_xonly_to_taproot_address(char *, unsigned char *);
 int pubkey_address_from_wif(char *, char *);
 int pubkey_address_from_str(char *, char *);
+int pubkey_iter_init(PubKeyIter, PrivKey);
+int pubkey_iter_init_offset(PubKeyIter, PrivKey, PubKey);
+int pubkey_iter_next(PubKey, PubKeyIter);
+int pubkey_iter_next_hash160(unsigned char *, PubKeyIter);
+int pubkey_iter_next_hash160_variants(unsigned char *, PubKeyIter, int *, int);
+int pubkey_iter_next_xonly_variants(unsigned char *, PubKeyIter, int *, int, int);
+int pubkey_iter_get_privkey(PrivKey, PubKeyIter, size_t);
+int pubkey_iter_get_privkey_variant(PrivKey, PubKeyIter, size_t, int);
+void pubkey_iter_free(PubKeyIter);
+size_t pubkey_iter_sizeof(void);
 size_t pubkey_sizeof(void);
 
 #endif
@@ -5,42 +5,268 @@
  * under the terms of the GPL License. See LICENSE for more details.
  */
 
-#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
 #include <errno.h>
+#include <pthread.h>
+#include <sys/random.h>
 #include <assert.h>
 #include "error.h"
 
-#define RANDOM_SOURCE "/dev/urandom"
+#define RANDOM_SOURCE         "/dev/urandom"
+#define RANDOM_KEY_LENGTH     32
+#define RANDOM_BLOCK_LENGTH   64
+#define RANDOM_BLOCKS         16
+#define RANDOM_RESEED_BYTES   (1 << 20)
+
+#define ROTL(x, n)            (((x) << (n)) | ((x) >> (32 - (n))))
+#define QUARTERROUND(a, b, c, d) \
+	a += b; d ^= a; d = ROTL(d, 16); \
+	c += d; b ^= c; b = ROTL(b, 12); \
+	a += b; d ^= a; d = ROTL(d, 8);  \
+	c += d; b ^= c; b = ROTL(b, 7);
+
+// A ChaCha20 keystream (RFC 8439) generator, one per thread. Output is
+// made a buffer at a time. The start of each buffer becomes the next key
+// and everything handed out is wiped, so the state never holds anything
+// that could give away earlier output.
+struct RandomState
+{
+	uint32_t key[RANDOM_KEY_LENGTH / 4];
+	unsigned char buffer[RANDOM_BLOCKS * RANDOM_BLOCK_LENGTH];
+	size_t available;
+	size_t since_seed;
+	unsigned long generation;
+	int seeded;
+};
+
+static int random_seed(struct RandomState *);
+static int random_source(unsigned char *, size_t);
+static void random_refill(struct RandomState *);
+static void random_chacha20_block(unsigned char *, uint32_t *, uint32_t);
+static void random_atfork_register(void);
+static void random_atfork_child(void);
+
+static __thread struct RandomState random_state;
+
+// Bumped in the child after a fork, so that no thread there goes on with
+// the keystream its parent also has.
+static unsigned long random_generation = 0;
+static pthread_once_t random_atfork_once = PTHREAD_ONCE_INIT;
 
 int random_get(unsigned char *output, size_t bytes)
 {
-	size_t i;
-	int c;
-	FILE *source;
+	int r;
+	size_t n, start;
+	struct RandomState *s;
 
 	assert(output);
 	assert(bytes);
 
-	source = fopen(RANDOM_SOURCE, "r");
-	if (source == NULL)
+	pthread_once(&random_atfork_once, random_atfork_register);
+
+	s = &random_state;
+
+	// Seed on first use, after a fork, and again after every
+	// RANDOM_RESEED_BYTES bytes of output.
+	if (!s->seeded || s->generation != random_generation || s->since_seed >= RANDOM_RESEED_BYTES)
 	{
-		error_log("Unable to open source file %s. Errno %i.", RANDOM_SOURCE, errno);
+		r = random_seed(s);
+		if (r < 0)
+		{
+			error_log("Could not seed random number generator.");
+			return -1;
+		}
+	}
+
+	s->since_seed += bytes;
+
+	while (bytes > 0)
+	{
+		if (s->available == 0)
+		{
+			random_refill(s);
+		}
+
+		n = (bytes < s->available) ? bytes : s->available;
+		start = sizeof(s->buffer) - s->available;
+
+		memcpy(output, s->buffer + start, n);
+		memset(s->buffer + start, 0, n);
+
+		s->available -= n;
+		output += n;
+		bytes -= n;
+	}
+
+	return 1;
+}
+
+// Mixes fresh entropy into the key and drops any buffered output.
+static int random_seed(struct RandomState *s)
+{
+	int r;
+	size_t i;
+	unsigned char seed[RANDOM_KEY_LENGTH];
+
+	r = random_source(seed, RANDOM_KEY_LENGTH);
+	if (r < 0)
+	{
+		error_log("Could not get entropy from the operating system.");
 		return -1;
 	}
 
-	for (i = 0; i < bytes; ++i)
+	for (i = 0; i < RANDOM_KEY_LENGTH / 4; ++i)
 	{
-		c = fgetc(source);
-		if (c == EOF)
+		s->key[i] ^= (uint32_t)seed[i * 4] | ((uint32_t)seed[(i * 4) + 1] << 8) | ((uint32_t)seed[(i * 4) + 2] << 16) | ((uint32_t)seed[(i * 4) + 3] << 24);
+	}
+	memset(seed, 0, RANDOM_KEY_LENGTH);
+	memset(s->buffer, 0, sizeof(s->buffer));
+
+	s->available = 0;
+	s->since_seed = 0;
+	s->generation = random_generation;
+	s->seeded = 1;
+
+	return 1;
+}
+
+// Reads from getrandom(2), or from RANDOM_SOURCE on kernels without it.
+static int random_source(unsigned char *output, size_t bytes)
+{
+	int fd;
+	ssize_t r;
+
+	while (bytes > 0)
+	{
+		r = getrandom(output, bytes, 0);
+		if (r < 0)
 		{
-			error_log("Could not read character from source file %s.", RANDOM_SOURCE);
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			if (errno == ENOSYS)
+			{
+				break;
+			}
+			error_log("Could not read from getrandom. Errno %i.", errno);
 			return -1;
 		}
+		output += r;
+		bytes -= r;
+	}
+
+	if (bytes == 0)
+	{
+		return 1;
+	}
+
+	fd = open(RANDOM_SOURCE, O_RDONLY);
+	if (fd < 0)
+	{
+		error_log("Unable to open source file %s. Errno %i.", RANDOM_SOURCE, errno);
+		return -1;
+	}
 
-		output[i] = c;
+	while (bytes > 0)
+	{
+		r = read(fd, output, bytes);
+		if (r < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (r <= 0)
+		{
+			error_log("Could not read from source file %s.", RANDOM_SOURCE);
+			close(fd);
+			return -1;
+		}
+		output += r;
+		bytes -= r;
 	}
 
-	fclose(source);
+	close(fd);
 
 	return 1;
 }
+
+static void random_refill(struct RandomState *s)
+{
+	size_t i;
+
+	for (i = 0; i < RANDOM_BLOCKS; ++i)
+	{
+		random_chacha20_block(s->buffer + (i * RANDOM_BLOCK_LENGTH), s->key, (uint32_t)i);
+	}
+
+	// The key is used for one buffer only. The next one comes from the
+	// start of this buffer, which is never handed out.
+	for (i = 0; i < RANDOM_KEY_LENGTH / 4; ++i)
+	{
+		s->key[i] = (uint32_t)s->buffer[i * 4] | ((uint32_t)s->buffer[(i * 4) + 1] << 8) | ((uint32_t)s->buffer[(i * 4) + 2] << 16) | ((uint32_t)s->buffer[(i * 4) + 3] << 24);
+	}
+	memset(s->buffer, 0, RANDOM_KEY_LENGTH);
+
+	s->available = sizeof(s->buffer) - RANDOM_KEY_LENGTH;
+}
+
+// One 64 byte block of keystream. Every key is used for a single buffer,
+// so the nonce is always zero.
+static void random_chacha20_block(unsigned char *output, uint32_t *key, uint32_t counter)
+{
+	int i;
+	uint32_t x[16], state[16];
+
+	// "expand 32-byte k"
+	state[0] = 0x61707865;
+	state[1] = 0x3320646e;
+	state[2] = 0x79622d32;
+	state[3] = 0x6b206574;
+	for (i = 0; i < 8; ++i)
+	{
+		state[4 + i] = key[i];
+	}
+	state[12] = counter;
+	state[13] = 0;
+	state[14] = 0;
+	state[15] = 0;
+
+	memcpy(x, state, sizeof(x));
+
+	for (i = 0; i < 10; ++i)
+	{
+		// Column round
+		QUARTERROUND(x[0], x[4], x[8],  x[12])
+		QUARTERROUND(x[1], x[5], x[9],  x[13])
+		QUARTERROUND(x[2], x[6], x[10], x[14])
+		QUARTERROUND(x[3], x[7], x[11], x[15])
+
+		// Diagonal round
+		QUARTERROUND(x[0], x[5], x[10], x[15])
+		QUARTERROUND(x[1], x[6], x[11], x[12])
+		QUARTERROUND(x[2], x[7], x[8],  x[13])
+		QUARTERROUND(x[3], x[4], x[9],  x[14])
+	}
+
+	for (i = 0; i < 16; ++i)
+	{
+		x[i] += state[i];
+		output[i * 4]       = x[i] & 0xff;
+		output[(i * 4) + 1] = (x[i] >> 8) & 0xff;
+		output[(i * 4) + 2] = (x[i] >> 16) & 0xff;
+		output[(i * 4) + 3] = (x[i] >> 24) & 0xff;
+	}
+}
+
+static void random_atfork_register(void)
+{
+	pthread_atfork(NULL, NULL, random_atfork_child);
+}
+
+static void random_atfork_child(void)
+{
+	++random_generation;
+}
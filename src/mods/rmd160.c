@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2017 Brian Barto
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GPL License. See LICENSE for more details.
+ */
+
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <assert.h>
+#include "rmd160.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RMD160_X86 1
+#endif
+
+// Messages hashed side by side in the lanes of a batch.
+#define RMD160_LANES          8
+
+#define ROTL(x, n)            (((x) << (n)) | ((x) >> (32 - (n))))
+#define F1(x, y, z)           ((x) ^ (y) ^ (z))
+#define F2(x, y, z)           (((x) & (y)) | (~(x) & (z)))
+#define F3(x, y, z)           (((x) | ~(y)) ^ (z))
+#define F4(x, y, z)           (((x) & (z)) | ((y) & ~(z)))
+#define F5(x, y, z)           ((x) ^ ((y) | ~(z)))
+
+// One step of either line. The caller rotates the five words afterwards.
+#define STEP(a, b, c, d, e, f, x, k, s) \
+	a = ROTL(a + f(b, c, d) + x + k, s) + e; \
+	c = ROTL(c, 10);
+
+// Round i of both lines, 16 steps each, with f on the left line and fr on
+// the right. Unrolled, the tables fold into constants and the word
+// rotation into register renaming.
+#define ROUND(i, f, fr) \
+	_Pragma("GCC unroll 16") \
+	for (j = (i) * 16; j < ((i) + 1) * 16; ++j) \
+	{ \
+		STEP(a, b, c, d, e, f, x[rmd160_r[j]], rmd160_k[i], rmd160_s[j]); \
+		STEP(ar, br, cr, dr, er, fr, x[rmd160_rr[j]], rmd160_kr[i], rmd160_sr[j]); \
+		t = a; a = e; e = d; d = c; c = b; b = t; \
+		t = ar; ar = er; er = dr; dr = cr; cr = br; br = t; \
+	}
+
+#ifdef RMD160_X86
+typedef uint32_t Rmd160Lanes __attribute__((vector_size(RMD160_LANES * 4)));
+#endif
+
+static size_t rmd160_pad(unsigned char *, unsigned char *, size_t);
+static void rmd160_transform(uint32_t *, unsigned char *, size_t);
+#ifdef RMD160_X86
+static void rmd160_hash_lanes(unsigned char *, unsigned char *, size_t);
+static void rmd160_transform_lanes(Rmd160Lanes *, unsigned char **, size_t);
+#endif
+static void rmd160_select(void);
+
+static const uint32_t rmd160_init[5] = {
+	0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
+};
+
+// Message word order, left and right line.
+static const unsigned char rmd160_r[80] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	7, 4, 13, 1, 10, 6, 15, 3, 12, 0, 9, 5, 2, 14, 11, 8,
+	3, 10, 14, 4, 9, 15, 8, 1, 2, 7, 0, 6, 13, 11, 5, 12,
+	1, 9, 11, 10, 0, 8, 12, 4, 13, 3, 7, 15, 14, 5, 6, 2,
+	4, 0, 5, 9, 7, 12, 2, 10, 14, 1, 3, 8, 11, 6, 15, 13
+};
+static const unsigned char rmd160_rr[80] = {
+	5, 14, 7, 0, 9, 2, 11, 4, 13, 6, 15, 8, 1, 10, 3, 12,
+	6, 11, 3, 7, 0, 13, 5, 10, 14, 15, 8, 12, 4, 9, 1, 2,
+	15, 5, 1, 3, 7, 14, 6, 9, 11, 8, 12, 2, 10, 0, 4, 13,
+	8, 6, 4, 1, 3, 11, 15, 0, 5, 12, 2, 13, 9, 7, 10, 14,
+	12, 15, 10, 4, 1, 5, 8, 7, 6, 2, 13, 14, 0, 3, 9, 11
+};
+
+// Rotation amounts, left and right line.
+static const unsigned char rmd160_s[80] = {
+	11, 14, 15, 12, 5, 8, 7, 9, 11, 13, 14, 15, 6, 7, 9, 8,
+	7, 6, 8, 13, 11, 9, 7, 15, 7, 12, 15, 9, 11, 7, 13, 12,
+	11, 13, 6, 7, 14, 9, 13, 15, 14, 8, 13, 6, 5, 12, 7, 5,
+	11, 12, 14, 15, 14, 15, 9, 8, 9, 14, 5, 6, 8, 6, 5, 12,
+	9, 15, 5, 11, 6, 8, 13, 12, 5, 12, 13, 14, 11, 8, 5, 6
+};
+static const unsigned char rmd160_sr[80] = {
+	8, 9, 9, 11, 13, 15, 15, 5, 7, 7, 8, 11, 14, 14, 12, 6,
+	9, 13, 15, 7, 12, 8, 9, 11, 7, 7, 12, 7, 6, 15, 13, 11,
+	9, 7, 15, 11, 8, 6, 6, 14, 12, 13, 5, 14, 13, 13, 7, 5,
+	15, 5, 8, 11, 14, 14, 6, 14, 6, 9, 12, 9, 12, 5, 15, 8,
+	8, 5, 12, 9, 12, 5, 14, 6, 8, 13, 6, 5, 15, 13, 11, 11
+};
+
+static const uint32_t rmd160_k[5] = {
+	0x00000000, 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xa953fd4e
+};
+static const uint32_t rmd160_kr[5] = {
+	0x50a28be6, 0x5c4dd124, 0x6d703ef3, 0x7a6d76e9, 0x00000000
+};
+
+#ifdef RMD160_X86
+static int rmd160_lanes = 0;
+#endif
+static pthread_once_t rmd160_select_once = PTHREAD_ONCE_INIT;
+
+void rmd160_hash(unsigned char *output, unsigned char *input, size_t input_len)
+{
+	int i;
+	size_t full;
+	uint32_t state[5];
+	unsigned char block[RMD160_BLOCK_LENGTH * 2];
+
+	assert(output);
+	assert(input || input_len == 0);
+
+	memcpy(state, rmd160_init, sizeof(state));
+
+	// The 32 byte SHA-256 digest of a hash160 is a single block.
+	full = input_len / RMD160_BLOCK_LENGTH;
+	rmd160_transform(state, input, full);
+	rmd160_transform(state, block, rmd160_pad(block, input + (full * RMD160_BLOCK_LENGTH), input_len));
+
+	for (i = 0; i < 5; ++i)
+	{
+		output[(i * 4) + 0] = (unsigned char)(state[i]);
+		output[(i * 4) + 1] = (unsigned char)(state[i] >> 8);
+		output[(i * 4) + 2] = (unsigned char)(state[i] >> 16);
+		output[(i * 4) + 3] = (unsigned char)(state[i] >> 24);
+	}
+}
+
+// Hashes n messages of input_len bytes each, stored one after the other.
+// The digests are stored the same way.
+void rmd160_hash_batch(unsigned char *output, unsigned char *input, size_t input_len, size_t n)
+{
+	size_t i;
+
+	assert(output);
+	assert(input || input_len == 0);
+
+	pthread_once(&rmd160_select_once, rmd160_select);
+
+	i = 0;
+
+#ifdef RMD160_X86
+	if (rmd160_lanes)
+	{
+		for (; i + RMD160_LANES <= n; i += RMD160_LANES)
+		{
+			rmd160_hash_lanes(output + (i * RMD160_LENGTH), input + (i * input_len), input_len);
+		}
+	}
+#endif
+
+	for (; i < n; ++i)
+	{
+		rmd160_hash(output + (i * RMD160_LENGTH), input + (i * input_len), input_len);
+	}
+}
+
+// Copies the last partial block of a message of input_len bytes, from tail,
+// and pads it. Returns the number of blocks written to block, one or two.
+static size_t rmd160_pad(unsigned char *block, unsigned char *tail, size_t input_len)
+{
+	int i;
+	size_t len, n;
+	uint64_t bits;
+
+	len = input_len % RMD160_BLOCK_LENGTH;
+	n = (len < RMD160_BLOCK_LENGTH - 8) ? 1 : 2;
+
+	memcpy(block, tail, len);
+	block[len] = 0x80;
+	memset(block + len + 1, 0, (n * RMD160_BLOCK_LENGTH) - 8 - len - 1);
+
+	// Unlike SHA-256, the length is little endian.
+	bits = (uint64_t)input_len * 8;
+	for (i = 0; i < 8; ++i)
+	{
+		block[(n * RMD160_BLOCK_LENGTH) - 8 + i] = (unsigned char)(bits >> (i * 8));
+	}
+
+	return n;
+}
+
+static void rmd160_transform(uint32_t *state, unsigned char *data, size_t n)
+{
+	int i, j;
+	uint32_t x[16];
+	uint32_t a, b, c, d, e, ar, br, cr, dr, er, t;
+
+	while (n--)
+	{
+		for (i = 0; i < 16; ++i)
+		{
+			x[i] = data[i * 4] | ((uint32_t)data[(i * 4) + 1] << 8) | ((uint32_t)data[(i * 4) + 2] << 16) | ((uint32_t)data[(i * 4) + 3] << 24);
+		}
+
+		a = ar = state[0];
+		b = br = state[1];
+		c = cr = state[2];
+		d = dr = state[3];
+		e = er = state[4];
+
+		ROUND(0, F1, F5);
+		ROUND(1, F2, F4);
+		ROUND(2, F3, F3);
+		ROUND(3, F4, F2);
+		ROUND(4, F5, F1);
+
+		t = state[1] + c + dr;
+		state[1] = state[2] + d + er;
+		state[2] = state[3] + e + ar;
+		state[3] = state[4] + a + br;
+		state[4] = state[0] + b + cr;
+		state[0] = t;
+
+		data += RMD160_BLOCK_LENGTH;
+	}
+}
+
+#ifdef RMD160_X86
+
+__attribute__((target("avx2")))
+static void rmd160_hash_lanes(unsigned char *output, unsigned char *input, size_t input_len)
+{
+	int i, l;
+	size_t full, n;
+	uint32_t word[RMD160_LANES];
+	unsigned char *blocks[RMD160_LANES];
+	unsigned char pad[RMD160_LANES][RMD160_BLOCK_LENGTH * 2];
+	Rmd160Lanes state[5];
+
+	for (i = 0; i < 5; ++i)
+	{
+		for (l = 0; l < RMD160_LANES; ++l)
+		{
+			word[l] = rmd160_init[i];
+		}
+		memcpy(&state[i], word, sizeof(state[i]));
+	}
+
+	full = input_len / RMD160_BLOCK_LENGTH;
+	for (l = 0; l < RMD160_LANES; ++l)
+	{
+		blocks[l] = input + (l * input_len);
+	}
+	rmd160_transform_lanes(state, blocks, full);
+
+	// The length is the same in every lane, and so is the block count.
+	n = 0;
+	for (l = 0; l < RMD160_LANES; ++l)
+	{
+		n = rmd160_pad(pad[l], input + (l * input_len) + (full * RMD160_BLOCK_LENGTH), input_len);
+		blocks[l] = pad[l];
+	}
+	rmd160_transform_lanes(state, blocks, n);
+
+	for (i = 0; i < 5; ++i)
+	{
+		memcpy(word, &state[i], sizeof(word));
+		for (l = 0; l < RMD160_LANES; ++l)
+		{
+			output[(l * RMD160_LENGTH) + (i * 4) + 0] = (unsigned char)(word[l]);
+			output[(l * RMD160_LENGTH) + (i * 4) + 1] = (unsigned char)(word[l] >> 8);
+			output[(l * RMD160_LENGTH) + (i * 4) + 2] = (unsigned char)(word[l] >> 16);
+			output[(l * RMD160_LENGTH) + (i * 4) + 3] = (unsigned char)(word[l] >> 24);
+		}
+	}
+}
+
+// The scalar transform, on one message per lane. The blocks pointers are
+// advanced past the compressed blocks.
+__attribute__((target("avx2")))
+static void rmd160_transform_lanes(Rmd160Lanes *state, unsigned char **blocks, size_t n)
+{
+	int i, j, l;
+	uint32_t word[RMD160_LANES];
+	unsigned char *data;
+	Rmd160Lanes x[16];
+	Rmd160Lanes a, b, c, d, e, ar, br, cr, dr, er, t;
+
+	while (n--)
+	{
+		for (i = 0; i < 16; ++i)
+		{
+			for (l = 0; l < RMD160_LANES; ++l)
+			{
+				data = blocks[l] + (i * 4);
+				word[l] = data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+			}
+			memcpy(&x[i], word, sizeof(x[i]));
+		}
+
+		a = ar = state[0];
+		b = br = state[1];
+		c = cr = state[2];
+		d = dr = state[3];
+		e = er = state[4];
+
+		ROUND(0, F1, F5);
+		ROUND(1, F2, F4);
+		ROUND(2, F3, F3);
+		ROUND(3, F4, F2);
+		ROUND(4, F5, F1);
+
+		t = state[1] + c + dr;
+		state[1] = state[2] + d + er;
+		state[2] = state[3] + e + ar;
+		state[3] = state[4] + a + br;
+		state[4] = state[0] + b + cr;
+		state[0] = t;
+
+		for (l = 0; l < RMD160_LANES; ++l)
+		{
+			blocks[l] += RMD160_BLOCK_LENGTH;
+		}
+	}
+}
+
+#endif
+
+static void rmd160_select(void)
+{
+#ifdef RMD160_X86
+	// There is no SSE2 build of the lanes. Its two lines are mostly
+	// rotates, which SSE2 has no instruction for, and two four lane halves
+	// measured no faster than one message at a time.
+	if (__builtin_cpu_supports("avx2"))
+	{
+		rmd160_lanes = 1;
+	}
+#endif
+}
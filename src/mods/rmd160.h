@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2017 Brian Barto
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GPL License. See LICENSE for more details.
+ */
+
+#ifndef RMD160_H
+#define RMD160_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RMD160_LENGTH         20
+#define RMD160_BLOCK_LENGTH   64
+
+void rmd160_hash(unsigned char *, unsigned char *, size_t);
+void rmd160_hash_batch(unsigned char *, unsigned char *, size_t, size_t);
+
+#endif
@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <string.h>
 #include "script.h"
+#include "hex.h"
 #include "error.h"
 
 #define MAX_OPS_PER_SCRIPT 201
@@ -255,11 +256,8 @@ char *script_from_raw(unsigned char *raw, size_t l)
 			{
 				// TODO - handle memory allocation error
 			}
-			for (j = 0; j < op; ++j, ++raw)
-			{
-				sprintf(ops[c] + (j * 2), "%02x", *raw);
-			}
-			ops[c][j * 2] = '\0';
+			hex_encode(ops[c], raw, op);
+			raw += op;
 			i += op;
 		//} else if (op == 0x4c) {
 		//} else if (op == 0x4d) {
@@ -0,0 +1,509 @@
+/*
+ * Copyright (c) 2017 Brian Barto
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GPL License. See LICENSE for more details.
+ */
+
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <assert.h>
+#include "sha256.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define SHA256_X86 1
+#endif
+
+#define ROTR(x, n)     (((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z)    (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z)   (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define SIG0(x)        (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define SIG1(x)        (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define GAM0(x)        (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define GAM1(x)        (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+
+// Messages hashed side by side in the lanes of a batch.
+#define SHA256_LANES          8
+
+// Compresses n consecutive 64 byte blocks into the state.
+typedef void (*Sha256Transform)(uint32_t *, unsigned char *, size_t);
+
+#ifdef SHA256_X86
+typedef uint32_t Sha256Lanes __attribute__((vector_size(SHA256_LANES * 4)));
+#endif
+
+static size_t sha256_pad(unsigned char *, unsigned char *, size_t);
+static void sha256_digest(unsigned char *, uint32_t *);
+static void sha256_transform_scalar(uint32_t *, unsigned char *, size_t);
+#ifdef SHA256_X86
+static void sha256_transform_shani(uint32_t *, unsigned char *, size_t);
+static void sha256_hash_lanes(unsigned char *, unsigned char *, size_t);
+static void sha256_transform_lanes(Sha256Lanes *, unsigned char **, size_t);
+#endif
+static void sha256_select(void);
+
+static const uint32_t sha256_iv[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// The transform is picked once, from what the processor supports.
+static Sha256Transform sha256_transform = sha256_transform_scalar;
+#ifdef SHA256_X86
+static int sha256_lanes = 0;
+#endif
+static pthread_once_t sha256_select_once = PTHREAD_ONCE_INIT;
+
+void sha256_hash(unsigned char *output, unsigned char *input, size_t input_len)
+{
+	size_t full;
+	uint32_t state[8];
+	unsigned char block[SHA256_BLOCK_LENGTH * 2];
+
+	assert(output);
+	assert(input || input_len == 0);
+
+	pthread_once(&sha256_select_once, sha256_select);
+
+	memcpy(state, sha256_iv, sizeof(state));
+
+	// Whole blocks are compressed straight from the input. Only the tail
+	// and the padding are copied, so the 32, 33 and 65 byte hashes of keys
+	// and hashes take one, one and two compressions, with no allocation.
+	full = input_len / SHA256_BLOCK_LENGTH;
+	if (full > 0)
+	{
+		sha256_transform(state, input, full);
+	}
+
+	sha256_transform(state, block, sha256_pad(block, input + (full * SHA256_BLOCK_LENGTH), input_len));
+
+	sha256_digest(output, state);
+}
+
+void sha256_init(Sha256 ctx)
+{
+	assert(ctx);
+
+	memcpy(ctx->state, sha256_iv, sizeof(ctx->state));
+	ctx->len = 0;
+}
+
+void sha256_update(Sha256 ctx, unsigned char *input, size_t input_len)
+{
+	size_t fill, n;
+
+	assert(ctx);
+	assert(input || input_len == 0);
+
+	pthread_once(&sha256_select_once, sha256_select);
+
+	fill = ctx->len % SHA256_BLOCK_LENGTH;
+	ctx->len += input_len;
+
+	// Top up a partly filled block first.
+	if (fill > 0)
+	{
+		n = SHA256_BLOCK_LENGTH - fill;
+		if (n > input_len)
+		{
+			n = input_len;
+		}
+		memcpy(ctx->buffer + fill, input, n);
+		input += n;
+		input_len -= n;
+		if (fill + n < SHA256_BLOCK_LENGTH)
+		{
+			return;
+		}
+		sha256_transform(ctx->state, ctx->buffer, 1);
+	}
+
+	// Whole blocks are compressed in place, only the rest is buffered.
+	n = input_len / SHA256_BLOCK_LENGTH;
+	if (n > 0)
+	{
+		sha256_transform(ctx->state, input, n);
+	}
+	memcpy(ctx->buffer, input + (n * SHA256_BLOCK_LENGTH), input_len % SHA256_BLOCK_LENGTH);
+}
+
+void sha256_final(unsigned char *output, Sha256 ctx)
+{
+	unsigned char block[SHA256_BLOCK_LENGTH * 2];
+
+	assert(output);
+	assert(ctx);
+
+	pthread_once(&sha256_select_once, sha256_select);
+
+	sha256_transform(ctx->state, block, sha256_pad(block, ctx->buffer, ctx->len));
+
+	sha256_digest(output, ctx->state);
+}
+
+// Hashes n messages of input_len bytes each, stored one after the other.
+// The digests are stored the same way.
+void sha256_hash_batch(unsigned char *output, unsigned char *input, size_t input_len, size_t n)
+{
+	size_t i;
+
+	assert(output);
+	assert(input || input_len == 0);
+
+	pthread_once(&sha256_select_once, sha256_select);
+
+	i = 0;
+
+#ifdef SHA256_X86
+	// Messages of equal length pad and compress in step, so they can be
+	// hashed eight at once in vector lanes.
+	if (sha256_lanes)
+	{
+		for (; i + SHA256_LANES <= n; i += SHA256_LANES)
+		{
+			sha256_hash_lanes(output + (i * SHA256_LENGTH), input + (i * input_len), input_len);
+		}
+	}
+#endif
+
+	for (; i < n; ++i)
+	{
+		sha256_hash(output + (i * SHA256_LENGTH), input + (i * input_len), input_len);
+	}
+}
+
+// Copies the last partial block of a message of input_len bytes, from tail,
+// and pads it. Returns the number of blocks written to block, one or two.
+static size_t sha256_pad(unsigned char *block, unsigned char *tail, size_t input_len)
+{
+	int i;
+	size_t len, n;
+	uint64_t bits;
+
+	len = input_len % SHA256_BLOCK_LENGTH;
+	n = (len < SHA256_BLOCK_LENGTH - 8) ? 1 : 2;
+
+	memcpy(block, tail, len);
+	block[len] = 0x80;
+	memset(block + len + 1, 0, (n * SHA256_BLOCK_LENGTH) - 8 - len - 1);
+
+	bits = (uint64_t)input_len * 8;
+	for (i = 0; i < 8; ++i)
+	{
+		block[(n * SHA256_BLOCK_LENGTH) - 1 - i] = (unsigned char)(bits >> (i * 8));
+	}
+
+	return n;
+}
+
+// Writes the state out as the big endian digest.
+static void sha256_digest(unsigned char *output, uint32_t *state)
+{
+	int i;
+
+	for (i = 0; i < 8; ++i)
+	{
+		output[(i * 4) + 0] = (unsigned char)(state[i] >> 24);
+		output[(i * 4) + 1] = (unsigned char)(state[i] >> 16);
+		output[(i * 4) + 2] = (unsigned char)(state[i] >> 8);
+		output[(i * 4) + 3] = (unsigned char)(state[i]);
+	}
+}
+
+static void sha256_transform_scalar(uint32_t *state, unsigned char *data, size_t n)
+{
+	int i;
+	uint32_t w[64];
+	uint32_t a, b, c, d, e, f, g, h, t1, t2;
+
+	while (n--)
+	{
+		for (i = 0; i < 16; ++i)
+		{
+			w[i] = ((uint32_t)data[i * 4] << 24) | ((uint32_t)data[(i * 4) + 1] << 16) | ((uint32_t)data[(i * 4) + 2] << 8) | data[(i * 4) + 3];
+		}
+		for (i = 16; i < 64; ++i)
+		{
+			w[i] = GAM1(w[i - 2]) + w[i - 7] + GAM0(w[i - 15]) + w[i - 16];
+		}
+
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+		e = state[4];
+		f = state[5];
+		g = state[6];
+		h = state[7];
+
+		// Unrolled, the eight word rotation becomes register renaming.
+		#pragma GCC unroll 64
+		for (i = 0; i < 64; ++i)
+		{
+			t1 = h + SIG1(e) + CH(e, f, g) + sha256_k[i] + w[i];
+			t2 = SIG0(a) + MAJ(a, b, c);
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+
+		data += SHA256_BLOCK_LENGTH;
+	}
+}
+
+#ifdef SHA256_X86
+
+// Four rounds with the SHA extensions. msg holds the next four schedule
+// words, to which the round constants are added here.
+#define SHANI_ROUNDS(i, msg) \
+	tmp = _mm_add_epi32(msg, _mm_loadu_si128((const __m128i *)&sha256_k[(i) * 4])); \
+	s1 = _mm_sha256rnds2_epu32(s1, s0, tmp); \
+	tmp = _mm_shuffle_epi32(tmp, 0x0E); \
+	s0 = _mm_sha256rnds2_epu32(s0, s1, tmp);
+
+// Extends the schedule: m0 becomes the words 16 after m0, from m0 to m3.
+#define SHANI_SCHEDULE(m0, m1, m2, m3) \
+	m0 = _mm_sha256msg1_epu32(m0, m1); \
+	m0 = _mm_add_epi32(m0, _mm_alignr_epi8(m3, m2, 4)); \
+	m0 = _mm_sha256msg2_epu32(m0, m3);
+
+__attribute__((target("sha,sse4.1")))
+static void sha256_transform_shani(uint32_t *state, unsigned char *data, size_t n)
+{
+	__m128i s0, s1, save0, save1, tmp, m0, m1, m2, m3;
+	const __m128i swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+	// The instructions want the state as ABEF and CDGH.
+	tmp = _mm_loadu_si128((const __m128i *)&state[0]);
+	s1 = _mm_loadu_si128((const __m128i *)&state[4]);
+	tmp = _mm_shuffle_epi32(tmp, 0xB1);
+	s1 = _mm_shuffle_epi32(s1, 0x1B);
+	s0 = _mm_alignr_epi8(tmp, s1, 8);
+	s1 = _mm_blend_epi16(s1, tmp, 0xF0);
+
+	while (n--)
+	{
+		save0 = s0;
+		save1 = s1;
+
+		m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 0)), swap);
+		m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), swap);
+		m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), swap);
+		m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), swap);
+
+		SHANI_ROUNDS(0, m0);
+		SHANI_ROUNDS(1, m1);
+		SHANI_ROUNDS(2, m2);
+		SHANI_ROUNDS(3, m3);
+		SHANI_SCHEDULE(m0, m1, m2, m3);
+		SHANI_ROUNDS(4, m0);
+		SHANI_SCHEDULE(m1, m2, m3, m0);
+		SHANI_ROUNDS(5, m1);
+		SHANI_SCHEDULE(m2, m3, m0, m1);
+		SHANI_ROUNDS(6, m2);
+		SHANI_SCHEDULE(m3, m0, m1, m2);
+		SHANI_ROUNDS(7, m3);
+		SHANI_SCHEDULE(m0, m1, m2, m3);
+		SHANI_ROUNDS(8, m0);
+		SHANI_SCHEDULE(m1, m2, m3, m0);
+		SHANI_ROUNDS(9, m1);
+		SHANI_SCHEDULE(m2, m3, m0, m1);
+		SHANI_ROUNDS(10, m2);
+		SHANI_SCHEDULE(m3, m0, m1, m2);
+		SHANI_ROUNDS(11, m3);
+		SHANI_SCHEDULE(m0, m1, m2, m3);
+		SHANI_ROUNDS(12, m0);
+		SHANI_SCHEDULE(m1, m2, m3, m0);
+		SHANI_ROUNDS(13, m1);
+		SHANI_SCHEDULE(m2, m3, m0, m1);
+		SHANI_ROUNDS(14, m2);
+		SHANI_SCHEDULE(m3, m0, m1, m2);
+		SHANI_ROUNDS(15, m3);
+
+		s0 = _mm_add_epi32(s0, save0);
+		s1 = _mm_add_epi32(s1, save1);
+
+		data += SHA256_BLOCK_LENGTH;
+	}
+
+	// Back from ABEF and CDGH to ABCD and EFGH.
+	tmp = _mm_shuffle_epi32(s0, 0x1B);
+	s1 = _mm_shuffle_epi32(s1, 0xB1);
+	s0 = _mm_blend_epi16(tmp, s1, 0xF0);
+	s1 = _mm_alignr_epi8(s1, tmp, 8);
+	_mm_storeu_si128((__m128i *)&state[0], s0);
+	_mm_storeu_si128((__m128i *)&state[4], s1);
+}
+
+__attribute__((target_clones("avx2", "default")))
+static void sha256_hash_lanes(unsigned char *output, unsigned char *input, size_t input_len)
+{
+	int i, l;
+	size_t full, n;
+	uint32_t word[SHA256_LANES];
+	unsigned char *blocks[SHA256_LANES];
+	unsigned char pad[SHA256_LANES][SHA256_BLOCK_LENGTH * 2];
+	Sha256Lanes state[8];
+
+	for (i = 0; i < 8; ++i)
+	{
+		for (l = 0; l < SHA256_LANES; ++l)
+		{
+			word[l] = sha256_iv[i];
+		}
+		memcpy(&state[i], word, sizeof(state[i]));
+	}
+
+	full = input_len / SHA256_BLOCK_LENGTH;
+	for (l = 0; l < SHA256_LANES; ++l)
+	{
+		blocks[l] = input + (l * input_len);
+	}
+	sha256_transform_lanes(state, blocks, full);
+
+	// The length is the same in every lane, and so is the block count.
+	n = 0;
+	for (l = 0; l < SHA256_LANES; ++l)
+	{
+		n = sha256_pad(pad[l], input + (l * input_len) + (full * SHA256_BLOCK_LENGTH), input_len);
+		blocks[l] = pad[l];
+	}
+	sha256_transform_lanes(state, blocks, n);
+
+	for (i = 0; i < 8; ++i)
+	{
+		memcpy(word, &state[i], sizeof(word));
+		for (l = 0; l < SHA256_LANES; ++l)
+		{
+			output[(l * SHA256_LENGTH) + (i * 4) + 0] = (unsigned char)(word[l] >> 24);
+			output[(l * SHA256_LENGTH) + (i * 4) + 1] = (unsigned char)(word[l] >> 16);
+			output[(l * SHA256_LENGTH) + (i * 4) + 2] = (unsigned char)(word[l] >> 8);
+			output[(l * SHA256_LENGTH) + (i * 4) + 3] = (unsigned char)(word[l]);
+		}
+	}
+}
+
+// The scalar transform, on one message per lane. The blocks pointers are
+// advanced past the compressed blocks.
+__attribute__((target_clones("avx2", "default")))
+static void sha256_transform_lanes(Sha256Lanes *state, unsigned char **blocks, size_t n)
+{
+	int i, l;
+	uint32_t word[SHA256_LANES];
+	unsigned char *data;
+	Sha256Lanes w[64];
+	Sha256Lanes a, b, c, d, e, f, g, h, t1, t2;
+
+	while (n--)
+	{
+		for (i = 0; i < 16; ++i)
+		{
+			for (l = 0; l < SHA256_LANES; ++l)
+			{
+				data = blocks[l] + (i * 4);
+				word[l] = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+			}
+			memcpy(&w[i], word, sizeof(w[i]));
+		}
+		for (i = 16; i < 64; ++i)
+		{
+			w[i] = GAM1(w[i - 2]) + w[i - 7] + GAM0(w[i - 15]) + w[i - 16];
+		}
+
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+		e = state[4];
+		f = state[5];
+		g = state[6];
+		h = state[7];
+
+		// Unrolled, the eight word rotation becomes register renaming.
+		#pragma GCC unroll 64
+		for (i = 0; i < 64; ++i)
+		{
+			t1 = h + SIG1(e) + CH(e, f, g) + sha256_k[i] + w[i];
+			t2 = SIG0(a) + MAJ(a, b, c);
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+
+		for (l = 0; l < SHA256_LANES; ++l)
+		{
+			blocks[l] += SHA256_BLOCK_LENGTH;
+		}
+	}
+}
+
+#endif
+
+static void sha256_select(void)
+{
+#ifdef SHA256_X86
+	unsigned int eax, ebx, ecx, edx;
+
+	// SHA extensions are CPUID leaf 7 EBX bit 29, SSE4.1 leaf 1 ECX bit 19.
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & (1 << 19)) &&
+	    __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1 << 29)))
+	{
+		sha256_transform = sha256_transform_shani;
+	}
+	else
+	{
+		// Lanes only pay off without the SHA extensions. They are built for
+		// AVX2 and for the default target. With SSE2, the default splits
+		// each vector into two of four lanes, which still hashes about half
+		// again as fast as one message at a time.
+#ifdef __SSE2__
+		sha256_lanes = 1;
+#else
+		sha256_lanes = __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2017 Brian Barto
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GPL License. See LICENSE for more details.
+ */
+
+#ifndef SHA256_H
+#define SHA256_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA256_LENGTH         32
+#define SHA256_BLOCK_LENGTH   64
+
+// An incremental hash, for input that is not in one piece. It lives on the
+// caller's stack and needs no cleanup.
+typedef struct Sha256 *Sha256;
+struct Sha256
+{
+	uint32_t state[8];
+	unsigned char buffer[SHA256_BLOCK_LENGTH];
+	uint64_t len;
+};
+
+void sha256_hash(unsigned char *, unsigned char *, size_t);
+void sha256_init(Sha256);
+void sha256_update(Sha256, unsigned char *, size_t);
+void sha256_final(unsigned char *, Sha256);
+void sha256_hash_batch(unsigned char *, unsigned char *, size_t, size_t);
+
+#endif
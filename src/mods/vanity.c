@@ -0,0 +1,908 @@
+/*
+ * Copyright (c) 2017 Brian Barto
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GPL License. See LICENSE for more details.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <gmp.h>
+#include <assert.h>
+#include "vanity.h"
+#include "base58.h"
+#include "base32.h"
+#include "network.h"
+#include "crypto.h"
+#include "error.h"
+
+#define VANITY_VERSION_MAINNET    0x00
+#define VANITY_VERSION_TESTNET    0x6F
+#define VANITY_PAYLOAD_LENGTH     25
+#define VANITY_CHECKSUM_BITS      32
+#define VANITY_BASE58_LENGTH_MAX  35
+#define VANITY_HASH_SPACE         1461501637330902918203684832716283019655932542976.0
+#define VANITY_BASE58_BASE        58
+#define VANITY_LIMB_DIGITS        10
+
+typedef unsigned __int128 uint128_t;
+
+// vanity_pow58[i] = 58^i, up to the 58^10 base of a digit limb.
+static const uint64_t vanity_pow58[VANITY_LIMB_DIGITS + 1] = {
+	1ULL,
+	58ULL,
+	3364ULL,
+	195112ULL,
+	11316496ULL,
+	656356768ULL,
+	38068692544ULL,
+	2207984167552ULL,
+	128063081718016ULL,
+	7427658739644928ULL,
+	430804206899405824ULL
+};
+
+// An inclusive range of hash160 values, big endian, and the id of the
+// pattern it came from.
+struct VanityRange
+{
+	unsigned char lo[VANITY_HASH_LENGTH];
+	unsigned char hi[VANITY_HASH_LENGTH];
+	int id;
+};
+
+// The leading bits of a witness program that a bech32 pattern fixes. Only
+// the first len bytes need to be compared.
+struct VanityMask
+{
+	unsigned char prefix[VANITY_MASK_LENGTH];
+	unsigned char mask[VANITY_MASK_LENGTH];
+	size_t len;
+};
+
+// A base58 pattern at a fixed place in an address. allowed[j] has bit d set
+// if digit value d may appear as the j-th pattern character. The first
+// character sits position characters from the start of the address, or
+// with from_end, the last character sits position characters before its
+// end.
+struct VanityPlace
+{
+	uint64_t allowed[VANITY_BASE58_LENGTH_MAX];
+	int len;
+	int position;
+	int from_end;
+};
+
+// Ranges sorted by their low end. Ranges of different patterns may
+// overlap, so max[i] holds the highest hi of ranges 0 through i. A search
+// walking back from the last range starting at or below a hash can stop as
+// soon as max drops below the hash.
+struct VanityTable
+{
+	struct VanityRange *ranges;
+	unsigned char (*max)[VANITY_HASH_LENGTH];
+	size_t len;
+	size_t size;
+};
+
+static int vanity_table_add_variants(VanityTable, char *, int, int, unsigned int, int);
+static int vanity_table_add_prefix(VanityTable, char *, unsigned int, int);
+static int vanity_table_add_payload_range(VanityTable, mpz_t, mpz_t, unsigned int, int);
+static int vanity_table_add_range(VanityTable, unsigned char *, unsigned char *, int);
+static int vanity_range_compare(const void *, const void *);
+static double vanity_range_size(struct VanityRange *);
+static void vanity_export(unsigned char *, mpz_t);
+static int vanity_payload_number(uint64_t *, int *, unsigned char *);
+static int vanity_digit(VanityDigits, int);
+
+void vanity_table_init(VanityTable table)
+{
+	assert(table);
+
+	table->ranges = NULL;
+	table->max = NULL;
+	table->len = 0;
+	table->size = 0;
+}
+
+int vanity_table_add_base58(VanityTable table, char *prefix, int insensitive, int id)
+{
+	int r;
+	size_t start;
+	char *variant;
+
+	assert(table);
+	assert(prefix);
+
+	// Every spelling adds its own ranges, so their number must be bounded
+	// before any of them are added.
+	if (vanity_base58_spellings(prefix, insensitive) > VANITY_SPELLINGS_MAX)
+	{
+		error_log("Case insensitive pattern has more than %i spellings.", VANITY_SPELLINGS_MAX);
+		return -1;
+	}
+
+	start = table->len;
+
+	variant = malloc(strlen(prefix) + 1);
+	if (variant == NULL)
+	{
+		error_log("Memory allocation error.");
+		return -1;
+	}
+	strcpy(variant, prefix);
+
+	// The version byte decides which first characters are possible. A prefix
+	// starting with any other character simply adds no ranges.
+	if (network_is_test())
+	{
+		r = vanity_table_add_variants(table, variant, 0, insensitive, VANITY_VERSION_TESTNET, id);
+	}
+	else
+	{
+		r = vanity_table_add_variants(table, variant, 0, insensitive, VANITY_VERSION_MAINNET, id);
+	}
+	if (r < 0)
+	{
+		error_log("Could not compile base58 pattern.");
+		free(variant);
+		return -1;
+	}
+
+	free(variant);
+
+	return (int)(table->len - start);
+}
+
+unsigned long vanity_base58_spellings(char *prefix, int insensitive)
+{
+	int n;
+	size_t i;
+	unsigned long count;
+
+	assert(prefix);
+
+	// Counting stops early, so a long pattern can't overflow the count.
+	count = 1;
+	for (i = 0; insensitive && prefix[i] != '\0' && count <= VANITY_SPELLINGS_MAX; ++i)
+	{
+		if (isalpha(prefix[i]))
+		{
+			n = base58_ischar(toupper(prefix[i])) + base58_ischar(tolower(prefix[i]));
+			if (n > 1)
+			{
+				count *= n;
+			}
+		}
+	}
+
+	return count;
+}
+
+int vanity_table_add_bech32(VanityTable table, char *pattern, int id)
+{
+	int r;
+	size_t i;
+	struct VanityMask mask;
+	unsigned char lo[VANITY_HASH_LENGTH];
+	unsigned char hi[VANITY_HASH_LENGTH];
+
+	assert(table);
+	assert(pattern);
+
+	r = vanity_mask_set_bech32(&mask, pattern, 0, VANITY_HASH_LENGTH);
+	if (r < 0)
+	{
+		error_log("Could not compile bech32 pattern.");
+		return -1;
+	}
+
+	// The hashes sharing those leading bits form a single range.
+	for (i = 0; i < VANITY_HASH_LENGTH; ++i)
+	{
+		lo[i] = mask.prefix[i];
+		hi[i] = mask.prefix[i] | ~mask.mask[i];
+	}
+
+	r = vanity_table_add_range(table, lo, hi, id);
+	if (r < 0)
+	{
+		error_log("Could not add pattern range.");
+		return -1;
+	}
+
+	return 1;
+}
+
+int vanity_table_build(VanityTable table)
+{
+	size_t i;
+
+	assert(table);
+
+	if (table->len == 0)
+	{
+		error_log("Pattern table is empty.");
+		return -1;
+	}
+
+	qsort(table->ranges, table->len, sizeof(*table->ranges), vanity_range_compare);
+
+	free(table->max);
+	table->max = malloc(sizeof(*table->max) * table->len);
+	if (table->max == NULL)
+	{
+		error_log("Memory allocation error.");
+		return -1;
+	}
+
+	memcpy(table->max[0], table->ranges[0].hi, VANITY_HASH_LENGTH);
+	for (i = 1; i < table->len; ++i)
+	{
+		if (memcmp(table->ranges[i].hi, table->max[i - 1], VANITY_HASH_LENGTH) > 0)
+		{
+			memcpy(table->max[i], table->ranges[i].hi, VANITY_HASH_LENGTH);
+		}
+		else
+		{
+			memcpy(table->max[i], table->max[i - 1], VANITY_HASH_LENGTH);
+		}
+	}
+
+	return 1;
+}
+
+int vanity_table_match(VanityTable table, unsigned char *hash, int *ids, int ids_len)
+{
+	int i, n;
+	size_t lo, hi, mid;
+
+	assert(table);
+	assert(table->max);
+	assert(hash);
+	assert(ids);
+
+	// Find the last range starting at or below the hash.
+	lo = 0;
+	hi = table->len;
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (memcmp(table->ranges[mid].lo, hash, VANITY_HASH_LENGTH) <= 0)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	// Walk back over every range that could still reach the hash.
+	n = 0;
+	while (lo > 0 && n < ids_len && memcmp(table->max[lo - 1], hash, VANITY_HASH_LENGTH) >= 0)
+	{
+		--lo;
+		if (memcmp(hash, table->ranges[lo].hi, VANITY_HASH_LENGTH) > 0)
+		{
+			continue;
+		}
+		for (i = 0; i < n && ids[i] != table->ranges[lo].id; ++i)
+			;
+		if (i == n)
+		{
+			ids[n++] = table->ranges[lo].id;
+		}
+	}
+
+	return n;
+}
+
+double vanity_table_probability(VanityTable table, int id)
+{
+	size_t i;
+	double p;
+
+	assert(table);
+
+	// The ranges of one pattern don't overlap, so their sizes add up.
+	p = 0;
+	for (i = 0; i < table->len; ++i)
+	{
+		if (table->ranges[i].id == id)
+		{
+			p += vanity_range_size(&table->ranges[i]);
+		}
+	}
+
+	return p;
+}
+
+void vanity_table_free(VanityTable table)
+{
+	assert(table);
+
+	free(table->ranges);
+	free(table->max);
+	table->ranges = NULL;
+	table->max = NULL;
+	table->len = 0;
+	table->size = 0;
+}
+
+size_t vanity_table_sizeof(void)
+{
+	return sizeof(struct VanityTable);
+}
+
+int vanity_mask_set_bech32(VanityMask mask, char *pattern, int offset, size_t data_len)
+{
+	int v, b;
+	size_t i, len, bits;
+
+	assert(mask);
+	assert(pattern);
+	assert(offset >= 0);
+	assert(data_len <= VANITY_MASK_LENGTH);
+
+	len = strlen(pattern);
+	if ((offset + len) * 5 > data_len * 8)
+	{
+		error_log("Bech32 pattern does not fit in the address data.");
+		return -1;
+	}
+
+	memset(mask->prefix, 0, VANITY_MASK_LENGTH);
+	memset(mask->mask, 0, VANITY_MASK_LENGTH);
+
+	// After the witness version, each character of a bech32 address is the
+	// next 5 bits of the witness program, a hash160 or an x-only key. The
+	// pattern starts offset characters in.
+	bits = offset * 5;
+	for (i = 0; i < len; ++i)
+	{
+		v = base32_get_raw(tolower(pattern[i]));
+		if (v < 0)
+		{
+			error_log("Invalid bech32 character in pattern.");
+			return -1;
+		}
+		for (b = 4; b >= 0; --b, ++bits)
+		{
+			mask->prefix[bits / 8] |= ((v >> b) & 1) << (7 - (bits % 8));
+			mask->mask[bits / 8] |= 1 << (7 - (bits % 8));
+		}
+	}
+	mask->len = (bits + 7) / 8;
+
+	return 1;
+}
+
+int vanity_mask_match(VanityMask mask, unsigned char *hash)
+{
+	size_t i;
+
+	assert(mask);
+	assert(hash);
+
+	for (i = 0; i < mask->len; ++i)
+	{
+		if ((hash[i] & mask->mask[i]) != mask->prefix[i])
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+double vanity_mask_probability(VanityMask mask)
+{
+	size_t i;
+	int b;
+	double p;
+
+	assert(mask);
+
+	p = 1;
+	for (i = 0; i < mask->len; ++i)
+	{
+		for (b = 0; b < 8; ++b)
+		{
+			if (mask->mask[i] & (1 << b))
+			{
+				p /= 2;
+			}
+		}
+	}
+
+	return p;
+}
+
+size_t vanity_mask_sizeof(void)
+{
+	return sizeof(struct VanityMask);
+}
+
+int vanity_digits_set(VanityDigits digits, unsigned char *hash)
+{
+	int i, j, r, zeros, len;
+	uint64_t n[VANITY_DIGIT_LIMBS], v;
+	uint128_t t;
+
+	assert(digits);
+	assert(hash);
+
+	r = vanity_payload_number(n, &zeros, hash);
+	if (r < 0)
+	{
+		error_log("Could not build address payload.");
+		return -1;
+	}
+
+	// Dividing by 58^10 four times gives every base58 digit, ten at a time,
+	// without going through a full encoding.
+	for (i = 0; i < VANITY_DIGIT_LIMBS; ++i)
+	{
+		t = 0;
+		for (j = VANITY_DIGIT_LIMBS - 1; j >= 0; --j)
+		{
+			t = (t << 64) | n[j];
+			n[j] = (uint64_t)(t / vanity_pow58[VANITY_LIMB_DIGITS]);
+			t %= vanity_pow58[VANITY_LIMB_DIGITS];
+		}
+		digits->limbs[i] = (uint64_t)t;
+	}
+
+	len = 0;
+	for (i = VANITY_DIGIT_LIMBS - 1; i >= 0; --i)
+	{
+		if (digits->limbs[i] != 0)
+		{
+			len = i * VANITY_LIMB_DIGITS;
+			for (v = digits->limbs[i]; v > 0; v /= VANITY_BASE58_BASE)
+			{
+				++len;
+			}
+			break;
+		}
+	}
+	digits->len = zeros + len;
+
+	return 1;
+}
+
+int vanity_digits_set_suffix(VanityDigits digits, unsigned char *hash)
+{
+	int j, r, zeros;
+	uint64_t n[VANITY_DIGIT_LIMBS];
+	uint128_t t;
+
+	assert(digits);
+	assert(hash);
+
+	r = vanity_payload_number(n, &zeros, hash);
+	if (r < 0)
+	{
+		error_log("Could not build address payload.");
+		return -1;
+	}
+
+	// The last ten digits are the payload mod 58^10, which takes a single
+	// pass. Addresses are always longer than that.
+	t = 0;
+	for (j = VANITY_DIGIT_LIMBS - 1; j >= 0; --j)
+	{
+		t = ((t << 64) | n[j]) % vanity_pow58[VANITY_LIMB_DIGITS];
+	}
+	digits->limbs[0] = (uint64_t)t;
+	digits->len = VANITY_LIMB_DIGITS;
+
+	return 1;
+}
+
+int vanity_place_set_base58(VanityPlace place, char *pattern, int position, int from_end, int insensitive)
+{
+	int j, v;
+	size_t len;
+
+	assert(place);
+	assert(pattern);
+	assert(position >= 0);
+
+	len = strlen(pattern);
+	if (len == 0 || position + len > VANITY_BASE58_LENGTH_MAX)
+	{
+		error_log("Base58 pattern does not fit in an address.");
+		return -1;
+	}
+
+	for (j = 0; pattern[j] != '\0'; ++j)
+	{
+		place->allowed[j] = 0;
+		v = base58_get_raw(pattern[j]);
+		if (v >= 0)
+		{
+			place->allowed[j] |= (uint64_t)1 << v;
+		}
+		if (insensitive)
+		{
+			v = base58_get_raw(toupper(pattern[j]));
+			if (v >= 0)
+			{
+				place->allowed[j] |= (uint64_t)1 << v;
+			}
+			v = base58_get_raw(tolower(pattern[j]));
+			if (v >= 0)
+			{
+				place->allowed[j] |= (uint64_t)1 << v;
+			}
+		}
+		if (place->allowed[j] == 0)
+		{
+			error_log("Invalid base58 character in pattern.");
+			return -1;
+		}
+	}
+
+	place->len = (int)len;
+	place->position = position;
+	place->from_end = from_end;
+
+	return 1;
+}
+
+int vanity_place_match(VanityPlace place, VanityDigits digits)
+{
+	int j, t;
+
+	assert(place);
+	assert(digits);
+
+	// t counts digits from the end of the address.
+	for (j = 0; j < place->len; ++j)
+	{
+		if (place->from_end)
+		{
+			t = place->position + place->len - 1 - j;
+		}
+		else
+		{
+			t = digits->len - 1 - (place->position + j);
+		}
+		if (t < 0 || t >= digits->len)
+		{
+			return 0;
+		}
+		if (((place->allowed[j] >> vanity_digit(digits, t)) & 1) == 0)
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+int vanity_place_is_suffix(VanityPlace place)
+{
+	assert(place);
+
+	return place->from_end && place->position + place->len <= VANITY_LIMB_DIGITS;
+}
+
+double vanity_place_probability(VanityPlace place)
+{
+	int j, b, c;
+	double p;
+
+	assert(place);
+
+	// Only an estimate, since the first digits of an address are not
+	// evenly distributed.
+	p = 1;
+	for (j = 0; j < place->len; ++j)
+	{
+		for (b = 0, c = 0; b < VANITY_BASE58_BASE; ++b)
+		{
+			c += (place->allowed[j] >> b) & 1;
+		}
+		p *= (double)c / VANITY_BASE58_BASE;
+	}
+
+	return p;
+}
+
+size_t vanity_place_sizeof(void)
+{
+	return sizeof(struct VanityPlace);
+}
+
+// Adds every upper/lower case spelling of prefix, from index i onward, when
+// insensitive is set. Letters that only exist in one case in base58 (like
+// 'i' and 'L') keep that case.
+static int vanity_table_add_variants(VanityTable table, char *prefix, int i, int insensitive, unsigned int version, int id)
+{
+	int r;
+	char c;
+
+	if (prefix[i] == '\0')
+	{
+		return vanity_table_add_prefix(table, prefix, version, id);
+	}
+
+	c = prefix[i];
+
+	if (insensitive && isalpha(c))
+	{
+		r = 0;
+		prefix[i] = toupper(c);
+		if (base58_ischar(prefix[i]))
+		{
+			r = vanity_table_add_variants(table, prefix, i + 1, insensitive, version, id);
+			if (r < 0)
+			{
+				return -1;
+			}
+		}
+		prefix[i] = tolower(c);
+		if (base58_ischar(prefix[i]))
+		{
+			r = vanity_table_add_variants(table, prefix, i + 1, insensitive, version, id);
+			if (r < 0)
+			{
+				return -1;
+			}
+		}
+		prefix[i] = c;
+		return r;
+	}
+
+	if (!base58_ischar(c))
+	{
+		error_log("Invalid base58 character: 0x%02x.", c);
+		return -1;
+	}
+
+	return vanity_table_add_variants(table, prefix, i + 1, insensitive, version, id);
+}
+
+// An address is k '1' characters for the k leading zero bytes of its 25
+// byte payload (version, hash160, checksum), followed by the base58 digits
+// of the payload value. So a prefix fixes the number of leading zero bytes,
+// and for each possible digit count the remaining prefix characters select
+// one interval of payload values.
+static int vanity_table_add_prefix(VanityTable table, char *prefix, unsigned int version, int id)
+{
+	int r;
+	size_t i, k, len, digits;
+	mpz_t value, lo, hi, min, max, scale;
+
+	len = strlen(prefix);
+	for (k = 0; k < len && prefix[k] == '1'; ++k)
+		;
+
+	mpz_init(value);
+	mpz_init(lo);
+	mpz_init(hi);
+	mpz_init(min);
+	mpz_init(max);
+	mpz_init(scale);
+
+	// Payloads with exactly k leading zero bytes, or at least k if the
+	// prefix is nothing but '1' characters.
+	mpz_ui_pow_ui(max, 256, VANITY_PAYLOAD_LENGTH - k);
+	if (k < len)
+	{
+		mpz_ui_pow_ui(min, 256, VANITY_PAYLOAD_LENGTH - k - 1);
+	}
+
+	// The version byte fixes the top of the payload.
+	mpz_ui_pow_ui(scale, 256, VANITY_PAYLOAD_LENGTH - 1);
+	mpz_mul_ui(lo, scale, version);
+	mpz_mul_ui(hi, scale, version + 1);
+	if (mpz_cmp(min, lo) < 0)
+	{
+		mpz_set(min, lo);
+	}
+	if (mpz_cmp(max, hi) > 0)
+	{
+		mpz_set(max, hi);
+	}
+
+	if (k == len)
+	{
+		r = 1;
+		if (mpz_cmp(min, max) < 0)
+		{
+			r = vanity_table_add_payload_range(table, min, max, version, id);
+		}
+	}
+	else
+	{
+		for (i = k; i < len; ++i)
+		{
+			mpz_mul_ui(value, value, 58);
+			mpz_add_ui(value, value, base58_get_raw(prefix[i]));
+		}
+
+		r = 1;
+		for (digits = len - k; digits <= VANITY_BASE58_LENGTH_MAX && r > 0; ++digits)
+		{
+			// [value * 58^n, (value + 1) * 58^n) for n trailing digits
+			mpz_ui_pow_ui(scale, 58, digits - (len - k));
+			mpz_mul(lo, value, scale);
+			mpz_add_ui(hi, value, 1);
+			mpz_mul(hi, hi, scale);
+
+			if (mpz_cmp(lo, max) >= 0)
+			{
+				break;
+			}
+			if (mpz_cmp(lo, min) < 0)
+			{
+				mpz_set(lo, min);
+			}
+			if (mpz_cmp(hi, max) > 0)
+			{
+				mpz_set(hi, max);
+			}
+			if (mpz_cmp(lo, hi) < 0)
+			{
+				r = vanity_table_add_payload_range(table, lo, hi, version, id);
+			}
+		}
+	}
+
+	mpz_clear(value);
+	mpz_clear(lo);
+	mpz_clear(hi);
+	mpz_clear(min);
+	mpz_clear(max);
+	mpz_clear(scale);
+
+	if (r < 0)
+	{
+		error_log("Could not add pattern range.");
+		return -1;
+	}
+
+	return 1;
+}
+
+// Adds the hash160 values of the payloads in [lo, hi). The checksum can be
+// anything, so the range is rounded outward and the few hashes at its edges
+// may not actually produce the prefix.
+static int vanity_table_add_payload_range(VanityTable table, mpz_t lo, mpz_t hi, unsigned int version, int id)
+{
+	int r;
+	mpz_t offset, a, b;
+	unsigned char lo_hash[VANITY_HASH_LENGTH];
+	unsigned char hi_hash[VANITY_HASH_LENGTH];
+
+	mpz_init(offset);
+	mpz_init(a);
+	mpz_init(b);
+
+	mpz_ui_pow_ui(offset, 256, VANITY_PAYLOAD_LENGTH - 1);
+	mpz_mul_ui(offset, offset, version);
+
+	mpz_sub(a, lo, offset);
+	mpz_tdiv_q_2exp(a, a, VANITY_CHECKSUM_BITS);
+
+	mpz_sub(b, hi, offset);
+	mpz_sub_ui(b, b, 1);
+	mpz_tdiv_q_2exp(b, b, VANITY_CHECKSUM_BITS);
+
+	vanity_export(lo_hash, a);
+	vanity_export(hi_hash, b);
+
+	r = vanity_table_add_range(table, lo_hash, hi_hash, id);
+
+	mpz_clear(offset);
+	mpz_clear(a);
+	mpz_clear(b);
+
+	return r;
+}
+
+// Appends the inclusive hash160 range [lo, hi].
+static int vanity_table_add_range(VanityTable table, unsigned char *lo, unsigned char *hi, int id)
+{
+	struct VanityRange *ranges;
+
+	if (table->len == table->size)
+	{
+		table->size = (table->size == 0) ? 16 : table->size * 2;
+		ranges = realloc(table->ranges, sizeof(*ranges) * table->size);
+		if (ranges == NULL)
+		{
+			error_log("Memory allocation error.");
+			return -1;
+		}
+		table->ranges = ranges;
+	}
+
+	memcpy(table->ranges[table->len].lo, lo, VANITY_HASH_LENGTH);
+	memcpy(table->ranges[table->len].hi, hi, VANITY_HASH_LENGTH);
+	table->ranges[table->len].id = id;
+	table->len++;
+
+	return 1;
+}
+
+static int vanity_range_compare(const void *a, const void *b)
+{
+	return memcmp(((const struct VanityRange *)a)->lo, ((const struct VanityRange *)b)->lo, VANITY_HASH_LENGTH);
+}
+
+// The fraction of all hash160 values that fall in a range.
+static double vanity_range_size(struct VanityRange *range)
+{
+	int i, d, borrow;
+	double size;
+
+	borrow = 0;
+	size = 0;
+	for (i = VANITY_HASH_LENGTH - 1; i >= 0; --i)
+	{
+		d = range->hi[i] - range->lo[i] - borrow;
+		borrow = (d < 0);
+		size = (size + (d + (borrow * 256))) / 256;
+	}
+
+	// hi is inclusive
+	return size + (1 / VANITY_HASH_SPACE);
+}
+
+// The 25 byte address payload of hash, checksum included, as a little
+// endian number of 64 bit limbs, and how many zero bytes it starts with.
+static int vanity_payload_number(uint64_t *n, int *zeros, unsigned char *hash)
+{
+	int i, j, r;
+	unsigned char payload[VANITY_PAYLOAD_LENGTH];
+	unsigned char sha[32];
+
+	payload[0] = network_is_test() ? VANITY_VERSION_TESTNET : VANITY_VERSION_MAINNET;
+	memcpy(payload + 1, hash, VANITY_HASH_LENGTH);
+	r = crypto_get_hash256(sha, payload, VANITY_HASH_LENGTH + 1);
+	if (r < 0)
+	{
+		error_log("Could not generate SHA256 hash for payload.");
+		return -1;
+	}
+	memcpy(payload + VANITY_HASH_LENGTH + 1, sha, VANITY_PAYLOAD_LENGTH - VANITY_HASH_LENGTH - 1);
+
+	// Each leading zero byte is encoded as a '1'.
+	for (*zeros = 0; *zeros < VANITY_PAYLOAD_LENGTH && payload[*zeros] == 0; ++*zeros)
+		;
+
+	memset(n, 0, sizeof(*n) * VANITY_DIGIT_LIMBS);
+	for (i = 0; i < VANITY_PAYLOAD_LENGTH; ++i)
+	{
+		j = VANITY_PAYLOAD_LENGTH - 1 - i;
+		n[j / 8] |= (uint64_t)payload[i] << ((j % 8) * 8);
+	}
+
+	return 1;
+}
+
+// Digit t of an address, counted from its end.
+static int vanity_digit(VanityDigits digits, int t)
+{
+	return (int)((digits->limbs[t / VANITY_LIMB_DIGITS] / vanity_pow58[t % VANITY_LIMB_DIGITS]) % VANITY_BASE58_BASE);
+}
+
+// Exports a value below 2^160 as a fixed width big endian hash.
+static void vanity_export(unsigned char *output, mpz_t value)
+{
+	size_t c;
+
+	memset(output, 0, VANITY_HASH_LENGTH);
+	if (mpz_sgn(value) != 0)
+	{
+		c = (mpz_sizeinbase(value, 2) + 7) / 8;
+		mpz_export(output + VANITY_HASH_LENGTH - c, &c, 1, 1, 1, 0, value);
+	}
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2017 Brian Barto
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GPL License. See LICENSE for more details.
+ */
+
+#ifndef VANITY_H
+#define VANITY_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define VANITY_HASH_LENGTH    20
+#define VANITY_MASK_LENGTH    32
+#define VANITY_DIGIT_LIMBS    4
+#define VANITY_SPELLINGS_MAX  4096
+
+typedef struct VanityTable *VanityTable;
+typedef struct VanityMask *VanityMask;
+typedef struct VanityPlace *VanityPlace;
+
+// The base58 digits of an address, as little endian limbs of ten digits
+// each, and the length of the address. vanity_digits_set_suffix() only
+// sets the lowest limb, and len to the ten digits it holds.
+typedef struct VanityDigits *VanityDigits;
+struct VanityDigits
+{
+	uint64_t limbs[VANITY_DIGIT_LIMBS];
+	int len;
+};
+
+void vanity_table_init(VanityTable);
+int vanity_table_add_base58(VanityTable, char *, int, int);
+unsigned long vanity_base58_spellings(char *, int);
+int vanity_table_add_bech32(VanityTable, char *, int);
+int vanity_table_build(VanityTable);
+int vanity_table_match(VanityTable, unsigned char *, int *, int);
+double vanity_table_probability(VanityTable, int);
+void vanity_table_free(VanityTable);
+size_t vanity_table_sizeof(void);
+int vanity_mask_set_bech32(VanityMask, char *, int, size_t);
+int vanity_mask_match(VanityMask, unsigned char *);
+double vanity_mask_probability(VanityMask);
+size_t vanity_mask_sizeof(void);
+int vanity_digits_set(VanityDigits, unsigned char *);
+int vanity_digits_set_suffix(VanityDigits, unsigned char *);
+int vanity_place_set_base58(VanityPlace, char *, int, int, int);
+int vanity_place_match(VanityPlace, VanityDigits);
+int vanity_place_is_suffix(VanityPlace);
+double vanity_place_probability(VanityPlace);
+size_t vanity_place_sizeof(void);
+
+#endif
@@ -0,0 +1,879 @@
+/*
+ * Copyright (c) 2017 Brian Barto
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GPL License. See LICENSE for more details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <poll.h>
+#include <errno.h>
+#include <assert.h>
+#include "vanitycoord.h"
+#include "vanitynet.h"
+#include "crypto.h"
+#include "random.h"
+#include "hex.h"
+#include "error.h"
+
+#define VANITYCOORD_NONCE_LENGTH    32
+#define VANITYCOORD_CLIENTS_MAX     256
+#define VANITYCOORD_PENDING_MAX     16
+#define VANITYCOORD_UNITS_MAX       32
+#define VANITYCOORD_HELD_MAX        (VANITYCOORD_UNITS_MAX + 2)
+#define VANITYCOORD_WAIT            10000
+#define VANITYCOORD_TAG_PROOF       "btk vanity proof "
+#define VANITYCOORD_TAG_SEED        "btk vanity seed"
+
+// The coordinator and its workers share a secret, which never goes over
+// the wire. A new worker gets a random nonce and proves that it knows the
+// secret by hashing the two together. The seed is sent masked with another
+// hash of them, and hits are sent as offsets from the seed. Someone
+// watching the connection learns neither the seed nor any key found.
+
+// A worker connected to the coordinator. It is ready once it has proven
+// that it knows the secret and searches for the same thing, which it must
+// do within VANITYCOORD_WAIT milliseconds of being accepted. held lists
+// the first chunk of every unit it was handed and has not finished yet.
+// total and rate are from its last progress report.
+struct VanityClient
+{
+	VanityConn conn;
+	int ready;
+	struct timespec accepted;
+	unsigned char nonce[VANITYCOORD_NONCE_LENGTH];
+	unsigned long held[VANITYCOORD_HELD_MAX];
+	int held_len;
+	unsigned long total;
+	double rate;
+};
+
+// Units of a worker that went away are handed out again before any new
+// ones. retired keeps the progress of those workers in the total.
+struct VanityCoord
+{
+	int listenfd;
+	unsigned char seed[VANITYCOORD_SEED_LENGTH];
+	char secret[VANITYCOORD_SECRET_MAX + 1];
+	char fingerprint[VANITYNET_LINE_MAX];
+	VanityCoordAccept accept;
+	struct VanityClient clients[VANITYCOORD_CLIENTS_MAX];
+	int clients_len;
+	unsigned long unit_next;
+	unsigned long *requeued;
+	size_t requeued_len;
+	unsigned long retired;
+};
+
+// A unit a worker is searching, and how many of its chunks are left.
+struct VanityLinkUnit
+{
+	unsigned long first;
+	unsigned long len;
+	unsigned long left;
+};
+
+// A worker's connection to its coordinator. The search threads take chunks
+// from the current unit while the main thread keeps the next one in
+// reserve, so the search never waits for the network. Units are reported
+// done once all of their chunks have been searched.
+struct VanityLink
+{
+	VanityConn conn;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	unsigned long next;
+	unsigned long end;
+	unsigned long pending;
+	unsigned long pending_len;
+	int requested;
+	int stopped;
+	struct VanityLinkUnit units[VANITYCOORD_UNITS_MAX];
+	int units_len;
+	unsigned long done[VANITYCOORD_UNITS_MAX];
+	int done_len;
+};
+
+static int vanitycoord_add_client(VanityCoord);
+static int vanitycoord_drop_client(VanityCoord, int);
+static int vanitycoord_serve(VanityCoord, struct VanityClient *, char *);
+static int vanitycoord_greet(VanityLink, char *, char *, unsigned char *);
+static int vanitycoord_expect(VanityConn, char *);
+static int vanitycoord_digest(unsigned char *, char *, unsigned char *, char *);
+static long vanitycoord_elapsed(struct timespec *);
+
+int vanitycoord_init(VanityCoord coord, int port, int any, unsigned char *seed, char *secret, char *fingerprint, VanityCoordAccept accept)
+{
+	assert(coord);
+	assert(port);
+	assert(seed);
+	assert(secret);
+	assert(strlen(secret) <= VANITYCOORD_SECRET_MAX);
+	assert(fingerprint);
+	assert(strlen(fingerprint) < VANITYNET_LINE_MAX);
+	assert(accept);
+
+	coord->listenfd = vanitynet_listen(port, any);
+	if (coord->listenfd < 0)
+	{
+		error_log("Could not listen for workers.");
+		return -1;
+	}
+
+	memcpy(coord->seed, seed, VANITYCOORD_SEED_LENGTH);
+	strcpy(coord->secret, secret);
+	strcpy(coord->fingerprint, fingerprint);
+	coord->accept = accept;
+	coord->clients_len = 0;
+	coord->unit_next = 0;
+	coord->requeued = NULL;
+	coord->requeued_len = 0;
+	coord->retired = 0;
+
+	return 1;
+}
+
+// Waits up to timeout milliseconds for workers to connect or send
+// something, and answers whatever came in. Workers that go away, misbehave
+// or don't say hello in time are dropped.
+int vanitycoord_poll(VanityCoord coord, int timeout)
+{
+	int i, r, s;
+	struct pollfd pfds[VANITYCOORD_CLIENTS_MAX + 1];
+	char line[VANITYNET_LINE_MAX];
+
+	assert(coord);
+
+	pfds[0].fd = coord->listenfd;
+	pfds[0].events = POLLIN;
+	for (i = 0; i < coord->clients_len; ++i)
+	{
+		pfds[i + 1].fd = vanitynet_fd(coord->clients[i].conn);
+		pfds[i + 1].events = POLLIN;
+	}
+	r = poll(pfds, coord->clients_len + 1, timeout);
+	if (r < 0 && errno != EINTR)
+	{
+		error_log("Could not poll worker connections. Errno %i.", errno);
+		return -1;
+	}
+
+	if (r > 0 && (pfds[0].revents & POLLIN))
+	{
+		r = vanitycoord_add_client(coord);
+		if (r < 0)
+		{
+			error_log("Could not add worker.");
+			return -1;
+		}
+	}
+
+	for (i = 0; i < coord->clients_len; ++i)
+	{
+		s = 1;
+		while (s > 0 && (r = vanitynet_recv(coord->clients[i].conn, line)) > 0)
+		{
+			s = vanitycoord_serve(coord, &coord->clients[i], line);
+		}
+		if (s < 0)
+		{
+			error_log("Could not answer worker.");
+			return -1;
+		}
+
+		if (s > 0 && r == 0 && !coord->clients[i].ready && vanitycoord_elapsed(&coord->clients[i].accepted) > VANITYCOORD_WAIT)
+		{
+			vanitynet_send(coord->clients[i].conn, "error Expected hello sooner.");
+			s = 0;
+		}
+
+		if (s == 0 || r < 0)
+		{
+			r = vanitycoord_drop_client(coord, i--);
+			if (r < 0)
+			{
+				error_log("Could not drop worker.");
+				return -1;
+			}
+		}
+	}
+
+	return 1;
+}
+
+// Sums up the progress of every worker, past ones included.
+void vanitycoord_progress(VanityCoord coord, unsigned long *total, double *rate, int *workers)
+{
+	int i;
+
+	assert(coord);
+	assert(total);
+	assert(rate);
+	assert(workers);
+
+	*total = coord->retired;
+	*rate = 0;
+	*workers = 0;
+	for (i = 0; i < coord->clients_len; ++i)
+	{
+		if (coord->clients[i].ready)
+		{
+			*total += coord->clients[i].total;
+			*rate += coord->clients[i].rate;
+			++*workers;
+		}
+	}
+}
+
+// Stops every worker and closes all connections.
+void vanitycoord_free(VanityCoord coord)
+{
+	int i;
+
+	assert(coord);
+
+	for (i = 0; i < coord->clients_len; ++i)
+	{
+		vanitynet_send(coord->clients[i].conn, "stop");
+		vanitynet_close(coord->clients[i].conn);
+		free(coord->clients[i].conn);
+	}
+	coord->clients_len = 0;
+
+	vanitynet_unlisten(coord->listenfd);
+	coord->listenfd = -1;
+
+	free(coord->requeued);
+	coord->requeued = NULL;
+	coord->requeued_len = 0;
+
+	memset(coord->seed, 0, VANITYCOORD_SEED_LENGTH);
+	memset(coord->secret, 0, sizeof(coord->secret));
+}
+
+size_t vanitycoord_sizeof(void)
+{
+	return sizeof(struct VanityCoord);
+}
+
+// Connects to the coordinator at host:port, proves that this worker knows
+// the secret and introduces its search by fingerprint. The coordinator
+// answers with the seed that all of its workers share.
+int vanitycoord_join(VanityLink link, char *host, int port, char *secret, char *fingerprint, unsigned char *seed)
+{
+	int r;
+
+	assert(link);
+	assert(host);
+	assert(port);
+	assert(secret);
+	assert(strlen(secret) <= VANITYCOORD_SECRET_MAX);
+	assert(fingerprint);
+	assert(strlen(fingerprint) < VANITYNET_LINE_MAX);
+	assert(seed);
+
+	link->conn = malloc(vanitynet_sizeof());
+	if (link->conn == NULL)
+	{
+		error_log("Memory allocation error.");
+		return -1;
+	}
+	pthread_mutex_init(&link->lock, NULL);
+	pthread_cond_init(&link->cond, NULL);
+	link->next = 0;
+	link->end = 0;
+	link->pending = 0;
+	link->pending_len = 0;
+	link->requested = 0;
+	link->stopped = 0;
+	link->units_len = 0;
+	link->done_len = 0;
+
+	r = vanitynet_connect(link->conn, host, port);
+	if (r < 0)
+	{
+		error_log("Could not connect to coordinator.");
+		free(link->conn);
+		link->conn = NULL;
+		pthread_mutex_destroy(&link->lock);
+		pthread_cond_destroy(&link->cond);
+		return -1;
+	}
+
+	r = vanitycoord_greet(link, secret, fingerprint, seed);
+	if (r < 0)
+	{
+		error_log("Could not greet coordinator.");
+		vanitycoord_leave(link);
+		return -1;
+	}
+
+	return 1;
+}
+
+// Claims the next chunk to search, waiting for the coordinator if there is
+// none. Returns 0 once the search is over.
+int vanitycoord_next_chunk(VanityLink link, unsigned long *chunk)
+{
+	assert(link);
+	assert(chunk);
+
+	pthread_mutex_lock(&link->lock);
+	while (!link->stopped && link->next == link->end)
+	{
+		// Only so many units are tracked at once.
+		if (link->pending_len > 0 && link->units_len + link->done_len < VANITYCOORD_UNITS_MAX)
+		{
+			link->units[link->units_len].first = link->pending;
+			link->units[link->units_len].len = link->pending_len;
+			link->units[link->units_len].left = link->pending_len;
+			link->units_len++;
+			link->next = link->pending;
+			link->end = link->pending + link->pending_len;
+			link->pending_len = 0;
+			continue;
+		}
+		pthread_cond_wait(&link->cond, &link->lock);
+	}
+	if (link->stopped)
+	{
+		pthread_mutex_unlock(&link->lock);
+		return 0;
+	}
+	*chunk = link->next++;
+	pthread_mutex_unlock(&link->lock);
+
+	return 1;
+}
+
+// Marks a chunk as fully searched. Once all chunks of its unit are, the
+// unit is reported done with the next update.
+void vanitycoord_chunk_done(VanityLink link, unsigned long chunk)
+{
+	int i;
+
+	assert(link);
+
+	pthread_mutex_lock(&link->lock);
+	for (i = 0; i < link->units_len; ++i)
+	{
+		if (chunk < link->units[i].first || chunk >= link->units[i].first + link->units[i].len)
+		{
+			continue;
+		}
+		if (--link->units[i].left == 0)
+		{
+			link->done[link->done_len++] = link->units[i].first;
+			link->units[i] = link->units[--link->units_len];
+			pthread_cond_broadcast(&link->cond);
+		}
+		break;
+	}
+	pthread_mutex_unlock(&link->lock);
+}
+
+// Handles what the coordinator sent since the last call, reports finished
+// units, asks for a new unit once the reserve has been taken, and with
+// report set, sends the progress of this worker. Returns 0 once the
+// coordinator has stopped the search.
+int vanitycoord_update(VanityLink link, unsigned long total, double rate, int report)
+{
+	int i, r, request, done_len;
+	unsigned long first, len;
+	unsigned long done[VANITYCOORD_UNITS_MAX];
+	char line[VANITYNET_LINE_MAX];
+
+	assert(link);
+
+	while ((r = vanitynet_recv(link->conn, line)) > 0)
+	{
+		if (sscanf(line, "unit %lu %lu", &first, &len) == 2 && len > 0)
+		{
+			pthread_mutex_lock(&link->lock);
+			link->pending = first;
+			link->pending_len = len;
+			link->requested = 0;
+			pthread_cond_broadcast(&link->cond);
+			pthread_mutex_unlock(&link->lock);
+		}
+		else if (strcmp(line, "stop") == 0)
+		{
+			// The coordinator hangs up right after this.
+			vanitycoord_release(link);
+			return 0;
+		}
+		else if (strncmp(line, "error ", 6) == 0)
+		{
+			error_log("Coordinator error: %s", line + 6);
+			return -1;
+		}
+	}
+	if (r < 0)
+	{
+		error_log("Could not read from coordinator.");
+		return -1;
+	}
+
+	pthread_mutex_lock(&link->lock);
+	done_len = link->done_len;
+	memcpy(done, link->done, sizeof(*done) * done_len);
+	link->done_len = 0;
+	request = (link->pending_len == 0 && !link->requested);
+	if (request)
+	{
+		link->requested = 1;
+	}
+	pthread_cond_broadcast(&link->cond);
+	pthread_mutex_unlock(&link->lock);
+
+	for (i = 0; i < done_len; ++i)
+	{
+		r = vanitynet_send(link->conn, "done %lu", done[i]);
+		if (r < 0)
+		{
+			error_log("Could not report finished unit.");
+			return -1;
+		}
+	}
+
+	if (request)
+	{
+		r = vanitynet_send(link->conn, "unit");
+		if (r < 0)
+		{
+			error_log("Could not request unit.");
+			return -1;
+		}
+	}
+
+	if (report)
+	{
+		r = vanitynet_send(link->conn, "stats %lu %.1f", total, rate);
+		if (r < 0)
+		{
+			error_log("Could not send progress.");
+			return -1;
+		}
+	}
+
+	return 1;
+}
+
+// Reports a hit by where it is in the keyspace. The coordinator recovers
+// the key from its own seed and checks it before believing it.
+int vanitycoord_send_hit(VanityLink link, int id, unsigned long offset, int variant)
+{
+	int r;
+
+	assert(link);
+
+	r = vanitynet_send(link->conn, "hit %d %lu %d", id, offset, variant);
+	if (r < 0)
+	{
+		error_log("Could not send hit.");
+		return -1;
+	}
+
+	return 1;
+}
+
+// Wakes up every thread waiting for a chunk. None are handed out after
+// this.
+void vanitycoord_release(VanityLink link)
+{
+	assert(link);
+
+	pthread_mutex_lock(&link->lock);
+	link->stopped = 1;
+	pthread_cond_broadcast(&link->cond);
+	pthread_mutex_unlock(&link->lock);
+}
+
+void vanitycoord_leave(VanityLink link)
+{
+	assert(link);
+
+	vanitynet_close(link->conn);
+	free(link->conn);
+	link->conn = NULL;
+	pthread_mutex_destroy(&link->lock);
+	pthread_cond_destroy(&link->cond);
+}
+
+size_t vanitycoord_link_sizeof(void)
+{
+	return sizeof(struct VanityLink);
+}
+
+// Accepts a new connection and challenges it. Returns -1 only if the
+// coordinator itself is in trouble.
+static int vanitycoord_add_client(VanityCoord coord)
+{
+	int i, r, pending;
+	char nonce_str[VANITYCOORD_NONCE_LENGTH * 2 + 1];
+	struct VanityClient *client;
+
+	client = &coord->clients[coord->clients_len];
+	client->conn = malloc(vanitynet_sizeof());
+	if (client->conn == NULL)
+	{
+		error_log("Memory allocation error.");
+		return -1;
+	}
+
+	r = vanitynet_accept(client->conn, coord->listenfd);
+	if (r < 0)
+	{
+		error_clear();
+		free(client->conn);
+		return 1;
+	}
+
+	if (coord->clients_len == VANITYCOORD_CLIENTS_MAX - 1)
+	{
+		vanitynet_send(client->conn, "error Too many workers.");
+		error_clear();
+		vanitynet_close(client->conn);
+		free(client->conn);
+		return 1;
+	}
+
+	// Connections that never say hello must not crowd out real workers.
+	for (pending = 0, i = 0; i < coord->clients_len; ++i)
+	{
+		if (!coord->clients[i].ready)
+		{
+			++pending;
+		}
+	}
+	if (pending == VANITYCOORD_PENDING_MAX)
+	{
+		vanitynet_send(client->conn, "error Too many workers joining.");
+		error_clear();
+		vanitynet_close(client->conn);
+		free(client->conn);
+		return 1;
+	}
+
+	r = random_get(client->nonce, VANITYCOORD_NONCE_LENGTH);
+	if (r < 0)
+	{
+		error_log("Could not generate nonce.");
+		vanitynet_close(client->conn);
+		free(client->conn);
+		return -1;
+	}
+	hex_encode(nonce_str, client->nonce, VANITYCOORD_NONCE_LENGTH);
+
+	r = vanitynet_send(client->conn, "challenge %s", nonce_str);
+	if (r < 0)
+	{
+		error_clear();
+		vanitynet_close(client->conn);
+		free(client->conn);
+		return 1;
+	}
+
+	client->ready = 0;
+	clock_gettime(CLOCK_MONOTONIC, &client->accepted);
+	client->held_len = 0;
+	client->total = 0;
+	client->rate = 0;
+	coord->clients_len++;
+
+	return 1;
+}
+
+// Drops a worker. Units it had not finished go back to the queue, and its
+// progress is kept in the total.
+static int vanitycoord_drop_client(VanityCoord coord, int i)
+{
+	unsigned long *requeued;
+	struct VanityClient *client;
+
+	client = &coord->clients[i];
+
+	if (client->held_len > 0)
+	{
+		requeued = realloc(coord->requeued, sizeof(*requeued) * (coord->requeued_len + client->held_len));
+		if (requeued == NULL)
+		{
+			error_log("Memory allocation error.");
+			return -1;
+		}
+		memcpy(requeued + coord->requeued_len, client->held, sizeof(*requeued) * client->held_len);
+		coord->requeued = requeued;
+		coord->requeued_len += client->held_len;
+	}
+	coord->retired += client->total;
+
+	vanitynet_close(client->conn);
+	free(client->conn);
+	coord->clients[i] = coord->clients[--coord->clients_len];
+
+	// Whatever went wrong with the worker is no concern of ours.
+	error_clear();
+
+	return 1;
+}
+
+// Answers a single message from a worker. Returns 0 if the worker should be
+// dropped, and -1 if the coordinator can't go on.
+static int vanitycoord_serve(VanityCoord coord, struct VanityClient *client, char *line)
+{
+	int i, r, id, variant;
+	unsigned long unit, offset;
+	unsigned char hash[32];
+	unsigned char seed[VANITYCOORD_SEED_LENGTH];
+	char fingerprint[VANITYNET_LINE_MAX];
+	char proof[VANITYNET_LINE_MAX];
+	char tag[VANITYNET_LINE_MAX + sizeof(VANITYCOORD_TAG_PROOF)];
+	char seed_str[VANITYCOORD_SEED_LENGTH * 2 + 1];
+
+	// Nothing but the hello is taken from a worker that hasn't proven that
+	// it knows the secret.
+	if (!client->ready)
+	{
+		if (sscanf(line, "hello %255s %255s", fingerprint, proof) != 2)
+		{
+			vanitynet_send(client->conn, "error Expected hello.");
+			return 0;
+		}
+
+		snprintf(tag, sizeof(tag), "%s%s", VANITYCOORD_TAG_PROOF, fingerprint);
+		r = vanitycoord_digest(hash, tag, client->nonce, coord->secret);
+		if (r < 0)
+		{
+			error_log("Could not check challenge.");
+			return -1;
+		}
+		if (strlen(proof) != 64 || hex_decode(seed, proof, 64) < 0 || memcmp(seed, hash, 32) != 0)
+		{
+			vanitynet_send(client->conn, "error Wrong secret.");
+			return 0;
+		}
+
+		if (strcmp(fingerprint, coord->fingerprint) != 0)
+		{
+			vanitynet_send(client->conn, "error The coordinator is searching for something else.");
+			return 0;
+		}
+
+		r = vanitycoord_digest(hash, VANITYCOORD_TAG_SEED, client->nonce, coord->secret);
+		if (r < 0)
+		{
+			error_log("Could not mask seed.");
+			return -1;
+		}
+		for (i = 0; i < VANITYCOORD_SEED_LENGTH; ++i)
+		{
+			seed[i] = coord->seed[i] ^ hash[i];
+		}
+		hex_encode(seed_str, seed, VANITYCOORD_SEED_LENGTH);
+
+		client->ready = 1;
+
+		return (vanitynet_send(client->conn, "seed %s", seed_str) < 0) ? 0 : 1;
+	}
+
+	if (strcmp(line, "unit") == 0)
+	{
+		// An honest worker never holds more units than it can track.
+		if (client->held_len == VANITYCOORD_HELD_MAX)
+		{
+			vanitynet_send(client->conn, "error Too many units.");
+			return 0;
+		}
+
+		if (coord->requeued_len > 0)
+		{
+			unit = coord->requeued[--coord->requeued_len];
+		}
+		else
+		{
+			unit = coord->unit_next;
+			coord->unit_next += VANITYCOORD_UNIT_CHUNKS;
+		}
+		client->held[client->held_len++] = unit;
+
+		return (vanitynet_send(client->conn, "unit %lu %d", unit, VANITYCOORD_UNIT_CHUNKS) < 0) ? 0 : 1;
+	}
+
+	if (sscanf(line, "done %lu", &unit) == 1)
+	{
+		for (i = 0; i < client->held_len; ++i)
+		{
+			if (client->held[i] == unit)
+			{
+				client->held[i] = client->held[--client->held_len];
+				break;
+			}
+		}
+		return 1;
+	}
+
+	if (sscanf(line, "stats %lu %lf", &client->total, &client->rate) == 2)
+	{
+		return 1;
+	}
+
+	if (sscanf(line, "hit %d %lu %d", &id, &offset, &variant) == 3)
+	{
+		r = coord->accept(id, offset, variant);
+		if (r < 0)
+		{
+			error_log("Could not check hit.");
+			return -1;
+		}
+		if (r == 0)
+		{
+			vanitynet_send(client->conn, "error Hit does not match.");
+			return 0;
+		}
+		return 1;
+	}
+
+	return 1;
+}
+
+// Answers the coordinator's challenge, reads the seed and asks for the
+// first unit.
+static int vanitycoord_greet(VanityLink link, char *secret, char *fingerprint, unsigned char *seed)
+{
+	int i, r;
+	unsigned char nonce[VANITYCOORD_NONCE_LENGTH];
+	unsigned char hash[32];
+	char proof[65];
+	char tag[VANITYNET_LINE_MAX + sizeof(VANITYCOORD_TAG_PROOF)];
+	char line[VANITYNET_LINE_MAX];
+	char value[VANITYNET_LINE_MAX];
+
+	r = vanitycoord_expect(link->conn, line);
+	if (r < 0)
+	{
+		error_log("No challenge from coordinator.");
+		return -1;
+	}
+	if (sscanf(line, "challenge %255s", value) != 1 || strlen(value) != VANITYCOORD_NONCE_LENGTH * 2 || hex_decode(nonce, value, VANITYCOORD_NONCE_LENGTH * 2) < 0)
+	{
+		error_log("Unexpected challenge from coordinator.");
+		return -1;
+	}
+
+	snprintf(tag, sizeof(tag), "%s%s", VANITYCOORD_TAG_PROOF, fingerprint);
+	r = vanitycoord_digest(hash, tag, nonce, secret);
+	if (r < 0)
+	{
+		error_log("Could not answer challenge.");
+		return -1;
+	}
+	hex_encode(proof, hash, 32);
+
+	r = vanitynet_send(link->conn, "hello %s %s", fingerprint, proof);
+	if (r < 0)
+	{
+		error_log("Could not send to coordinator.");
+		return -1;
+	}
+
+	r = vanitycoord_expect(link->conn, line);
+	if (r < 0)
+	{
+		error_log("No answer from coordinator.");
+		return -1;
+	}
+	if (sscanf(line, "seed %255s", value) != 1 || strlen(value) != VANITYCOORD_SEED_LENGTH * 2 || hex_decode(seed, value, VANITYCOORD_SEED_LENGTH * 2) < 0)
+	{
+		error_log("Unexpected answer from coordinator.");
+		return -1;
+	}
+
+	r = vanitycoord_digest(hash, VANITYCOORD_TAG_SEED, nonce, secret);
+	if (r < 0)
+	{
+		error_log("Could not unmask seed.");
+		return -1;
+	}
+	for (i = 0; i < VANITYCOORD_SEED_LENGTH; ++i)
+	{
+		seed[i] ^= hash[i];
+	}
+	memset(hash, 0, sizeof(hash));
+
+	r = vanitynet_send(link->conn, "unit");
+	if (r < 0)
+	{
+		error_log("Could not send to coordinator.");
+		return -1;
+	}
+	link->requested = 1;
+
+	return 1;
+}
+
+// Waits for the next line from the coordinator. An error line from it is
+// passed on.
+static int vanitycoord_expect(VanityConn conn, char *line)
+{
+	int r;
+
+	r = vanitynet_wait(conn, VANITYCOORD_WAIT);
+	if (r > 0)
+	{
+		r = vanitynet_recv(conn, line);
+	}
+	if (r <= 0)
+	{
+		error_log("Timed out.");
+		return -1;
+	}
+
+	if (strncmp(line, "error ", 6) == 0)
+	{
+		error_log("Coordinator refused worker: %s", line + 6);
+		return -1;
+	}
+
+	return 1;
+}
+
+// SHA256 of tag, nonce and secret, in that order.
+static int vanitycoord_digest(unsigned char *output, char *tag, unsigned char *nonce, char *secret)
+{
+	int r;
+	size_t tag_len, secret_len;
+	unsigned char buffer[VANITYNET_LINE_MAX + sizeof(VANITYCOORD_TAG_PROOF) + VANITYCOORD_NONCE_LENGTH + VANITYCOORD_SECRET_MAX];
+
+	tag_len = strlen(tag);
+	secret_len = strlen(secret);
+	assert(tag_len < VANITYNET_LINE_MAX + sizeof(VANITYCOORD_TAG_PROOF));
+	assert(secret_len <= VANITYCOORD_SECRET_MAX);
+
+	memcpy(buffer, tag, tag_len);
+	memcpy(buffer + tag_len, nonce, VANITYCOORD_NONCE_LENGTH);
+	memcpy(buffer + tag_len + VANITYCOORD_NONCE_LENGTH, secret, secret_len);
+
+	r = crypto_get_sha256(output, buffer, tag_len + VANITYCOORD_NONCE_LENGTH + secret_len);
+	memset(buffer, 0, sizeof(buffer));
+	if (r < 0)
+	{
+		error_log("Could not hash secret.");
+		return -1;
+	}
+
+	return 1;
+}
+
+// Milliseconds since start, on a clock that never jumps.
+static long vanitycoord_elapsed(struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return ((now.tv_sec - start->tv_sec) * 1000) + ((now.tv_nsec - start->tv_nsec) / 1000000);
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2017 Brian Barto
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GPL License. See LICENSE for more details.
+ */
+
+#ifndef VANITYCOORD_H
+#define VANITYCOORD_H 1
+
+#include <stddef.h>
+
+#define VANITYCOORD_SEED_LENGTH     32
+#define VANITYCOORD_SECRET_MAX      256
+#define VANITYCOORD_UNIT_CHUNKS     64
+
+typedef struct VanityCoord *VanityCoord;
+typedef struct VanityLink *VanityLink;
+
+// Checks a hit reported by a worker: the pattern id, the offset of the key
+// from the seed and the variant of its point. Returns 1 if it is real, 0
+// if not, and -1 if it could not be checked.
+typedef int (*VanityCoordAccept)(int, unsigned long, int);
+
+int vanitycoord_init(VanityCoord, int, int, unsigned char *, char *, char *, VanityCoordAccept);
+int vanitycoord_poll(VanityCoord, int);
+void vanitycoord_progress(VanityCoord, unsigned long *, double *, int *);
+void vanitycoord_free(VanityCoord);
+size_t vanitycoord_sizeof(void);
+int vanitycoord_join(VanityLink, char *, int, char *, char *, unsigned char *);
+int vanitycoord_next_chunk(VanityLink, unsigned long *);
+void vanitycoord_chunk_done(VanityLink, unsigned long);
+int vanitycoord_update(VanityLink, unsigned long, double, int);
+int vanitycoord_send_hit(VanityLink, int, unsigned long, int);
+void vanitycoord_release(VanityLink);
+void vanitycoord_leave(VanityLink);
+size_t vanitycoord_link_sizeof(void);
+
+#endif
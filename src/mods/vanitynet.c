@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2017 Brian Barto
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GPL License. See LICENSE for more details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <poll.h>
+#include <errno.h>
+#include <assert.h>
+#include "vanitynet.h"
+#include "error.h"
+
+#define VANITYNET_BACKLOG     16
+#define VANITYNET_BUFFER      (VANITYNET_LINE_MAX * 4)
+
+// A connection between a vanity coordinator and one of its workers. Both
+// sides send single lines of text. Received data is buffered until a full
+// line is in.
+struct VanityConn
+{
+	int sockfd;
+	char buffer[VANITYNET_BUFFER];
+	size_t len;
+};
+
+// Listens on the loopback address only, unless any is set. Workers on
+// other machines need the latter.
+int vanitynet_listen(int port, int any)
+{
+	int r, sockfd, on;
+	struct sockaddr_in serv_addr;
+
+	assert(port);
+
+	sockfd = socket(AF_INET, SOCK_STREAM, 0);
+	if (sockfd < 0)
+	{
+		error_log("Unable to create new socket. Errno %i.", errno);
+		return -1;
+	}
+
+	// Let a restarted coordinator take its port right back.
+	on = 1;
+	setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+	memset(&serv_addr, 0, sizeof(serv_addr));
+	serv_addr.sin_family = AF_INET;
+	serv_addr.sin_addr.s_addr = htonl(any ? INADDR_ANY : INADDR_LOOPBACK);
+	serv_addr.sin_port = htons(port);
+
+	r = bind(sockfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr));
+	if (r < 0)
+	{
+		error_log("Unable to bind to port %i. Errno %i.", port, errno);
+		close(sockfd);
+		return -1;
+	}
+
+	r = listen(sockfd, VANITYNET_BACKLOG);
+	if (r < 0)
+	{
+		error_log("Unable to listen on port %i. Errno %i.", port, errno);
+		close(sockfd);
+		return -1;
+	}
+
+	return sockfd;
+}
+
+void vanitynet_unlisten(int listenfd)
+{
+	assert(listenfd >= 0);
+
+	close(listenfd);
+}
+
+int vanitynet_accept(VanityConn conn, int listenfd)
+{
+	int sockfd;
+
+	assert(conn);
+	assert(listenfd >= 0);
+
+	sockfd = accept(listenfd, NULL, NULL);
+	if (sockfd < 0)
+	{
+		error_log("Unable to accept connection. Errno %i.", errno);
+		return -1;
+	}
+
+	conn->sockfd = sockfd;
+	conn->len = 0;
+
+	return 1;
+}
+
+int vanitynet_connect(VanityConn conn, const char *host, int port)
+{
+	int r, sockfd;
+	struct hostent *server;
+	struct sockaddr_in serv_addr;
+
+	assert(conn);
+	assert(host);
+	assert(port);
+
+	sockfd = socket(AF_INET, SOCK_STREAM, 0);
+	if (sockfd < 0)
+	{
+		error_log("Unable to create new socket. Errno %i.", errno);
+		return -1;
+	}
+
+	server = gethostbyname(host);
+	if (!server)
+	{
+		error_log("Unable to lookup host %s. Errno %i.", host, h_errno);
+		close(sockfd);
+		return -1;
+	}
+
+	memset(&serv_addr, 0, sizeof(serv_addr));
+	serv_addr.sin_family = AF_INET;
+	memcpy(&serv_addr.sin_addr.s_addr, server->h_addr, server->h_length);
+	serv_addr.sin_port = htons(port);
+
+	r = connect(sockfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr));
+	if (r < 0)
+	{
+		error_log("Unable to connect to host %s. Errno %i.", host, errno);
+		close(sockfd);
+		return -1;
+	}
+
+	conn->sockfd = sockfd;
+	conn->len = 0;
+
+	return 1;
+}
+
+// Sends one line. The newline is added here.
+int vanitynet_send(VanityConn conn, const char *format, ...)
+{
+	int len;
+	ssize_t r;
+	size_t sent;
+	char line[VANITYNET_LINE_MAX + 1];
+	va_list args;
+
+	assert(conn);
+	assert(format);
+
+	va_start(args, format);
+	len = vsnprintf(line, VANITYNET_LINE_MAX, format, args);
+	va_end(args);
+	if (len < 0 || len >= VANITYNET_LINE_MAX)
+	{
+		error_log("Message is too long.");
+		return -1;
+	}
+	line[len++] = '\n';
+
+	// A peer that went away must not kill us with SIGPIPE.
+	for (sent = 0; sent < (size_t)len; sent += r)
+	{
+		r = send(conn->sockfd, line + sent, len - sent, MSG_NOSIGNAL);
+		if (r < 0)
+		{
+			error_log("Unable to write to socket. Errno %i.", errno);
+			return -1;
+		}
+	}
+
+	return 1;
+}
+
+// Copies the next received line into line, without its newline. Returns 0
+// if no full line is in yet. Never blocks.
+int vanitynet_recv(VanityConn conn, char *line)
+{
+	ssize_t r;
+	char *end;
+	size_t n;
+
+	assert(conn);
+	assert(line);
+
+	end = memchr(conn->buffer, '\n', conn->len);
+	if (end == NULL)
+	{
+		r = recv(conn->sockfd, conn->buffer + conn->len, VANITYNET_BUFFER - conn->len, MSG_DONTWAIT);
+		if (r == 0)
+		{
+			error_log("Connection closed.");
+			return -1;
+		}
+		if (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+		{
+			error_log("Unable to read from socket. Errno %i.", errno);
+			return -1;
+		}
+		if (r > 0)
+		{
+			conn->len += r;
+		}
+
+		end = memchr(conn->buffer, '\n', conn->len);
+		if (end == NULL)
+		{
+			if (conn->len == VANITYNET_BUFFER)
+			{
+				error_log("Received line is too long.");
+				return -1;
+			}
+			return 0;
+		}
+	}
+
+	n = end - conn->buffer;
+	if (n > VANITYNET_LINE_MAX - 1)
+	{
+		error_log("Received line is too long.");
+		return -1;
+	}
+	memcpy(line, conn->buffer, n);
+	line[n] = '\0';
+
+	conn->len -= n + 1;
+	memmove(conn->buffer, end + 1, conn->len);
+
+	return 1;
+}
+
+// Waits up to timeout milliseconds for data to read. Returns 0 on a
+// timeout.
+int vanitynet_wait(VanityConn conn, int timeout)
+{
+	int r;
+	struct pollfd pfd;
+
+	assert(conn);
+
+	if (memchr(conn->buffer, '\n', conn->len) != NULL)
+	{
+		return 1;
+	}
+
+	pfd.fd = conn->sockfd;
+	pfd.events = POLLIN;
+	r = poll(&pfd, 1, timeout);
+	if (r < 0 && errno != EINTR)
+	{
+		error_log("Unable to poll socket. Errno %i.", errno);
+		return -1;
+	}
+
+	return (r > 0);
+}
+
+int vanitynet_fd(VanityConn conn)
+{
+	assert(conn);
+
+	return conn->sockfd;
+}
+
+void vanitynet_close(VanityConn conn)
+{
+	assert(conn);
+
+	close(conn->sockfd);
+	conn->sockfd = -1;
+	conn->len = 0;
+}
+
+size_t vanitynet_sizeof(void)
+{
+	return sizeof(struct VanityConn);
+}
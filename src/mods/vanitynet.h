@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2017 Brian Barto
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GPL License. See LICENSE for more details.
+ */
+
+#ifndef VANITYNET_H
+#define VANITYNET_H 1
+
+#include <stddef.h>
+
+#define VANITYNET_LINE_MAX    256
+
+typedef struct VanityConn *VanityConn;
+
+int vanitynet_listen(int, int);
+void vanitynet_unlisten(int);
+int vanitynet_accept(VanityConn, int);
+int vanitynet_connect(VanityConn, const char *, int);
+int vanitynet_send(VanityConn, const char *, ...);
+int vanitynet_recv(VanityConn, char *);
+int vanitynet_wait(VanityConn, int);
+int vanitynet_fd(VanityConn);
+void vanitynet_close(VanityConn);
+size_t vanitynet_sizeof(void);
+
+#endif
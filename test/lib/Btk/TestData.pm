@@ -4,7 +4,7 @@ BEGIN
 {
 	use Exporter();
 	@ISA = qw(Exporter);
-	@EXPORT_OK = qw($privkey $networks $compression $iotypes $ntests);
+	@EXPORT_OK = qw($privkey $networks $compression $iotypes $ntests $address $pubkey);
 }
 
 $iotypes = ["wif", "hex", "dec"];
@@ -76,4 +76,185 @@ $privkey = [
 	##},
 ];
 
+## Input lines, options and the expected output lines of 'btk address'.
+## Every input line gets an output line, so an empty or bad one prints
+## "invalid" in its place.
+$address = [
+	{
+		"input" => ["12UNVuALofDnkCB1rznUY7iCP3T5xeyJur"],
+		"options" => "",
+		"expected" => ["12UNVuALofDnkCB1rznUY7iCP3T5xeyJur"],
+	},
+	{
+		"input" => ["BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4"],
+		"options" => "",
+		"expected" => ["bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4"],
+	},
+	{
+		"input" => ["12UNVuALofDnkCB1rznUY7iCP3T5xeyJuR"],
+		"options" => "",
+		"expected" => ["invalid"],
+	},
+	{
+		"input" => [""],
+		"options" => "",
+		"expected" => ["invalid"],
+	},
+	{
+		"input" => ["751e76e8199196d454941c45d1b3a323f1433bd6"],
+		"options" => "-A",
+		"expected" => ["1BgGZ9tcN4rm9KBzDn7KprQz87SZ26SAMH"],
+	},
+	{
+		"input" => ["751e76e8199196d454941c45d1b3a323f1433bd6"],
+		"options" => "-B -T",
+		"expected" => ["tb1qw508d6qejxtdg4y5r3zarvary0c5xw7kxpjzsx"],
+	},
+	{
+		"input" => ["mrCDrCybB6J1vRfbwM5hemdJz73FwDBC8r"],
+		"options" => "-A -M",
+		"expected" => ["1BgGZ9tcN4rm9KBzDn7KprQz87SZ26SAMH"],
+	},
+	{
+		"input" => ["3J98t1WpEZ73CNmQviecrnyiWrnqRhWNLy"],
+		"options" => "-H",
+		"expected" => ["b472a266d0bd89c13706a4132ccfb16f7c3b9fcb"],
+	},
+	{
+		"input" => ["3J98t1WpEZ73CNmQviecrnyiWrnqRhWNLy"],
+		"options" => "-B",
+		"expected" => ["unsupported"],
+	},
+	{
+		"input" => ["bc1qrp33g0q5c5txsp9arysrx4k6zdkfs4nce4xj0gdcccefvpysxf3qccfmv3"],
+		"options" => "-H",
+		"expected" => ["1863143c14c5166804bd19203356da136c985678cd4d27a1b8c6329604903262"],
+	},
+	{
+		"input" => ["1BgGZ9tcN4rm9KBzDn7KprQz87SZ26SAMH", "", "12UNVuALofDnkCB1rznUY7iCP3T5xeyJuR", "", "3J98t1WpEZ73CNmQviecrnyiWrnqRhWNLy"],
+		"options" => "-H",
+		"expected" => ["751e76e8199196d454941c45d1b3a323f1433bd6", "invalid", "invalid", "invalid", "b472a266d0bd89c13706a4132ccfb16f7c3b9fcb"],
+	},
+];
+
+## Private keys in hex and their public keys, worked out independently of
+## btk. The small ones and n - 1 hit the edges of the curve arithmetic, and
+## the others have leading zero bytes that must survive encoding.
+$pubkey = [
+	## 1, the generator
+	{
+		"privkey" => "0000000000000000000000000000000000000000000000000000000000000001",
+		"compressed" => {
+			"hex" => "0279be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798",
+			"address" => "1BgGZ9tcN4rm9KBzDn7KprQz87SZ26SAMH",
+			"bech32" => "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4",
+		},
+		"uncompressed" => {
+			"hex" => "0479be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8",
+			"address" => "1EHNa6Q4Jz2uvNExL497mE43ikXhwF6kZm",
+		},
+	},
+	{
+		"privkey" => "0000000000000000000000000000000000000000000000000000000000000002",
+		"compressed" => {
+			"hex" => "02c6047f9441ed7d6d3045406e95c07cd85c778e4b8cef3ca7abac09b95c709ee5",
+			"address" => "1cMh228HTCiwS8ZsaakH8A8wze1JR5ZsP",
+			"bech32" => "bc1qq6hag67dl53wl99vzg42z8eyzfz2xlkvxechjp",
+		},
+		"uncompressed" => {
+			"hex" => "04c6047f9441ed7d6d3045406e95c07cd85c778e4b8cef3ca7abac09b95c709ee51ae168fea63dc339a3c58419466ceaeef7f632653266d0e1236431a950cfe52a",
+			"address" => "1LagHJk2FyCV2VzrNHVqg3gYG4TSYwDV4m",
+		},
+	},
+	{
+		"privkey" => "0000000000000000000000000000000000000000000000000000000000000003",
+		"compressed" => {
+			"hex" => "02f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9",
+			"address" => "1CUNEBjYrCn2y1SdiUMohaKUi4wpP326Lb",
+			"bech32" => "bc1q0ht9tyks4vh7p5p904t340cr9nvahy7u3re7zg",
+		},
+		"uncompressed" => {
+			"hex" => "04f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9388f7b0f632de8140fe337e62a37f3566500a99934c2231b6cb9fd7584b8e672",
+			"address" => "1NZUP3JAc9JkmbvmoTv7nVgZGtyJjirKV1",
+		},
+	},
+	## y starts with a zero byte
+	{
+		"privkey" => "000000000000000000000000000000000000000000000000000000000000007a",
+		"compressed" => {
+			"hex" => "02139ae46a1133f1f9d23f25efba0f6dd87bf7ddaf568a5fb9e0a3bfda73176237",
+			"address" => "15AJXitn6DuSC6ugSPqdsv2MxcNYdgVcbC",
+			"bech32" => "bc1q9k3wz0t2g4lmmpg98vxsrv59hr9wvmaruds6zw",
+		},
+		"uncompressed" => {
+			"hex" => "04139ae46a1133f1f9d23f25efba0f6dd87bf7ddaf568a5fb9e0a3bfda7317623700995e555c8aabd263fd238833a12188b8a5ffbeb480ba0e3e6ec481a8991472",
+			"address" => "1NwhxtuUW2dg7RPkaypDpLW9JS2dqfEzNb",
+		},
+	},
+	## x starts with a zero byte
+	{
+		"privkey" => "0000000000000000000000000000000000000000000000000000000000000099",
+		"compressed" => {
+			"hex" => "0200e3ae1974566ca06cc516d47e0fb165a674a3dabcfca15e722f0e3450f45889",
+			"address" => "12bkr6BP2pYFggCCr3XvkTSNzJRXYvZL9a",
+			"bech32" => "bc1qzx9da82ucfgndlnx9fzvwe0jj7535nmqx0h98a",
+		},
+		"uncompressed" => {
+			"hex" => "0400e3ae1974566ca06cc516d47e0fb165a674a3dabcfca15e722f0e3450f458892aeabe7e4531510116217f07bf4d07300de97e4874f81f533420a72eeb0bd6a4",
+			"address" => "1FVgHxdCE4sjHoNTVmoygXRWcKzdyXvGhm",
+		},
+	},
+	## compressed hash160 starts with a zero byte
+	{
+		"privkey" => "00000000000000000000000000000000000000000000000000000000000000b6",
+		"compressed" => {
+			"hex" => "02a076cacf92cc467c94ed72da5b9961395dacf1a224b157559169e4ea2b19a602",
+			"address" => "1162gvy7qz6rLdj3zeegPCjY7Lu6wez6Hv",
+			"bech32" => "bc1qqreh6spunfyg43yvx4880jmhp2xtcku9g8h8v7",
+		},
+		"uncompressed" => {
+			"hex" => "04a076cacf92cc467c94ed72da5b9961395dacf1a224b157559169e4ea2b19a602a213cbd11f2c882d043e203fe3b8c42210770ad296a01ad0449d42ee37e65fa4",
+			"address" => "1cpububPgSWbenNoTp7EXivFarQdHy89c",
+		},
+	},
+	## uncompressed hash160 starts with a zero byte
+	{
+		"privkey" => "000000000000000000000000000000000000000000000000000000000000019b",
+		"compressed" => {
+			"hex" => "026332731167bed8af68a063ef22aa489cf6563620461af26a5f1a07cb6b42f3a6",
+			"address" => "1Jcg4HXsiokqd4Wdwka2d8itrYyN9xiVTu",
+			"bech32" => "bc1qcyu5est5n0sqkh9f5zanj0p98rdemezmtp87mt",
+		},
+		"uncompressed" => {
+			"hex" => "046332731167bed8af68a063ef22aa489cf6563620461af26a5f1a07cb6b42f3a6b8f7c3b220701320f20ca036761d3e56bf94a7009a919f1a3ea0cb81b74424a6",
+			"address" => "11HWBme5fYis2SZ5PXLL5qEj9L3vxUVtZ",
+		},
+	},
+	## n - 1, the negated generator
+	{
+		"privkey" => "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364140",
+		"compressed" => {
+			"hex" => "0379be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798",
+			"address" => "1GrLCmVQXoyJXaPJQdqssNqwxvha1eUo2E",
+			"bech32" => "bc1q4h0ycu78h88wzldxc7e79vhw5xsde0n8jk4wl5",
+		},
+		"uncompressed" => {
+			"hex" => "0479be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798b7c52588d95c3b9aa25b0403f1eef75702e84bb7597aabe663b82f6f04ef2777",
+			"address" => "1JPbzbsAx1HyaDQoLMapWGoqf9pD5uha5m",
+		},
+	},
+	{
+		"privkey" => "9931b2d9a562a8cb9d20671d77e126c61759be440376af5a5eac270cefa75a07",
+		"compressed" => {
+			"hex" => "03d1deeb5bf943f572b0c521e1acb0b03cf963e14df66cfb82408829c21b79dffa",
+			"address" => "1NrNdWYGQNTSaT63KwaXduhmVjT5zY1S3J",
+			"bech32" => "bc1qa7c3gd44w2g09qnq7mez5w5avlwpnc42rxvw98",
+		},
+		"uncompressed" => {
+			"hex" => "04d1deeb5bf943f572b0c521e1acb0b03cf963e14df66cfb82408829c21b79dffa900bfe24c12a2b53b850c1b1a04279e359db6d5e2da9b5fe6f03a83eb920edef",
+			"address" => "1AdEnZDxRyk87gachSGdwJv5utmcbgrYUG",
+		},
+	},
+];
+
 return 1;
\ No newline at end of file
@@ -0,0 +1,343 @@
+/*
+ * Copyright (c) 2017 Brian Barto
+ * 
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GPL License. See LICENSE for more details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mods/crypto.h"
+#include "mods/sha256.h"
+#include "mods/rmd160.h"
+#include "mods/hex.h"
+#include "mods/field.h"
+
+// Longest message hashed here, not counting the million 'a' ones.
+#define TEST_MESSAGE_MAX      128
+#define TEST_BATCH            13
+#define TEST_MILLION          1000000
+
+// A message and its digest in hex. A message of NULL stands for len
+// repetitions of the letter 'a'.
+struct TestVector
+{
+	char *message;
+	size_t len;
+	char *digest;
+};
+
+// FIPS 180-2 appendix B, and the padding boundaries around one block:
+// 55 bytes still take one block, 56 need a second one, and 64 fill the
+// first exactly.
+static struct TestVector sha256_vectors[] = {
+	{"", 0, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+	{"abc", 3, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+	{"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 56, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+	{"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu", 112, "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1"},
+	{NULL, TEST_MILLION, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"},
+	{NULL, 55, "9f4390f8d30c2dd92ec9f095b65e2b9ae9b0a925a5258e241c9f1e910f734318"},
+	{NULL, 56, "b35439a4ac6f0948b6d6f9e3c6af0f5f590ce20f1bde7090ef7970686ec6738a"},
+	{NULL, 63, "7d3e74a05d7db15bce4ad9ec0658ea98e3f06eeecf16b4c6fff2da457ddc2f34"},
+	{NULL, 64, "ffe054fe7ae0cb6dc65c3af9b61d5209f439851db43d0ba5997337df154668eb"},
+	{NULL, 65, "635361c48bb9eab14198e76ea8ab7f1a41685d6ad62aa9146d301d4f17eb0ae0"},
+	{NULL, 119, "31eba51c313a5c08226adf18d4a359cfdfd8d2e816b13f4af952f7ea6584dcfb"},
+	{NULL, 120, "2f3d335432c70b580af0e8e1b3674a7c020d683aa5f73aaaedfdc55af904c21c"},
+};
+
+// The test vectors of the RIPEMD-160 paper, and the same boundaries.
+static struct TestVector rmd160_vectors[] = {
+	{"", 0, "9c1185a5c5e9fc54612808977ee8f548b2258d31"},
+	{"a", 1, "0bdc9d2d256b3ee9daae347be6f4dc835a467ffe"},
+	{"abc", 3, "8eb208f7e05d987a9b044a8e98c6b087f15a0bfc"},
+	{"message digest", 14, "5d0689ef49d2fae572b881b123a85ffa21595f36"},
+	{"abcdefghijklmnopqrstuvwxyz", 26, "f71c27109c692c1b56bbdceb5b9d2865b3708dbc"},
+	{"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 56, "12a053384a9c0c88e405a06c27dcf49ada62eb2b"},
+	{"12345678901234567890123456789012345678901234567890123456789012345678901234567890", 80, "9b752e45573d4b39f4dbd3323cab82bf63326bfb"},
+	{NULL, TEST_MILLION, "52783243c1697bdbe16d37f97f68f08325dc1528"},
+	{NULL, 55, "0d8a8c9063a48576a7c97e9f95253a6e53ff6765"},
+	{NULL, 56, "e72334b46c83cc70bef979e15453706c95b888be"},
+	{NULL, 63, "e640041293fe663b9bf3f8c21ffecac03819e6b2"},
+	{NULL, 64, "9dfb7d374ad924f3f88de96291c33e9abed53e32"},
+	{NULL, 65, "99724bb11811e7166af38f671b6a082d8ab4960b"},
+	{NULL, 119, "23e398ff2bac815aa1bbb57ca2a669c841872919"},
+	{NULL, 120, "c476770a6dae31fcee8d25efe6559a05c8024595"},
+};
+
+// Message lengths for the batch tests: public keys, hashes and the
+// boundaries.
+static size_t batch_lengths[] = {0, 20, 32, 33, 55, 56, 64, 65, 119, 120};
+
+// Field elements in hex, and the result of an operation on them. Unary
+// operations have no b.
+struct FieldVector
+{
+	char *a;
+	char *b;
+	char *result;
+};
+
+// Products that need a full reduction, around p - 1 and 2^255, and of the
+// generator coordinates.
+static struct FieldVector field_mul_vectors[] = {
+	{"0000000000000000000000000000000000000000000000000000000000000000", "79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798", "0000000000000000000000000000000000000000000000000000000000000000"},
+	{"0000000000000000000000000000000000000000000000000000000000000001", "79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798", "79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798"},
+	{"fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2e", "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2e", "0000000000000000000000000000000000000000000000000000000000000001"},
+	{"fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2e", "0000000000000000000000000000000000000000000000000000000000000002", "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2d"},
+	{"79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798", "483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8", "fd3dc529c6eb60fb9d166034cf3c1a5a72324aa9dfd3428a56d7e1ce0179fd9b"},
+	{"8000000000000000000000000000000000000000000000000000000000000000", "8000000000000000000000000000000000000000000000000000000000000000", "400000000000000000000000000000000000000000000000400001e84003a334"},
+	{"fffffffffffffffffffffffffffffffffffffffffffffffffffffffdfffffc2f", "fffffffffffffffffffffffffffffffffffffffffffffffefffffffefffffc2f", "0000000000000000000000000000000000000001000000000000000000000000"},
+	{"00000000000000000000000000000000000000000000000000000001000003d0", "483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8", "8704aaa8ae01be711311b99e9e08b88d90e4a914789872341516d642d8cad72a"},
+};
+
+// Inverses, a^(p - 2).
+static struct FieldVector field_inv_vectors[] = {
+	{"0000000000000000000000000000000000000000000000000000000000000001", NULL, "0000000000000000000000000000000000000000000000000000000000000001"},
+	{"0000000000000000000000000000000000000000000000000000000000000002", NULL, "7fffffffffffffffffffffffffffffffffffffffffffffffffffffff7ffffe18"},
+	{"0000000000000000000000000000000000000000000000000000000000000003", NULL, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa9fffffd75"},
+	{"fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2e", NULL, "fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2e"},
+	{"79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798", NULL, "237afdf1d2938d86870aaeb8ad77626a67b8e794abfb076be61d003687ca9ef6"},
+	{"483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8", NULL, "6fc6340c9dae9a629bcf20238be148d582aac046a7b87a681f7d5dda2ecf511d"},
+	{"8000000000000000000000000000000000000000000000000000000000000000", NULL, "937a320a2aa70733388d85852be56ec3796447fdb84940b3b070123b10d03625"},
+};
+
+// Square roots, a^((p + 1) / 4). The root of the generator's y squared is
+// its y again. p - 1 and 7 have no root, so their result squares to -a.
+static struct FieldVector field_sqrt_vectors[] = {
+	{"0000000000000000000000000000000000000000000000000000000000000000", NULL, "0000000000000000000000000000000000000000000000000000000000000000"},
+	{"0000000000000000000000000000000000000000000000000000000000000001", NULL, "0000000000000000000000000000000000000000000000000000000000000001"},
+	{"0000000000000000000000000000000000000000000000000000000000000004", NULL, "0000000000000000000000000000000000000000000000000000000000000002"},
+	{"fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2e", NULL, "0000000000000000000000000000000000000000000000000000000000000001"},
+	{"4866d6a5ab41ab2c6bcc57ccd3735da5f16f80a548e5e20a44e4e9b8118c26f2", NULL, "483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8"},
+	{"79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798", NULL, "cb6dfbd6cdf31164bbeb3052460c1fa3f827f01d6e7fb5f69580cfb96560c16a"},
+	{"0000000000000000000000000000000000000000000000000000000000000007", NULL, "8f537eefdfc1606a0727cd69b4a7333d38ed44e3932a7179eecb4b6fba9360dc"},
+};
+
+static int failed = 0;
+
+static void test_result(char *, size_t, int);
+static unsigned char *test_message(struct TestVector *);
+static void test_sha256(struct TestVector *);
+static void test_rmd160(struct TestVector *);
+static void test_batch(size_t);
+static void test_field_result(char *, size_t, Field, char *);
+static void test_field_set(Field, char *);
+static void test_field_mul(struct FieldVector *, size_t);
+static void test_field_unary(char *, void (*)(Field, Field), struct FieldVector *, size_t);
+
+int main(void)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(sha256_vectors) / sizeof(*sha256_vectors); ++i)
+	{
+		test_sha256(&sha256_vectors[i]);
+	}
+
+	for (i = 0; i < sizeof(rmd160_vectors) / sizeof(*rmd160_vectors); ++i)
+	{
+		test_rmd160(&rmd160_vectors[i]);
+	}
+
+	for (i = 0; i < sizeof(batch_lengths) / sizeof(*batch_lengths); ++i)
+	{
+		test_batch(batch_lengths[i]);
+	}
+
+	for (i = 0; i < sizeof(field_mul_vectors) / sizeof(*field_mul_vectors); ++i)
+	{
+		test_field_mul(&field_mul_vectors[i], i);
+	}
+
+	for (i = 0; i < sizeof(field_inv_vectors) / sizeof(*field_inv_vectors); ++i)
+	{
+		test_field_unary("field_inv", field_inv, &field_inv_vectors[i], i);
+	}
+
+	for (i = 0; i < sizeof(field_sqrt_vectors) / sizeof(*field_sqrt_vectors); ++i)
+	{
+		test_field_unary("field_sqrt", field_sqrt, &field_sqrt_vectors[i], i);
+	}
+
+	return failed ? 1 : 0;
+}
+
+static void test_result(char *name, size_t len, int passed)
+{
+	printf("%s %zu bytes : %s\n", name, len, passed ? "PASSED" : "FAILED");
+	if (!passed)
+	{
+		failed = 1;
+	}
+}
+
+static unsigned char *test_message(struct TestVector *vector)
+{
+	unsigned char *message;
+
+	message = malloc(vector->len + 1);
+	if (message == NULL)
+	{
+		fprintf(stderr, "Memory allocation error.\n");
+		exit(1);
+	}
+
+	if (vector->message == NULL)
+	{
+		memset(message, 'a', vector->len);
+	}
+	else
+	{
+		memcpy(message, vector->message, vector->len);
+	}
+
+	return message;
+}
+
+// Hashes the message in one piece, and again fed in uneven parts, so the
+// incremental hash has to carry partial blocks over.
+static void test_sha256(struct TestVector *vector)
+{
+	size_t i, n;
+	unsigned char *message;
+	unsigned char digest[SHA256_LENGTH];
+	char hex[SHA256_LENGTH * 2 + 1];
+	struct Sha256 ctx;
+
+	message = test_message(vector);
+
+	sha256_hash(digest, message, vector->len);
+	hex_encode(hex, digest, SHA256_LENGTH);
+	test_result("sha256", vector->len, strcmp(hex, vector->digest) == 0);
+
+	sha256_init(&ctx);
+	for (i = 0, n = 1; i < vector->len; i += n, n = (n * 3) % 71 + 1)
+	{
+		sha256_update(&ctx, message + i, (i + n > vector->len) ? vector->len - i : n);
+	}
+	sha256_final(digest, &ctx);
+	hex_encode(hex, digest, SHA256_LENGTH);
+	test_result("sha256 incremental", vector->len, strcmp(hex, vector->digest) == 0);
+
+	free(message);
+}
+
+static void test_rmd160(struct TestVector *vector)
+{
+	unsigned char *message;
+	unsigned char digest[RMD160_LENGTH];
+	char hex[RMD160_LENGTH * 2 + 1];
+
+	message = test_message(vector);
+
+	rmd160_hash(digest, message, vector->len);
+	hex_encode(hex, digest, RMD160_LENGTH);
+	test_result("rmd160", vector->len, strcmp(hex, vector->digest) == 0);
+
+	free(message);
+}
+
+// Hashes TEST_BATCH different messages of len bytes in a batch. That is one
+// full set of lanes and a few left over, which must all match hashing each
+// message on its own.
+static void test_batch(size_t len)
+{
+	int passed;
+	size_t i;
+	unsigned char input[TEST_BATCH * TEST_MESSAGE_MAX];
+	unsigned char single[TEST_BATCH * SHA256_LENGTH];
+	unsigned char batch[TEST_BATCH * SHA256_LENGTH];
+
+	for (i = 0; i < TEST_BATCH * len; ++i)
+	{
+		input[i] = (unsigned char)(i * 131 + 7);
+	}
+
+	for (i = 0; i < TEST_BATCH; ++i)
+	{
+		sha256_hash(single + (i * SHA256_LENGTH), input + (i * len), len);
+	}
+	sha256_hash_batch(batch, input, len, TEST_BATCH);
+	test_result("sha256 batch", len, memcmp(single, batch, TEST_BATCH * SHA256_LENGTH) == 0);
+
+	for (i = 0; i < TEST_BATCH; ++i)
+	{
+		rmd160_hash(single + (i * RMD160_LENGTH), input + (i * len), len);
+	}
+	rmd160_hash_batch(batch, input, len, TEST_BATCH);
+	test_result("rmd160 batch", len, memcmp(single, batch, TEST_BATCH * RMD160_LENGTH) == 0);
+
+	// The crypto functions take no empty input.
+	if (len == 0)
+	{
+		return;
+	}
+
+	passed = 1;
+	for (i = 0; i < TEST_BATCH; ++i)
+	{
+		crypto_get_hash160(single + (i * RMD160_LENGTH), input + (i * len), len);
+	}
+	if (crypto_get_hash160_batch(batch, input, len, TEST_BATCH) < 0)
+	{
+		passed = 0;
+	}
+	test_result("hash160 batch", len, passed && memcmp(single, batch, TEST_BATCH * RMD160_LENGTH) == 0);
+}
+
+static void test_field_result(char *name, size_t i, Field result, char *expected)
+{
+	int passed;
+	unsigned char raw[FIELD_LENGTH];
+	char hex[FIELD_LENGTH * 2 + 1];
+
+	field_get_raw(raw, result);
+	hex_encode(hex, raw, FIELD_LENGTH);
+	passed = strcmp(hex, expected) == 0;
+	printf("%s vector %zu : %s\n", name, i, passed ? "PASSED" : "FAILED");
+	if (!passed)
+	{
+		failed = 1;
+	}
+}
+
+static void test_field_set(Field r, char *hex)
+{
+	unsigned char raw[FIELD_LENGTH];
+
+	if (hex_decode(raw, hex, FIELD_LENGTH * 2) < 0 || field_set_raw(r, raw) < 0)
+	{
+		fprintf(stderr, "Bad field test vector %s.\n", hex);
+		exit(1);
+	}
+}
+
+// Multiplies both ways round, and in place, where the product overwrites
+// an operand.
+static void test_field_mul(struct FieldVector *vector, size_t i)
+{
+	struct Field a, b, result;
+
+	test_field_set(&a, vector->a);
+	test_field_set(&b, vector->b);
+
+	field_mul(&result, &a, &b);
+	test_field_result("field_mul", i, &result, vector->result);
+
+	field_mul(&result, &b, &a);
+	test_field_result("field_mul swapped", i, &result, vector->result);
+
+	field_mul(&a, &a, &b);
+	test_field_result("field_mul in place", i, &a, vector->result);
+}
+
+static void test_field_unary(char *name, void (*op)(Field, Field), struct FieldVector *vector, size_t i)
+{
+	struct Field a, result;
+
+	test_field_set(&a, vector->a);
+
+	op(&result, &a);
+	test_field_result(name, i, &result, vector->result);
+}
@@ -1,7 +1,7 @@
 #!/usr/bin/perl
 
 use lib './test/lib';
-use Btk::TestData qw($networks $compression $iotypes $privkey $ntests);
+use Btk::TestData qw($networks $compression $iotypes $privkey $ntests $address $pubkey);
 
 my $btk_location = "bin/btk";
 
@@ -52,6 +52,46 @@ for (my $i = 0; $i < $ntests; $i++)
 	}
 }
 
+foreach my $test (@{$address})
+{
+	my $input = join("\\n", @{$test->{"input"}}) . "\\n";
+	my $expected = join("\n", @{$test->{"expected"}}) . "\n";
+	my $output = btk_get("address", $test->{"options"}, $input);
+	print join(",", @{$test->{"input"}}) . " => " . join(",", split(/\n/, $output)) . " : ";
+	if ($output eq $expected)
+	{
+		print "PASSED\n";
+	}
+	else
+	{
+		print "FAILED\n";
+	}
+}
+
+my %pubkey_outputs = ("hex" => "-H", "address" => "-A", "bech32" => "-B");
+my %pubkey_compression = ("compressed" => "-C", "uncompressed" => "-U");
+foreach my $key (@{$pubkey})
+{
+	foreach my $comp (sort keys %pubkey_compression)
+	{
+		foreach my $type (sort keys %{$key->{$comp}})
+		{
+			my $input = $key->{"privkey"};
+			my $expected = $key->{$comp}->{$type};
+			my $output = btk_get("pubkey", "-h $pubkey_outputs{$type} $pubkey_compression{$comp} -N", $input);
+			print "$input => $output : ";
+			if ($output eq $expected)
+			{
+				print "PASSED\n";
+			}
+			else
+			{
+				print "FAILED\n";
+			}
+		}
+	}
+}
+
 ##$result =  btk_privkey_get({'from' => 'wif', 'to' => 'wif', 'network' => 'main', 'compression' => 1 }, $privkey->[$i]->{"wif_c"});
 
 